@@ -1,122 +1,107 @@
 #include "DashboardDataFormat.h"
 
+/**
+ * Layout of the vision data expected by the LabVIEW Dashboard project.
+ */
+struct DASHBOARD_CLUSTER VisionData {
+	struct DASHBOARD_CLUSTER {
+		double joystickX;
+		double angle;
+		double angularRate;
+		double otherX;
+	} tracking;
+	struct DASHBOARD_CLUSTER {
+		double score;
+		struct DASHBOARD_CLUSTER {
+			double x;
+			double y;
+		} position;
+		double angle;
+		double majorRadius;
+		double minorRadius;
+		double rawScore;
+	} target;
+};
+
+/**
+ * Layout of one digital module in the I/O port data.
+ */
+struct DASHBOARD_CLUSTER DigitalModuleData {
+	UINT8 relayForward;
+	UINT8 relayReverse;
+	UINT16 dio;
+	UINT16 dioDirection;
+	UINT8 pwm[10];
+};
+
+/**
+ * Layout of the I/O port data expected by the LabVIEW Dashboard project.
+ */
+struct DASHBOARD_CLUSTER IOPortData {
+	float analog1[8];
+	float analog2[8];
+	DigitalModuleData digital1;
+	DigitalModuleData digital2;
+	UINT8 solenoids;
+};
+
 void sendVisionData() {
 	Dashboard &dash = DriverStation::GetInstance()->GetHighPriorityDashboardPacker();
-	dash.AddCluster(); // wire (2 elements)
-	{
-		dash.AddCluster(); // tracking data
-		{
-			dash.AddDouble(1.0); // Joystick X
-			dash.AddDouble(135.0); // angle
-			dash.AddDouble(3.0); // angular rate
-			dash.AddDouble(5.0); // other X
-		}
-		dash.FinalizeCluster();
-		dash.AddCluster(); // target Info (2 elements)
-		{
-			dash.AddCluster(); // targets
-			{
-				dash.AddDouble(100.0); // target score
-				dash.AddCluster(); // Circle Description (5 elements)
-				{
-					dash.AddCluster(); // Position (2 elements)
-					{
-						dash.AddDouble(30.0); // X
-						dash.AddDouble(50.0); // Y
-					}
-					dash.FinalizeCluster();
-				}
-				dash.FinalizeCluster(); // Position
-				dash.AddDouble(45.0); // Angle
-				dash.AddDouble(21.0); // Major Radius
-				dash.AddDouble(15.0); // Minor Radius
-				dash.AddDouble(324.0); // Raw score
-			}
-			dash.FinalizeCluster(); // targets
-		}
-		dash.FinalizeCluster(); // target Info
-	}
-	dash.FinalizeCluster(); // wire
+	VisionData data;
+
+	data.tracking.joystickX = 1.0;
+	data.tracking.angle = 135.0;
+	data.tracking.angularRate = 3.0;
+	data.tracking.otherX = 5.0;
+	data.target.score = 100.0;
+	data.target.position.x = 30.0;
+	data.target.position.y = 50.0;
+	data.target.angle = 45.0;
+	data.target.majorRadius = 21.0;
+	data.target.minorRadius = 15.0;
+	data.target.rawScore = 324.0;
+
+	dash.Pack(data);
 	dash.Finalize();
 }
 
 void sendIOPortData() {
 	Dashboard &dash = DriverStation::GetInstance()->GetLowPriorityDashboardPacker();
-	dash.AddCluster();
-	{
-		dash.AddCluster();
-		{ //analog modules 
-			dash.AddCluster();
-			{
-				for (int i = 1; i <= 8; i++) {
-					//					dash.AddFloat((float) AnalogModule::GetInstance(1)->GetAverageVoltage(i));
-					dash.AddFloat((float) i * 5.0 / 8.0);
-				}
-			}
-			dash.FinalizeCluster();
-			dash.AddCluster();
-			{
-				for (int i = 1; i <= 8; i++) {
-					dash.AddFloat((float) AnalogModule::GetInstance(2)->GetAverageVoltage(i));
-				}
-			}
-			dash.FinalizeCluster();
-		}
-		dash.FinalizeCluster();
+	IOPortData data;
 
-		dash.AddCluster();
-		{ //digital modules
-			dash.AddCluster();
-			{
-				dash.AddCluster();
-				{
-					int module = 4;
-					dash.AddU8(DigitalModule::GetInstance(module)->GetRelayForward());
-					dash.AddU8(DigitalModule::GetInstance(module)->GetRelayReverse());
-					//					dash.AddU16((short)DigitalModule::GetInstance(module)->GetDIO());
-					dash.AddU16((short) 0xAAAA);
-					//					dash.AddU16((short)DigitalModule::GetInstance(module)->GetDIODirection());
-					dash.AddU16((short) 0x7777);
-					dash.AddCluster();
-					{
-						for (int i = 1; i <= 10; i++) {
-							//							dash.AddU8((unsigned char) DigitalModule::GetInstance(module)->GetPWM(i));
-							dash.AddU8((unsigned char) (i-1) * 255 / 9);
-						}
-					}
-					dash.FinalizeCluster();
-				}
-				dash.FinalizeCluster();
-			}
-			dash.FinalizeCluster();
+	//analog modules
+	for (int i = 1; i <= 8; i++) {
+		//		data.analog1[i-1] = (float) AnalogModule::GetInstance(1)->GetAverageVoltage(i);
+		data.analog1[i-1] = (float) i * 5.0 / 8.0;
+		data.analog2[i-1] = (float) AnalogModule::GetInstance(2)->GetAverageVoltage(i);
+	}
 
-			dash.AddCluster();
-			{
-				dash.AddCluster();
-				{
-					int module = 6;
-					dash.AddU8(DigitalModule::GetInstance(module)->GetRelayForward());
-					dash.AddU8(DigitalModule::GetInstance(module)->GetRelayForward());
-					dash.AddU16((short)DigitalModule::GetInstance(module)->GetDIO());
-					dash.AddU16(DigitalModule::GetInstance(module)->GetDIODirection());
-					dash.AddCluster();
-					{
-						for (int i = 1; i <= 10; i++) {
-							//							dash.AddU8((unsigned char) DigitalModule::GetInstance(module)->GetPWM(i));
-							dash.AddU8((unsigned char) i * 255 / 10);
-						}
-					}
-					dash.FinalizeCluster();
-				}
-				dash.FinalizeCluster();
-			}
-			dash.FinalizeCluster();
-		}
-		dash.FinalizeCluster();
+	//digital modules
+	int module = 4;
+	data.digital1.relayForward = DigitalModule::GetInstance(module)->GetRelayForward();
+	data.digital1.relayReverse = DigitalModule::GetInstance(module)->GetRelayReverse();
+	//	data.digital1.dio = DigitalModule::GetInstance(module)->GetDIO();
+	data.digital1.dio = 0xAAAA;
+	//	data.digital1.dioDirection = DigitalModule::GetInstance(module)->GetDIODirection();
+	data.digital1.dioDirection = 0x7777;
+	for (int i = 1; i <= 10; i++) {
+		//		data.digital1.pwm[i-1] = (unsigned char) DigitalModule::GetInstance(module)->GetPWM(i);
+		data.digital1.pwm[i-1] = (unsigned char) (i-1) * 255 / 9;
+	}
 
-		// Can't read solenoids without an instance of the object
-		dash.AddU8((char) 0);
+	module = 6;
+	data.digital2.relayForward = DigitalModule::GetInstance(module)->GetRelayForward();
+	data.digital2.relayReverse = DigitalModule::GetInstance(module)->GetRelayForward();
+	data.digital2.dio = DigitalModule::GetInstance(module)->GetDIO();
+	data.digital2.dioDirection = DigitalModule::GetInstance(module)->GetDIODirection();
+	for (int i = 1; i <= 10; i++) {
+		//		data.digital2.pwm[i-1] = (unsigned char) DigitalModule::GetInstance(module)->GetPWM(i);
+		data.digital2.pwm[i-1] = (unsigned char) i * 255 / 10;
 	}
-	dash.FinalizeCluster();
+
+	// Can't read solenoids without an instance of the object
+	data.solenoids = 0;
+
+	dash.Pack(data);
 	dash.Finalize();
 }
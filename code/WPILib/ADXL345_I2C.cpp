@@ -91,3 +91,41 @@ ADXL345_I2C::AllAxes ADXL345_I2C::GetAccelerations()
 	return data;
 }
 
+/**
+ * Start reading the acceleration of all axes without waiting for the bus.
+ * 
+ * Use GetAccelerations(request) to get the result once the request completes.
+ * 
+ * @param request The request to use. It must not be pending.
+ * @param completion The function to call when the read completes, or NULL.
+ * @param param The parameter to pass to the completion function.
+ * @return False if the read was queued, true if it was rejected.
+ */
+bool ADXL345_I2C::StartGetAccelerations(I2CRequest *request, I2CCompletionFunction completion, void *param)
+{
+	if (m_i2c == NULL)
+	{
+		return true;
+	}
+	return m_i2c->StartRead(request, kDataRegister, 3 * sizeof(INT16), completion, param);
+}
+
+/**
+ * Get the acceleration of all axes in Gs from a completed read.
+ * 
+ * @param request A request started by StartGetAccelerations() that has completed.
+ * @return Acceleration measured on all axes of the ADXL345 in Gs.
+ */
+ADXL345_I2C::AllAxes ADXL345_I2C::GetAccelerations(I2CRequest *request)
+{
+	AllAxes data = {0.0};
+	if (!request->IsAborted())
+	{
+		// Sensor is little endian
+		const UINT8 *rawData = request->GetDataReceived();
+		data.XAxis = (INT16)(rawData[0] | (rawData[1] << 8)) * kGsPerLSB;
+		data.YAxis = (INT16)(rawData[2] | (rawData[3] << 8)) * kGsPerLSB;
+		data.ZAxis = (INT16)(rawData[4] | (rawData[5] << 8)) * kGsPerLSB;
+	}
+	return data;
+}
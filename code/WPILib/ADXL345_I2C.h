@@ -8,8 +8,7 @@
 #define __ADXL345_I2C_h__
 
 #include "SensorBase.h"
-
-class I2C;
+#include "I2C.h"
 
 /**
  * ADXL345 Accelerometer on I2C.
@@ -44,6 +43,8 @@ public:
 	virtual ~ADXL345_I2C();
 	virtual double GetAcceleration(Axes axis);
 	virtual AllAxes GetAccelerations();
+	bool StartGetAccelerations(I2CRequest *request, I2CCompletionFunction completion = NULL, void *param = NULL);
+	static AllAxes GetAccelerations(I2CRequest *request);
 
 protected:
 	I2C* m_i2c;
@@ -6,6 +6,7 @@
 
 #include "AnalogChannel.h"
 #include "AnalogModule.h"
+#include "DMA.h"
 #include "Resource.h"
 #include "Utility.h"
 #include "WPIStatus.h"
@@ -384,3 +385,52 @@ double AnalogChannel::PIDGet()
 {
 	return GetAverageValue();
 }
+
+/**
+ * Get a sample straight from this channel as captured in a DMA sample.
+ * The channel must have been added to the DMA object with DMA::AddAnalogInput().
+ * 
+ * @param sample The DMA sample.
+ * @return The raw value when the sample was captured.
+ */
+INT16 AnalogChannel::GetValue(DMASample *sample)
+{
+	return sample->GetAnalogValue(AnalogModule::SlotToIndex(m_module->GetSlot()), m_channel);
+}
+
+/**
+ * Get a sample from the oversample and average engine as captured in a DMA sample.
+ * The channel must have been added to the DMA object with DMA::AddAveragedAnalogInput().
+ * 
+ * @param sample The DMA sample.
+ * @return The averaged value when the sample was captured.
+ */
+INT32 AnalogChannel::GetAverageValue(DMASample *sample)
+{
+	return sample->GetAverageValue(AnalogModule::SlotToIndex(m_module->GetSlot()), m_channel);
+}
+
+/**
+ * Read the accumulated value and the number of accumulated values as captured in a DMA sample.
+ * The channel must have been added to the DMA object with DMA::AddAccumulator().
+ * 
+ * @param sample The DMA sample.
+ * @param value Pointer to the 64-bit accumulated output.
+ * @param count Pointer to the number of accumulation cycles.
+ */
+void AnalogChannel::GetAccumulatorOutput(DMASample *sample, INT64 *value, UINT32 *count)
+{
+	if (m_accumulator == NULL)
+	{
+		wpi_fatal(NullParameter);
+		return;
+	}
+	if (value == NULL || count == NULL)
+	{
+		wpi_fatal(NullParameter);
+		return;
+	}
+
+	sample->GetAccumulatorOutput(m_channel == kAccumulatorChannels[0] ? 0 : 1, value, count);
+	*value += m_accumulatorOffset;
+}
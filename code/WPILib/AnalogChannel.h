@@ -11,6 +11,7 @@
 #include "PIDSource.h"
 
 class AnalogModule;
+class DMASample;
 
 /**
  * Analog channel class.
@@ -63,6 +64,10 @@ public:
 	INT64 GetAccumulatorValue();
 	UINT32 GetAccumulatorCount();
 	void GetAccumulatorOutput(INT64 *value, UINT32 *count);
+
+	INT16 GetValue(DMASample *sample);
+	INT32 GetAverageValue(DMASample *sample);
+	void GetAccumulatorOutput(DMASample *sample, INT64 *value, UINT32 *count);
 	
 	double PIDGet();
 
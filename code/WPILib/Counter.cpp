@@ -5,6 +5,7 @@
 /*----------------------------------------------------------------------------*/
 
 #include "Counter.h"
+#include "DMA.h"
 #include "AnalogTrigger.h"
 #include "DigitalInput.h"
 #include "Resource.h"
@@ -429,6 +430,18 @@ INT32 Counter::Get()
 	return value;
 }
 
+/**
+ * Read the value as captured in a DMA sample.
+ * The counter must have been added to the DMA object that captured the sample.
+ * 
+ * @param sample The DMA sample.
+ * @return The count when the sample was captured.
+ */
+INT32 Counter::Get(DMASample *sample)
+{
+	return sample->GetCounterValue(m_index);
+}
+
 /**
  * Reset the Counter to zero.
  * Set the counter value to zero. This doesn't effect the running state of the counter, just sets
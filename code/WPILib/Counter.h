@@ -11,6 +11,8 @@
 #include "CounterBase.h"
 #include "SensorBase.h"
 
+class DMASample;
+
 /**
  * Class for counting the number of ticks on a digital input channel.
  * This is a general purpose class for counting repetitive events. It can return the number
@@ -19,6 +21,7 @@
  */
 class Counter : public SensorBase, public CounterBase
 {
+	friend class DMA;
 public:
 	typedef enum {kTwoPulse=0, kSemiperiod=1, kPulseLength=2, kExternalDirection=3} Mode;
 
@@ -60,6 +63,7 @@ public:
 	// CounterBase interface
 	void Start();
 	INT32 Get();
+	INT32 Get(DMASample *sample);
 	void Reset();
 	void Stop();
 	double GetPeriod();
@@ -0,0 +1,558 @@
+/*----------------------------------------------------------------------------*/
+/* Copyright (c) FIRST 2008. All Rights Reserved.							  */
+/* Open Source Software - may be modified and shared by FRC teams. The code   */
+/* must be accompanied by the FIRST BSD license file in $(WIND_BASE)/WPILib.  */
+/*----------------------------------------------------------------------------*/
+
+#include "DMA.h"
+
+#include "AnalogChannel.h"
+#include "AnalogModule.h"
+#include "Counter.h"
+#include "DigitalInput.h"
+#include "DigitalModule.h"
+#include "Encoder.h"
+#include "Gyro.h"
+#include "Utility.h"
+#include "WPIStatus.h"
+
+// The FPGA image has a single DMA channel.
+static const UINT32 kDMAChannel = 0;
+// Status returned by the DMA manager when a read times out.
+static const tRioStatusCode kDMAReadTimeout = -50400;
+
+const UINT32 DMASample::kMaxSize;
+
+/**
+ * Number of 32 bit words each group adds to a sample.
+ *
+ * Raw analog values are packed two channels per word, averaged values, counters and
+ * encoders take one word per channel, an accumulator is its 64 bit value followed by
+ * its count, and the digital inputs of both modules share one word.
+ */
+const UINT32 DMA::kGroupSize[kDMA_NumGroups] =
+{
+	2, 2, 4, 4,		// AI0
+	2, 2, 4, 4,		// AI1
+	3, 3,			// Accumulators
+	1,				// DI
+	1,				// Analog triggers
+	4, 4, 4, 4,		// Counters and counter timers
+	4, 4			// Encoders and encoder timers
+};
+
+bool DMA::m_allocated = false;
+
+/**
+ * Create an empty sample.
+ */
+DMASample::DMASample()
+	: m_size (0)
+{
+	for (UINT32 i = 0; i < kDMA_NumGroups; i++)
+	{
+		m_offsets[i] = -1;
+	}
+}
+
+/**
+ * Get a word of a group from the sample.
+ *
+ * @return The word, or 0 if the group was not captured.
+ */
+UINT32 DMASample::GetWord(DMAGroup group, UINT32 word)
+{
+	if (m_offsets[group] < 0)
+	{
+		wpi_fatal(DMAGroupNotCaptured);
+		return 0;
+	}
+	return m_buffer[m_offsets[group] + word];
+}
+
+/**
+ * Get the time the sample was captured.
+ *
+ * @return The FPGA time in microseconds.
+ */
+UINT32 DMASample::GetTimestamp()
+{
+	return (m_size > 0) ? m_buffer[m_size - 1] : 0;
+}
+
+/**
+ * Get the time the sample was captured.
+ *
+ * @return The FPGA time in seconds.
+ */
+double DMASample::GetTime()
+{
+	return GetTimestamp() * 1.0e-6;
+}
+
+/**
+ * Check if a group is part of the sample.
+ *
+ * @param group The sensor group.
+ * @return True if the group was captured.
+ */
+bool DMASample::IsCaptured(DMAGroup group)
+{
+	return m_offsets[group] >= 0;
+}
+
+/**
+ * Get the count of an FPGA quadrature encoder.
+ *
+ * @param index The FPGA encoder index. [0..3]
+ * @return The raw count.
+ */
+INT32 DMASample::GetEncoderValue(UINT32 index)
+{
+	tEncoder::tOutput output;
+	output.value = GetWord(kDMA_Encoders, index);
+	return output.Value;
+}
+
+/**
+ * Get the count of an FPGA counter.
+ *
+ * @param index The FPGA counter index. [0..7]
+ * @return The raw count.
+ */
+INT32 DMASample::GetCounterValue(UINT32 index)
+{
+	tCounter::tOutput output;
+	output.value = GetWord(index < 4 ? kDMA_Counters_Low : kDMA_Counters_High, index % 4);
+	return output.Value;
+}
+
+/**
+ * Get a raw analog value.
+ *
+ * @param moduleIndex The analog module index. [0..1]
+ * @param channel The analog channel. [1..8]
+ * @return The raw value.
+ */
+INT16 DMASample::GetAnalogValue(UINT32 moduleIndex, UINT32 channel)
+{
+	UINT32 i = (channel - 1) % 4;
+	DMAGroup group = (DMAGroup)(kDMA_AI0_Low + moduleIndex * 4 + (channel > 4 ? 1 : 0));
+	UINT32 word = GetWord(group, i / 2);
+	return (i % 2 == 0) ? (INT16)(word >> 16) : (INT16)(word & 0xFFFF);
+}
+
+/**
+ * Get an oversampled and averaged analog value.
+ *
+ * @param moduleIndex The analog module index. [0..1]
+ * @param channel The analog channel. [1..8]
+ * @return The averaged value.
+ */
+INT32 DMASample::GetAverageValue(UINT32 moduleIndex, UINT32 channel)
+{
+	DMAGroup group = (DMAGroup)(kDMA_AIAveraged0_Low + moduleIndex * 4 + (channel > 4 ? 1 : 0));
+	return (INT32)GetWord(group, (channel - 1) % 4);
+}
+
+/**
+ * Get the raw output of an accumulator.
+ *
+ * @param index The accumulator index. [0..1]
+ * @param value Receives the accumulated value.
+ * @param count Receives the number of accumulated samples.
+ */
+void DMASample::GetAccumulatorOutput(UINT32 index, INT64 *value, UINT32 *count)
+{
+	DMAGroup group = index == 0 ? kDMA_Accumulator0 : kDMA_Accumulator1;
+	*value = ((INT64)GetWord(group, 0) << 32) | GetWord(group, 1);
+	*count = GetWord(group, 2);
+}
+
+/**
+ * Get the digital inputs of a digital module.
+ *
+ * @param moduleIndex The digital module index. [0..1]
+ * @return The inputs, one bit per FPGA channel.
+ */
+UINT16 DMASample::GetDigitalInputs(UINT32 moduleIndex)
+{
+	UINT32 word = GetWord(kDMA_DI, 0);
+	return (UINT16)(moduleIndex == 0 ? word & 0xFFFF : word >> 16);
+}
+
+/**
+ * Create the DMA object.
+ *
+ * No sensors are selected and DMA is not running.
+ */
+DMA::DMA()
+	: m_dma (NULL)
+	, m_manager (NULL)
+	, m_sampleSize (1)
+	, m_readBuffer (NULL)
+	, m_readBufferSize (0)
+{
+	if (m_allocated)
+	{
+		wpi_fatal(ResourceAlreadyAllocated);
+		return;
+	}
+	m_allocated = true;
+
+	for (UINT32 i = 0; i < kDMA_NumGroups; i++)
+	{
+		m_offsets[i] = -1;
+	}
+	m_dma = new tDMA(&status);
+	m_config.value = 0;
+	m_config.Pause = 1;
+	m_dma->writeConfig(m_config, &status);
+	wpi_assertCleanStatus(status);
+}
+
+/**
+ * Stop DMA and free the resources.
+ */
+DMA::~DMA()
+{
+	if (m_dma == NULL)
+	{
+		return;
+	}
+	Stop();
+	delete m_dma;
+	m_dma = NULL;
+	m_allocated = false;
+}
+
+/**
+ * Pause or resume capturing samples.
+ *
+ * @param pause True to stop capturing samples without stopping DMA.
+ */
+void DMA::SetPause(bool pause)
+{
+	m_config.Pause = pause;
+	m_dma->writeConfig_Pause(pause, &status);
+	wpi_assertCleanStatus(status);
+}
+
+/**
+ * Set how often a sample is captured.
+ *
+ * @param cycles Capture a sample every this many cycles of the FPGA loop.
+ */
+void DMA::SetRate(UINT32 cycles)
+{
+	if (cycles < 1)
+	{
+		wpi_fatal(ParameterOutOfRange);
+		return;
+	}
+	m_dma->writeRate(cycles, &status);
+	wpi_assertCleanStatus(status);
+}
+
+/**
+ * Enable capturing a group and recalculate the sample layout.
+ */
+void DMA::EnableGroup(DMAGroup group)
+{
+	if (m_manager != NULL)
+	{
+		wpi_fatal(DMAConfigWhileRunning);
+		return;
+	}
+	if (m_offsets[group] >= 0)
+	{
+		return;
+	}
+
+	switch (group)
+	{
+	case kDMA_AI0_Low: m_config.Enable_AI0_Low = 1; break;
+	case kDMA_AI0_High: m_config.Enable_AI0_High = 1; break;
+	case kDMA_AIAveraged0_Low: m_config.Enable_AIAveraged0_Low = 1; break;
+	case kDMA_AIAveraged0_High: m_config.Enable_AIAveraged0_High = 1; break;
+	case kDMA_AI1_Low: m_config.Enable_AI1_Low = 1; break;
+	case kDMA_AI1_High: m_config.Enable_AI1_High = 1; break;
+	case kDMA_AIAveraged1_Low: m_config.Enable_AIAveraged1_Low = 1; break;
+	case kDMA_AIAveraged1_High: m_config.Enable_AIAveraged1_High = 1; break;
+	case kDMA_Accumulator0: m_config.Enable_Accumulator0 = 1; break;
+	case kDMA_Accumulator1: m_config.Enable_Accumulator1 = 1; break;
+	case kDMA_DI: m_config.Enable_DI = 1; break;
+	case kDMA_AnalogTriggers: m_config.Enable_AnalogTriggers = 1; break;
+	case kDMA_Counters_Low: m_config.Enable_Counters_Low = 1; break;
+	case kDMA_Counters_High: m_config.Enable_Counters_High = 1; break;
+	case kDMA_CounterTimers_Low: m_config.Enable_CounterTimers_Low = 1; break;
+	case kDMA_CounterTimers_High: m_config.Enable_CounterTimers_High = 1; break;
+	case kDMA_Encoders: m_config.Enable_Encoders = 1; break;
+	case kDMA_EncoderTimers: m_config.Enable_EncoderTimers = 1; break;
+	default: return;
+	}
+	m_dma->writeConfig(m_config, &status);
+	wpi_assertCleanStatus(status);
+
+	// Enabled groups are packed in order, followed by the timestamp.
+	m_offsets[group] = 0;
+	m_sampleSize = 0;
+	for (UINT32 i = 0; i < kDMA_NumGroups; i++)
+	{
+		if (m_offsets[i] >= 0)
+		{
+			m_offsets[i] = m_sampleSize;
+			m_sampleSize += kGroupSize[i];
+		}
+	}
+	m_sampleSize++;
+}
+
+/**
+ * Capture an encoder.
+ *
+ * 4x encoders use an FPGA encoder, 1x and 2x encoders use an FPGA counter.
+ *
+ * @param encoder The encoder to capture.
+ */
+void DMA::AddEncoder(Encoder *encoder)
+{
+	if (encoder == NULL)
+	{
+		wpi_fatal(NullParameter);
+		return;
+	}
+	if (encoder->m_counter != NULL)
+	{
+		AddCounter(encoder->m_counter);
+	}
+	else
+	{
+		EnableGroup(kDMA_Encoders);
+	}
+}
+
+/**
+ * Capture a counter.
+ *
+ * @param counter The counter to capture.
+ */
+void DMA::AddCounter(Counter *counter)
+{
+	if (counter == NULL)
+	{
+		wpi_fatal(NullParameter);
+		return;
+	}
+	EnableGroup(counter->m_index < 4 ? kDMA_Counters_Low : kDMA_Counters_High);
+}
+
+/**
+ * Capture the digital inputs of both digital modules.
+ */
+void DMA::AddDigitalInputs()
+{
+	EnableGroup(kDMA_DI);
+}
+
+/**
+ * Capture the raw value of an analog channel.
+ *
+ * @param channel The analog channel to capture.
+ */
+void DMA::AddAnalogInput(AnalogChannel *channel)
+{
+	if (channel == NULL)
+	{
+		wpi_fatal(NullParameter);
+		return;
+	}
+	UINT32 moduleIndex = AnalogModule::SlotToIndex(channel->GetSlot());
+	EnableGroup((DMAGroup)(kDMA_AI0_Low + moduleIndex * 4 + (channel->GetChannel() > 4 ? 1 : 0)));
+}
+
+/**
+ * Capture the oversampled and averaged value of an analog channel.
+ *
+ * @param channel The analog channel to capture.
+ */
+void DMA::AddAveragedAnalogInput(AnalogChannel *channel)
+{
+	if (channel == NULL)
+	{
+		wpi_fatal(NullParameter);
+		return;
+	}
+	UINT32 moduleIndex = AnalogModule::SlotToIndex(channel->GetSlot());
+	EnableGroup((DMAGroup)(kDMA_AIAveraged0_Low + moduleIndex * 4 + (channel->GetChannel() > 4 ? 1 : 0)));
+}
+
+/**
+ * Capture the accumulator of an analog channel.
+ *
+ * @param channel The analog channel to capture. It must be an accumulator channel.
+ */
+void DMA::AddAccumulator(AnalogChannel *channel)
+{
+	if (channel == NULL)
+	{
+		wpi_fatal(NullParameter);
+		return;
+	}
+	if (!channel->IsAccumulatorChannel())
+	{
+		wpi_fatal(ParameterOutOfRange);
+		return;
+	}
+	EnableGroup(channel->GetChannel() == AnalogChannel::kAccumulatorChannels[0] ?
+		kDMA_Accumulator0 : kDMA_Accumulator1);
+}
+
+/**
+ * Capture a gyro.
+ *
+ * @param gyro The gyro to capture.
+ */
+void DMA::AddGyro(Gyro *gyro)
+{
+	if (gyro == NULL)
+	{
+		wpi_fatal(NullParameter);
+		return;
+	}
+	AddAccumulator(gyro->m_analog);
+}
+
+/**
+ * Start capturing samples.
+ *
+ * @param queueDepth The number of samples the host buffer can hold.
+ */
+void DMA::Start(UINT32 queueDepth)
+{
+	if (m_manager != NULL)
+	{
+		return;
+	}
+	if (queueDepth == 0)
+	{
+		wpi_fatal(ParameterOutOfRange);
+		return;
+	}
+	m_readBufferSize = queueDepth * m_sampleSize;
+	m_readBuffer = new UINT32[m_readBufferSize];
+	status = 0;
+	m_manager = new tDMAManager(kDMAChannel, m_readBufferSize, &status);
+	if (status == 0)
+	{
+		m_manager->start(&status);
+	}
+	if (status != 0)
+	{
+		// Leave DMA paused.
+		wpi_assertCleanStatus(status);
+		status = 0;
+		delete m_manager;
+		m_manager = NULL;
+		delete [] m_readBuffer;
+		m_readBuffer = NULL;
+		m_readBufferSize = 0;
+		return;
+	}
+	SetPause(false);
+}
+
+/**
+ * Stop capturing samples and discard the queued samples.
+ */
+void DMA::Stop()
+{
+	if (m_manager == NULL)
+	{
+		return;
+	}
+	SetPause(true);
+	m_manager->stop(&status);
+	delete m_manager;
+	m_manager = NULL;
+	delete [] m_readBuffer;
+	m_readBuffer = NULL;
+	m_readBufferSize = 0;
+}
+
+/**
+ * Read a block of samples.
+ *
+ * Reads all the queued samples up to maxSamples. If no sample is queued, waits up to
+ * timeout for one.
+ *
+ * @param samples The array of samples to fill.
+ * @param maxSamples The size of the array.
+ * @param timeout The maximum time to wait for a sample in milliseconds.
+ * @param samplesRead Receives the number of samples read.
+ * @param samplesRemaining Receives the number of samples still queued, can be NULL.
+ * @return kOk if samples were read, kTimeout if none arrived in time, kError otherwise.
+ */
+DMA::ReadStatus DMA::Read(DMASample *samples, UINT32 maxSamples, UINT32 timeout,
+	UINT32 *samplesRead, UINT32 *samplesRemaining)
+{
+	tNIRIO_u32 wordsRead = 0;
+	tNIRIO_u32 wordsRemaining = 0;
+
+	*samplesRead = 0;
+	if (m_manager == NULL)
+	{
+		return kError;
+	}
+	if (samples == NULL)
+	{
+		wpi_fatal(NullParameter);
+		return kError;
+	}
+	if (maxSamples == 0)
+	{
+		wpi_fatal(ParameterOutOfRange);
+		return kError;
+	}
+
+	// Reading zero words returns how many are queued.
+	status = 0;
+	m_manager->read(m_readBuffer, 0, 0, &wordsRead, &wordsRemaining, &status);
+	UINT32 count = wordsRemaining / m_sampleSize;
+	if (count == 0) count = 1;
+	if (count > maxSamples) count = maxSamples;
+	if (count * m_sampleSize > m_readBufferSize) count = m_readBufferSize / m_sampleSize;
+
+	status = 0;
+	m_manager->read(m_readBuffer, count * m_sampleSize, timeout, &wordsRead, &wordsRemaining, &status);
+	if (status == kDMAReadTimeout)
+	{
+		status = 0;
+		return kTimeout;
+	}
+	if (status != 0)
+	{
+		wpi_assertCleanStatus(status);
+		return kError;
+	}
+
+	for (UINT32 i = 0; i < count; i++)
+	{
+		DMASample *sample = &samples[i];
+		for (UINT32 j = 0; j < m_sampleSize; j++)
+		{
+			sample->m_buffer[j] = m_readBuffer[i * m_sampleSize + j];
+		}
+		for (UINT32 j = 0; j < kDMA_NumGroups; j++)
+		{
+			sample->m_offsets[j] = m_offsets[j];
+		}
+		sample->m_size = m_sampleSize;
+	}
+	*samplesRead = count;
+	if (samplesRemaining != NULL)
+	{
+		*samplesRemaining = wordsRemaining / m_sampleSize;
+	}
+	return kOk;
+}
@@ -0,0 +1,129 @@
+/*----------------------------------------------------------------------------*/
+/* Copyright (c) FIRST 2008. All Rights Reserved.							  */
+/* Open Source Software - may be modified and shared by FRC teams. The code   */
+/* must be accompanied by the FIRST BSD license file in $(WIND_BASE)/WPILib.  */
+/*----------------------------------------------------------------------------*/
+
+#ifndef DMA_H
+#define DMA_H
+
+#include "ChipObject.h"
+#include "SensorBase.h"
+
+class AnalogChannel;
+class Counter;
+class DigitalInput;
+class Encoder;
+class Gyro;
+
+/**
+ * The sensor groups the FPGA can capture with DMA.
+ *
+ * Each enabled group adds a fixed number of words to every sample, in the order
+ * of this enum. The last word of a sample is the FPGA timestamp.
+ */
+typedef enum
+{
+	kDMA_AI0_Low,
+	kDMA_AI0_High,
+	kDMA_AIAveraged0_Low,
+	kDMA_AIAveraged0_High,
+	kDMA_AI1_Low,
+	kDMA_AI1_High,
+	kDMA_AIAveraged1_Low,
+	kDMA_AIAveraged1_High,
+	kDMA_Accumulator0,
+	kDMA_Accumulator1,
+	kDMA_DI,
+	kDMA_AnalogTriggers,
+	kDMA_Counters_Low,
+	kDMA_Counters_High,
+	kDMA_CounterTimers_Low,
+	kDMA_CounterTimers_High,
+	kDMA_Encoders,
+	kDMA_EncoderTimers,
+	kDMA_NumGroups
+} DMAGroup;
+
+/**
+ * One time stamped sample captured by DMA.
+ *
+ * The sensor classes read their values from a sample with the overloads that take
+ * a DMASample, e.g. Encoder::GetDistance(DMASample *).
+ */
+class DMASample
+{
+	friend class DMA;
+public:
+	static const UINT32 kMaxSize = 57;
+
+	DMASample();
+	UINT32 GetTimestamp();
+	double GetTime();
+	bool IsCaptured(DMAGroup group);
+	INT32 GetEncoderValue(UINT32 index);
+	INT32 GetCounterValue(UINT32 index);
+	INT16 GetAnalogValue(UINT32 moduleIndex, UINT32 channel);
+	INT32 GetAverageValue(UINT32 moduleIndex, UINT32 channel);
+	void GetAccumulatorOutput(UINT32 index, INT64 *value, UINT32 *count);
+	UINT16 GetDigitalInputs(UINT32 moduleIndex);
+
+private:
+	UINT32 GetWord(DMAGroup group, UINT32 word);
+
+	UINT32 m_buffer[kMaxSize];
+	INT32 m_offsets[kDMA_NumGroups];
+	UINT32 m_size;
+};
+
+/**
+ * Class to capture sensor samples with the FPGA DMA engine.
+ *
+ * The FPGA samples the selected sensors at a fixed rate and queues the samples to
+ * the processor, each with its FPGA timestamp. Reading a block of samples costs one
+ * DMA transfer instead of one register access per sensor per sample, and the
+ * samples are evenly spaced regardless of task scheduling.
+ *
+ * Select the sensors with the Add methods, set the rate, then call Start(). The
+ * selection cannot change while DMA is running. There is only one DMA engine.
+ */
+class DMA : public SensorBase
+{
+public:
+	typedef enum {kOk, kTimeout, kError} ReadStatus;
+
+	DMA();
+	virtual ~DMA();
+
+	void SetPause(bool pause);
+	void SetRate(UINT32 cycles);
+
+	void AddEncoder(Encoder *encoder);
+	void AddCounter(Counter *counter);
+	void AddDigitalInputs();
+	void AddAnalogInput(AnalogChannel *channel);
+	void AddAveragedAnalogInput(AnalogChannel *channel);
+	void AddAccumulator(AnalogChannel *channel);
+	void AddGyro(Gyro *gyro);
+
+	void Start(UINT32 queueDepth);
+	void Stop();
+	ReadStatus Read(DMASample *samples, UINT32 maxSamples, UINT32 timeout,
+		UINT32 *samplesRead, UINT32 *samplesRemaining);
+
+private:
+	static const UINT32 kGroupSize[kDMA_NumGroups];
+	static bool m_allocated;
+
+	void EnableGroup(DMAGroup group);
+
+	tDMA *m_dma;
+	tDMAManager *m_manager;
+	tDMA::tConfig m_config;
+	INT32 m_offsets[kDMA_NumGroups];
+	UINT32 m_sampleSize;
+	UINT32 *m_readBuffer;
+	UINT32 m_readBufferSize;
+};
+
+#endif
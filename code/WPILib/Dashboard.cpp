@@ -22,17 +22,28 @@ Dashboard::Dashboard(SEM_ID statusDataSem)
 	: m_userStatusData (NULL)
 	, m_userStatusDataSize (0)
 	, m_localBuffer (NULL)
+	, m_readyBuffer (NULL)
+	, m_readyBufferSize (0)
+	, m_readyBufferFresh (false)
+	, m_sendBuffer (NULL)
 	, m_localPrintBuffer (NULL)
+	, m_sendPrintBuffer (NULL)
 	, m_packPtr (NULL)
 	, m_printSemaphore (0)
+	, m_bufferSemaphore (0)
 	, m_statusDataSemaphore (statusDataSem)
 {
-	m_userStatusData = new char[kMaxDashboardDataSize];
 	m_localBuffer = new char[kMaxDashboardDataSize];
+	m_readyBuffer = new char[kMaxDashboardDataSize];
+	m_sendBuffer = new char[kMaxDashboardDataSize];
+	m_userStatusData = m_sendBuffer;
 	m_localPrintBuffer = new char[kMaxDashboardDataSize * 2];
 	m_localPrintBuffer[0] = 0;
+	m_sendPrintBuffer = new char[kMaxDashboardDataSize * 2];
+	m_sendPrintBuffer[0] = 0;
 	m_packPtr = m_localBuffer;
 	m_printSemaphore = semMCreate(SEM_Q_PRIORITY | SEM_DELETE_SAFE | SEM_INVERSION_SAFE);
+	m_bufferSemaphore = semMCreate(SEM_Q_PRIORITY | SEM_DELETE_SAFE | SEM_INVERSION_SAFE);
 }
 
 /**
@@ -42,13 +53,19 @@ Dashboard::Dashboard(SEM_ID statusDataSem)
  */
 Dashboard::~Dashboard()
 {
+	semDelete(m_bufferSemaphore);
 	semDelete(m_printSemaphore);
 	m_packPtr = NULL;
+	delete [] m_sendPrintBuffer;
+	m_sendPrintBuffer = NULL;
 	delete [] m_localPrintBuffer;
 	m_localPrintBuffer = NULL;
+	delete [] m_sendBuffer;
+	m_sendBuffer = NULL;
+	delete [] m_readyBuffer;
+	m_readyBuffer = NULL;
 	delete [] m_localBuffer;
 	m_localBuffer = NULL;
-	delete [] m_userStatusData;
 	m_userStatusData = NULL;
 }
 
@@ -293,6 +310,8 @@ void Dashboard::Printf(const char *writeFmt, ...)
  * If you are not using the packed dashboard data, you can call Finalize() to commit the Printf() buffer and the error string buffer.
  * In effect, you are packing an empty structure.
  * Prepares a packet to go to the dashboard...
+ * The packed buffer is handed over by swapping pointers, so the DriverStation task is
+ * never blocked while the user is packing and the data is never copied.
  * @return The total size of the data packed into the userData field of the status packet.
  */
 INT32 Dashboard::Finalize(void)
@@ -303,38 +322,57 @@ INT32 Dashboard::Finalize(void)
 		return 0;
 	}
 
-	Synchronized sync(m_statusDataSemaphore);
+	Synchronized sync(m_bufferSemaphore);
 
 	// Sequence number
 	DriverStation::GetInstance()->IncrementUpdateNumber();
 
 	// Packed Dashboard Data
-	m_userStatusDataSize = m_packPtr - m_localBuffer;
-	memcpy(m_userStatusData, m_localBuffer, m_userStatusDataSize);
+	char *packed = m_localBuffer;
+	m_readyBufferSize = m_packPtr - packed;
+	m_localBuffer = m_readyBuffer;
+	m_readyBuffer = packed;
+	m_readyBufferFresh = true;
 	m_packPtr = m_localBuffer;
 
-	return m_userStatusDataSize;
+	return m_readyBufferSize;
 }
 
 /**
  * Called by the DriverStation class to retrieve buffers, sizes, etc. for writing
  *   to the NetworkCommunication task.
  * This function is called while holding the m_statusDataSemaphore.
+ * The returned buffer stays valid until the next call.
  */
 void Dashboard::GetStatusBuffer(char **userStatusData, INT32* userStatusDataSize)
 {
+	// Newly finalized packed data
+	{
+		Synchronized sync(m_bufferSemaphore);
+		if (m_readyBufferFresh)
+		{
+			char *ready = m_readyBuffer;
+			m_readyBuffer = m_sendBuffer;
+			m_sendBuffer = ready;
+			m_readyBufferFresh = false;
+			m_userStatusData = m_sendBuffer;
+			m_userStatusDataSize = m_readyBufferSize;
+		}
+	}
+
 	// User printed strings
 	if (m_localPrintBuffer[0] != 0)
 	{
 		// Sequence number
 		DriverStation::GetInstance()->IncrementUpdateNumber();
 
-		INT32 printSize;
 		Synchronized syncPrint(m_printSemaphore);
-		printSize = strlen(m_localPrintBuffer);
-		m_userStatusDataSize = printSize;
-		memcpy(m_userStatusData, m_localPrintBuffer, m_userStatusDataSize);
+		char *printed = m_localPrintBuffer;
+		m_localPrintBuffer = m_sendPrintBuffer;
 		m_localPrintBuffer[0] = 0;
+		m_sendPrintBuffer = printed;
+		m_userStatusData = m_sendPrintBuffer;
+		m_userStatusDataSize = strlen(m_sendPrintBuffer);
 	}
 
 	*userStatusData = m_userStatusData;
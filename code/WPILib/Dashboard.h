@@ -9,9 +9,27 @@
 
 #include "DashboardBase.h"
 #include "NetworkCommunication/FRCComm.h"
+#include "Utility.h"
+#include "WPIStatus.h"
 #include <stack>
 #include <vector>
 #include <vxWorks.h>
+#include <string.h>
+
+/**
+ * Declare a dashboard schema cluster.
+ * A schema is a struct whose members are laid out exactly like the LabVIEW
+ * "Dashboard Datatype" cluster: nested structs for nested clusters and
+ * fixed-size member arrays for clusters of identical elements. Use UINT8 for
+ * booleans. Strings and LabVIEW arrays are variable length and cannot be part
+ * of a schema. Every struct of a schema must be declared with this attribute
+ * so the compiler does not insert padding.
+ */
+#define DASHBOARD_CLUSTER __attribute__((__packed__))
+
+// Only instantiated for true, so a false condition fails to compile.
+template <bool> struct DashboardSchemaCheck;
+template <> struct DashboardSchemaCheck<true> {};
 
 /**
  * Pack data into the "user data" field that gets sent to the dashboard laptop
@@ -44,6 +62,8 @@ public:
 
 	void Printf(const char *writeFmt, ...);
 
+	template <class Schema> void Pack(const Schema &data);
+
 	INT32 Finalize(void);
 	void GetStatusBuffer(char** userStatusData, INT32* userStatusDataSize);
 	void Flush() {}
@@ -57,18 +77,51 @@ private:
 	void AddedElement(Type type);
 	bool IsArrayRoot(void);
 
-	char *m_userStatusData;
+	// The buffers are swapped rather than copied. The user packs into m_localBuffer,
+	// Finalize() swaps it with m_readyBuffer and the DriverStation task swaps that
+	// with m_sendBuffer when it builds the next status packet.
+	char *m_userStatusData;			// the data being sent, m_sendBuffer or m_sendPrintBuffer
 	INT32 m_userStatusDataSize;
 	char *m_localBuffer;
+	char *m_readyBuffer;
+	INT32 m_readyBufferSize;
+	bool m_readyBufferFresh;
+	char *m_sendBuffer;
 	char *m_localPrintBuffer;
+	char *m_sendPrintBuffer;
 	char *m_packPtr;
 	std::vector<Type> m_expectedArrayElementType;
 	std::vector<INT32> m_arrayElementCount;
 	std::vector<INT32*> m_arraySizePtr;
 	std::stack<ComplexType> m_complexTypeStack;
 	SEM_ID m_printSemaphore;
+	SEM_ID m_bufferSemaphore;		// held only to swap the buffer pointers
 	SEM_ID m_statusDataSemaphore;
 };
 
+/**
+ * Pack a complete dashboard schema into the dashboard data structure.
+ *
+ * The layout of the schema is fixed at compile time, so the whole structure
+ * is copied at once without the per-element checks of the Add methods. The
+ * values can only be set through the typed members of the schema. Call
+ * Finalize() afterwards to commit the buffer.
+ * @param data The schema to pack. Its structs must be DASHBOARD_CLUSTER.
+ */
+template <class Schema>
+void Dashboard::Pack(const Schema &data)
+{
+	// Fails to compile if the schema does not fit in a packet.
+	(void)sizeof(DashboardSchemaCheck<(sizeof(Schema) <= (size_t)kMaxDashboardDataSize)>);
+
+	if (m_packPtr != m_localBuffer || m_localPrintBuffer[0] != 0 || !m_complexTypeStack.empty())
+	{
+		wpi_fatal(DashboardDataCollision);
+		return;
+	}
+	memcpy(m_localBuffer, &data, sizeof(Schema));
+	m_packPtr = m_localBuffer + sizeof(Schema);
+}
+
 #endif
 
@@ -13,15 +13,46 @@
 #include "NetworkCommunication/FRCComm.h"
 #include <strLib.h>
 #include "MotorSafetyHelper.h"
+#include <math.h>
+#include <string.h>
+
+#define COMPILER_BARRIER() __asm__ __volatile__("" ::: "memory")
 
 const UINT32 DriverStation::kBatterySlot;
 const UINT32 DriverStation::kBatteryChannel;
 const UINT32 DriverStation::kJoystickPorts;
 const UINT32 DriverStation::kJoystickAxes;
+const UINT32 DriverStation::kJoystickSnapshots;
 const float DriverStation::kUpdatePeriod;
 DriverStation* DriverStation::m_instance = NULL;
 UINT8 DriverStation::m_updateNumber = 0;
 
+// Returned for an invalid joystick index.
+static DriverStation::StickState neutralStick;
+
+/**
+ * Convert a raw joystick axis value to -1.0 to 1.0 and apply the response shaping.
+ * The deadband is removed and the rest of the range is stretched back to full scale
+ * before the response exponent is applied, so the output is continuous.
+ */
+static float ConvertStickAxis(INT8 value, float deadband, float exponent)
+{
+	float result;
+	if (value < 0)
+		result = ((float) value) / 128.0;
+	else
+		result = ((float) value) / 127.0;
+
+	float magnitude = fabs(result);
+	if (magnitude <= deadband)
+		return 0.0;
+	if (deadband > 0.0)
+		magnitude = (magnitude - deadband) / (1.0 - deadband);
+	if (exponent != 1.0)
+		magnitude = pow(magnitude, exponent);
+	return (result < 0.0) ? -magnitude : magnitude;
+}
+
 /**
  * DriverStation contructor.
  * 
@@ -39,7 +70,9 @@ DriverStation::DriverStation()
 	, m_dashboardInUseLow(&m_dashboardLow)
 	, m_newControlData (false)
 	, m_packetDataAvailableSem (0)
+	, m_newDataUserSem (0)
 	, m_enhancedIO()
+	, m_joystickSnapshotIndex (0)
 {
 	// Create a new semaphore
 	m_packetDataAvailableSem = semBCreate (SEM_Q_PRIORITY, SEM_EMPTY);
@@ -75,6 +108,18 @@ DriverStation::DriverStation()
 	m_controlData->analog4 = 0;
 	m_controlData->dsDigitalIn = 0;
 
+	// no response shaping until the user asks for it
+	for (UINT32 stick = 0; stick < kJoystickPorts; stick++)
+	{
+		for (UINT32 axis = 0; axis < kJoystickAxes; axis++)
+		{
+			m_axisDeadband[stick][axis] = 0.0;
+			m_axisExponent[stick][axis] = 1.0;
+		}
+	}
+	memset(m_joystickSnapshots, 0, sizeof(m_joystickSnapshots));
+	PublishJoystickSnapshot();
+
 	m_batteryChannel = new AnalogChannel(kBatterySlot, kBatteryChannel);
 
 	AddToSingletonList();
@@ -139,11 +184,61 @@ DriverStation* DriverStation::GetInstance()
 void DriverStation::GetData()
 {
 	getCommonControlData(m_controlData, WAIT_FOREVER);
+	PublishJoystickSnapshot();
 	m_newControlData = true;
+	if (m_newDataUserSem != 0)
+	{
+		semGive(m_newDataUserSem);
+	}
+}
+
+/**
+ * Build the joystick snapshot of the latest packet and publish it.
+ * The snapshot is written into a buffer no reader is using and then published by
+ * updating the index, so readers never take a lock. The axes are converted and the
+ * button edges are computed here once per packet instead of on every read.
+ */
+void DriverStation::PublishJoystickSnapshot()
+{
+	const INT8 *rawAxes[kJoystickPorts] = {
+		m_controlData->stick0Axes, m_controlData->stick1Axes,
+		m_controlData->stick2Axes, m_controlData->stick3Axes};
+	const UINT16 rawButtons[kJoystickPorts] = {
+		m_controlData->stick0Buttons, m_controlData->stick1Buttons,
+		m_controlData->stick2Buttons, m_controlData->stick3Buttons};
+	const JoystickSnapshot &prev = m_joystickSnapshots[m_joystickSnapshotIndex];
+	UINT32 index = (m_joystickSnapshotIndex + 1) % kJoystickSnapshots;
+	JoystickSnapshot &snapshot = m_joystickSnapshots[index];
+
+	snapshot.sequence = prev.sequence + 1;
+	snapshot.enabled = m_controlData->enabled;
+	snapshot.autonomous = m_controlData->autonomous;
+	snapshot.fmsAttached = m_controlData->fmsAttached;
+	snapshot.digitalIn = m_controlData->dsDigitalIn;
+	for (UINT32 stick = 0; stick < kJoystickPorts; stick++)
+	{
+		StickState &state = snapshot.sticks[stick];
+		UINT16 prevButtons = prev.sticks[stick].buttons;
+		for (UINT32 axis = 0; axis < kJoystickAxes; axis++)
+		{
+			state.axes[axis] = ConvertStickAxis(rawAxes[stick][axis],
+				m_axisDeadband[stick][axis], m_axisExponent[stick][axis]);
+		}
+		state.buttons = rawButtons[stick];
+		state.pressed = state.buttons & ~prevButtons;
+		state.released = prevButtons & ~state.buttons;
+	}
+
+	// The snapshot must be complete before it is published.
+	COMPILER_BARRIER();
+	m_joystickSnapshotIndex = index;
 }
 
 /**
  * Copy status data from the DS task for the user.
+ * The status data semaphore is only held while the dashboards swap in their send
+ * buffers. The buffers are not written by the user until the next swap, so they
+ * are sent and flushed without blocking the user's Log and Finalize calls.
  */
 void DriverStation::SetData()
 {
@@ -152,10 +247,12 @@ void DriverStation::SetData()
 	char *userStatusDataLow;
 	INT32 userStatusDataLowSize;
 
-	Synchronized sync(m_statusDataSemaphore);
+	{
+		Synchronized sync(m_statusDataSemaphore);
+		m_dashboardInUseHigh->GetStatusBuffer(&userStatusDataHigh, &userStatusDataHighSize);
+		m_dashboardInUseLow->GetStatusBuffer(&userStatusDataLow, &userStatusDataLowSize);
+	}
 
-	m_dashboardInUseHigh->GetStatusBuffer(&userStatusDataHigh, &userStatusDataHighSize);
-	m_dashboardInUseLow->GetStatusBuffer(&userStatusDataLow, &userStatusDataLowSize);
 	setStatusData(GetBatteryVoltage(), m_digitalOut, m_updateNumber,
 		userStatusDataHigh, userStatusDataHighSize, userStatusDataLow, userStatusDataLowSize, WAIT_FOREVER);
 	
@@ -196,38 +293,12 @@ float DriverStation::GetStickAxis(UINT32 stick, UINT32 axis)
 		wpi_fatal(BadJoystickAxis);
 		return 0.0;
 	}
-
-	INT8 value;
-	switch (stick)
+	if (stick < 1 || stick > kJoystickPorts)
 	{
-		case 1:
-			value = m_controlData->stick0Axes[axis-1];
-			break;
-		case 2:
-			value = m_controlData->stick1Axes[axis-1];
-			break;
-		case 3:
-			value = m_controlData->stick2Axes[axis-1];
-			break;
-		case 4:
-			value = m_controlData->stick3Axes[axis-1];
-			break;
-		default:
-			wpi_fatal(BadJoystickIndex);
-			return 0.0;
+		wpi_fatal(BadJoystickIndex);
+		return 0.0;
 	}
-	
-	float result;
-	if (value < 0)
-		result = ((float) value) / 128.0;
-	else
-		result = ((float) value) / 127.0;
-	wpi_assert(result <= 1.0 && result >= -1.0);
-	if (result > 1.0)
-		result = 1.0;
-	else if (result < -1.0)
-		result = -1.0;
-	return result;
+	return GetJoystickSnapshot().sticks[stick - 1].axes[axis - 1];
 }
 
 /**
@@ -240,18 +311,86 @@ float DriverStation::GetStickAxis(UINT32 stick, UINT32 axis)
 short DriverStation::GetStickButtons(UINT32 stick)
 {
 	wpi_assert ((stick >= 1) && (stick <= 4));
-	switch (stick)
+	if (stick < 1 || stick > kJoystickPorts)
+		return 0;
+	return GetJoystickSnapshot().sticks[stick - 1].buttons;
+}
+
+/**
+ * Get the state of a joystick from the latest snapshot.
+ * The axes, the buttons and the button edges of the latest packet are read from the
+ * returned reference without any conversion.
+ * 
+ * @param stick The joystick to read.
+ * @return The state of the joystick, valid until the next pass of the robot loop.
+ */
+const DriverStation::StickState &DriverStation::GetStickState(UINT32 stick)
+{
+	if (stick < 1 || stick > kJoystickPorts)
 	{
-	case 1:
-		return m_controlData->stick0Buttons;
-	case 2:
-		return m_controlData->stick1Buttons;
-	case 3:
-		return m_controlData->stick2Buttons;
-	case 4:
-		return m_controlData->stick3Buttons;
+		wpi_fatal(BadJoystickIndex);
+		return neutralStick;
+	}
+	return GetJoystickSnapshot().sticks[stick - 1];
+}
+
+/**
+ * Set the deadband of a joystick axis.
+ * Axis values within the deadband read as zero and the rest of the range is scaled
+ * back to full scale. Takes effect with the next packet.
+ * 
+ * @param stick The joystick, 1 - 4.
+ * @param axis The axis on the joystick, 1 - 6.
+ * @param deadband The deadband, 0.0 to less than 1.0.
+ */
+void DriverStation::SetStickAxisDeadband(UINT32 stick, UINT32 axis, float deadband)
+{
+	if (stick < 1 || stick > kJoystickPorts)
+	{
+		wpi_fatal(BadJoystickIndex);
+		return;
+	}
+	if (axis < 1 || axis > kJoystickAxes)
+	{
+		wpi_fatal(BadJoystickAxis);
+		return;
 	}
-	return 0;
+	if (deadband < 0.0 || deadband >= 1.0)
+	{
+		wpi_fatal(ParameterOutOfRange);
+		return;
+	}
+	m_axisDeadband[stick - 1][axis - 1] = deadband;
+}
+
+/**
+ * Set the response curve of a joystick axis.
+ * The axis magnitude is raised to the exponent, preserving the sign. An exponent of 1.0
+ * is linear, larger values give finer control near the center. Takes effect with the
+ * next packet.
+ * 
+ * @param stick The joystick, 1 - 4.
+ * @param axis The axis on the joystick, 1 - 6.
+ * @param exponent The response exponent, greater than 0.0.
+ */
+void DriverStation::SetStickAxisResponse(UINT32 stick, UINT32 axis, float exponent)
+{
+	if (stick < 1 || stick > kJoystickPorts)
+	{
+		wpi_fatal(BadJoystickIndex);
+		return;
+	}
+	if (axis < 1 || axis > kJoystickAxes)
+	{
+		wpi_fatal(BadJoystickAxis);
+		return;
+	}
+	if (exponent <= 0.0)
+	{
+		wpi_fatal(ParameterOutOfRange);
+		return;
+	}
+	m_axisExponent[stick - 1][axis - 1] = exponent;
 }
 
 // 5V divided by 10 bits
@@ -353,6 +492,18 @@ bool DriverStation::IsNewControlData()
 	return newData;
 }
 
+/**
+ * Register a semaphore to be given every time new control data has arrived.
+ * This lets the user program block until there is new data to process instead
+ * of polling IsNewControlData(). The same semaphore may also be given by other
+ * sources (e.g. a Notifier) to wake the user program.
+ * @param sem The semaphore to give, or 0 to unregister.
+ */
+void DriverStation::SetNewDataUserSem(SEM_ID sem)
+{
+	m_newDataUserSem = sem;
+}
+
 /**
  * Is the driver station attached to a Field Management System?
  * Note: This does not work with the Blue DS.
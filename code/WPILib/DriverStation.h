@@ -30,9 +30,41 @@ public:
 	static const UINT32 kBatteryChannel = 8;
 	static const UINT32 kJoystickPorts = 4;
 	static const UINT32 kJoystickAxes = 6;
+	static const UINT32 kJoystickSnapshots = 3;
+
+	/**
+	 * The state of one joystick in a JoystickSnapshot.
+	 */
+	struct StickState
+	{
+		float axes[kJoystickAxes];	// -1.0 to 1.0 with the deadband and response curve applied
+		UINT16 buttons;
+		UINT16 pressed;				// buttons pressed since the previous packet
+		UINT16 released;			// buttons released since the previous packet
+	};
+
+	/**
+	 * The operator input of one Driver Station packet.
+	 * A snapshot is built once when the packet arrives and is not modified after it
+	 * is published. Read it by reference within one pass of the robot loop; the buffer
+	 * is reused kJoystickSnapshots - 1 packets later.
+	 */
+	struct JoystickSnapshot
+	{
+		UINT32 sequence;			// incremented for every packet received
+		bool enabled;
+		bool autonomous;
+		bool fmsAttached;
+		UINT8 digitalIn;			// Driver Station digital inputs, bit 0 is channel 1
+		StickState sticks[kJoystickPorts];
+	};
 
 	float GetStickAxis(UINT32 stick, UINT32 axis);
 	short GetStickButtons(UINT32 stick);
+	const JoystickSnapshot &GetJoystickSnapshot() { return m_joystickSnapshots[m_joystickSnapshotIndex]; }
+	const StickState &GetStickState(UINT32 stick);
+	void SetStickAxisDeadband(UINT32 stick, UINT32 axis, float deadband);
+	void SetStickAxisResponse(UINT32 stick, UINT32 axis, float exponent);
 
 	float GetAnalogIn(UINT32 channel);
 	bool GetDigitalIn(UINT32 channel);
@@ -45,6 +77,7 @@ public:
 	bool IsOperatorControl();
 	bool IsNewControlData();
 	bool IsFMSAttached();
+	void SetNewDataUserSem(SEM_ID sem);
 
 	UINT32 GetPacketNumber();
 	Alliance GetAlliance();
@@ -87,6 +120,7 @@ private:
 	static const float kUpdatePeriod = 0.02;
 
 	void Run();
+	void PublishJoystickSnapshot();
 
 	struct FRCCommonControlData *m_controlData;
 	UINT8 m_digitalOut;
@@ -99,7 +133,12 @@ private:
 	DashboardBase* m_dashboardInUseLow;
 	bool m_newControlData;
 	SEM_ID m_packetDataAvailableSem;
+	SEM_ID m_newDataUserSem;
 	DriverStationEnhancedIO m_enhancedIO;
+	JoystickSnapshot m_joystickSnapshots[kJoystickSnapshots];
+	volatile UINT32 m_joystickSnapshotIndex;	// the latest published snapshot
+	float m_axisDeadband[kJoystickPorts][kJoystickAxes];
+	float m_axisExponent[kJoystickPorts][kJoystickAxes];
 	static UINT8 m_updateNumber;
 };
 
@@ -5,6 +5,7 @@
 /*----------------------------------------------------------------------------*/
 
 #include "Encoder.h"
+#include "DMA.h"
 #include "DigitalInput.h"
 #include "Resource.h"
 #include "Utility.h"
@@ -375,6 +376,43 @@ double Encoder::GetDistance()
 	return GetRaw() * DecodingScaleFactor() * m_distancePerPulse;
 }
 
+/**
+ * Gets the raw value from the encoder as captured in a DMA sample.
+ * The encoder must have been added to the DMA object that captured the sample.
+ * 
+ * @param sample The DMA sample.
+ * @return Raw count of the encoder when the sample was captured.
+ */
+INT32 Encoder::GetRaw(DMASample *sample)
+{
+	if (m_counter)
+		return m_counter->Get(sample);
+	return sample->GetEncoderValue(m_index);
+}
+
+/**
+ * Gets the count as captured in a DMA sample.
+ * This method compensates for the decoding type.
+ * 
+ * @param sample The DMA sample.
+ * @return Count of the encoder when the sample was captured, adjusted for the 1x, 2x, or 4x scale factor.
+ */
+INT32 Encoder::Get(DMASample *sample)
+{
+	return (INT32) (GetRaw(sample) * DecodingScaleFactor());
+}
+
+/**
+ * Get the distance the robot has driven as captured in a DMA sample.
+ * 
+ * @param sample The DMA sample.
+ * @return The distance driven since the last reset when the sample was captured.
+ */
+double Encoder::GetDistance(DMASample *sample)
+{
+	return GetRaw(sample) * DecodingScaleFactor() * m_distancePerPulse;
+}
+
 /**
  * Get the current rate of the encoder.
  * Units are distance per second as scaled by the value from SetDistancePerPulse().
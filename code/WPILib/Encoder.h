@@ -14,6 +14,7 @@
 #include "PIDSource.h"
 
 class DigitalSource;
+class DMASample;
 
 /**
  * Class to read quad encoders.
@@ -26,6 +27,7 @@ class DigitalSource;
  */
 class Encoder: public SensorBase, public CounterBase, public PIDSource
 {
+	friend class DMA;
 public:
 	typedef enum {kDistance, kRate} PIDSourceParameter;
 
@@ -47,6 +49,9 @@ public:
 	bool GetDirection();
 	double GetDistance();
 	double GetRate();
+	INT32 GetRaw(DMASample *sample);
+	INT32 Get(DMASample *sample);
+	double GetDistance(DMASample *sample);
 	void SetMinRate(double minRate);
 	void SetDistancePerPulse(double distancePerPulse);
 	void SetReverseDirection(bool reverseDirection);
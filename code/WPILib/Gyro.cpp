@@ -7,6 +7,7 @@
 #include "Gyro.h"
 #include "AnalogChannel.h"
 #include "AnalogModule.h"
+#include "DMA.h"
 #include "Timer.h"
 #include "Utility.h"
 #include "WPIStatus.h"
@@ -151,7 +152,30 @@ float Gyro::GetAngle( void )
 	INT64 rawValue;
 	UINT32 count;
 	m_analog->GetAccumulatorOutput(&rawValue, &count);
+	return ScaleAngle(rawValue, count);
+}
 
+/**
+ * Return the heading of the robot in degrees as captured in a DMA sample.
+ * 
+ * The gyro must have been added to the DMA object with DMA::AddGyro().
+ * 
+ * @param sample The DMA sample.
+ * @return the current heading of the robot in degrees when the sample was captured.
+ */
+float Gyro::GetAngle(DMASample *sample)
+{
+	INT64 rawValue;
+	UINT32 count;
+	m_analog->GetAccumulatorOutput(sample, &rawValue, &count);
+	return ScaleAngle(rawValue, count);
+}
+
+/**
+ * Convert the accumulator output to degrees.
+ */
+float Gyro::ScaleAngle(INT64 rawValue, UINT32 count)
+{
 	INT64 value = rawValue - (INT64)((float)count * m_offset);
 
 	double scaledValue = value * 1e-9 * (double)m_analog->GetLSBWeight() * (double)(1 << m_analog->GetAverageBits()) /
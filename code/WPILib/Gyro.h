@@ -12,6 +12,7 @@
 
 class AnalogChannel;
 class AnalogModule;
+class DMASample;
 
 /**
  * Use a rate gyro to return the robots heading relative to a starting position.
@@ -23,6 +24,7 @@ class AnalogModule;
  */
 class Gyro : public SensorBase, public PIDSource
 {
+	friend class DMA;
 public:
 	static const UINT32 kOversampleBits = 10;
 	static const UINT32 kAverageBits = 0;
@@ -36,6 +38,7 @@ public:
 	explicit Gyro(AnalogChannel &channel);
 	virtual ~Gyro();
 	float GetAngle();
+	float GetAngle(DMASample *sample);
 	void SetSensitivity(float voltsPerDegreePerSecond);
 	void Reset();
 	
@@ -43,6 +46,7 @@ public:
 
 private:
 	void InitGyro();
+	float ScaleAngle(INT64 rawValue, UINT32 count);
 
 	AnalogChannel *m_analog;
 	float m_voltsPerDegreePerSecond;
@@ -7,10 +7,145 @@
 #include "I2C.h"
 #include "DigitalModule.h"
 #include "Synchronized.h"
+#include "Task.h"
 #include "Utility.h"
 #include "WPIStatus.h"
 
+const INT32 I2C::kQueuePriority;
+const UINT32 I2C::kQueueSpinTime;
+
 SEM_ID I2C::m_semaphore = NULL;
+SEM_ID I2C::m_queueSemaphore = NULL;
+SEM_ID I2C::m_queueCount = NULL;
+I2CRequest *I2C::m_queueHead = NULL;
+I2CRequest *I2C::m_queueTail = NULL;
+Task *I2C::m_queueTask = NULL;
+
+/**
+ * Pack up to 10 bytes into the low and high words used by the FPGA.
+ */
+static void PackI2CData(const UINT8 *buffer, UINT8 size, UINT32 *data, UINT32 *dataHigh)
+{
+	UINT32 i;
+	*data = 0;
+	*dataHigh = 0;
+	for(i=0; i<size && i<sizeof(*data); i++)
+	{
+		*data |= (UINT32)buffer[i] << (8*i);
+	}
+	for(; i<size; i++)
+	{
+		*dataHigh |= (UINT32)buffer[i] << (8*(i-sizeof(*data)));
+	}
+}
+
+/**
+ * Unpack the low and high words received by the FPGA into bytes.
+ */
+static void UnpackI2CData(UINT32 data, UINT32 dataHigh, UINT8 *buffer, UINT8 size)
+{
+	UINT32 i;
+	for(i=0; i<size && i<sizeof(data); i++)
+	{
+		buffer[i] = (data >> (8*i)) & 0xFF;
+	}
+	for(; i<size; i++)
+	{
+		buffer[i] = (dataHigh >> (8*(i-sizeof(data)))) & 0xFF;
+	}
+}
+
+/**
+ * Constructor.
+ */
+I2CRequest::I2CRequest()
+	: m_device (NULL)
+	, m_sendSize (0)
+	, m_receiveSize (0)
+	, m_aborted (false)
+	, m_timestamp (0)
+	, m_pending (false)
+	, m_completion (NULL)
+	, m_param (NULL)
+	, m_next (NULL)
+{
+	m_doneSemaphore = semBCreate(SEM_Q_PRIORITY, SEM_EMPTY);
+}
+
+/**
+ * Destructor.
+ * 
+ * The request must not be pending.
+ */
+I2CRequest::~I2CRequest()
+{
+	semDelete(m_doneSemaphore);
+}
+
+/**
+ * Check if the request is queued or in progress.
+ * 
+ * @return True if the request has not completed yet.
+ */
+bool I2CRequest::IsPending()
+{
+	return m_pending;
+}
+
+/**
+ * Wait for the request to complete.
+ * 
+ * @param timeout The maximum number of ticks to wait.
+ * @return True if the request has completed.
+ */
+bool I2CRequest::Wait(INT32 timeout)
+{
+	if (m_pending)
+	{
+		semTake(m_doneSemaphore, timeout);
+	}
+	return !m_pending;
+}
+
+/**
+ * Get the result of the completed transaction.
+ * 
+ * @return Transfer Aborted... false for success, true for aborted.
+ */
+bool I2CRequest::IsAborted()
+{
+	return m_aborted;
+}
+
+/**
+ * Get the data read by the completed transaction.
+ * 
+ * @return A pointer to the bytes received.
+ */
+const UINT8 *I2CRequest::GetDataReceived()
+{
+	return m_dataReceived;
+}
+
+/**
+ * Get the number of bytes read by the transaction.
+ * 
+ * @return The number of bytes received.
+ */
+UINT8 I2CRequest::GetReceiveSize()
+{
+	return m_receiveSize;
+}
+
+/**
+ * Get the time the transaction completed.
+ * 
+ * @return The FPGA time in microseconds when the transaction completed.
+ */
+UINT32 I2CRequest::GetTimestamp()
+{
+	return m_timestamp;
+}
 
 /**
  * Constructor.
@@ -60,45 +195,222 @@ bool I2C::Transaction(UINT8 *dataToSend, UINT8 sendSize, UINT8 *dataReceived, UI
 		return true;
 	}
 
-	UINT32 data=0;
-	UINT32 dataHigh=0;
-	UINT32 i;
-	for(i=0; i<sendSize && i<sizeof(data); i++)
+	UINT32 data;
+	UINT32 dataHigh;
+	PackI2CData(dataToSend, sendSize, &data, &dataHigh);
+	bool aborted = DoTransaction(data, dataHigh, sendSize, &data, &dataHigh, receiveSize, 0);
+	UnpackI2CData(data, dataHigh, dataReceived, receiveSize);
+	return aborted;
+}
+
+/**
+ * Run one transaction on the FPGA I2C engine and wait for it to complete.
+ * 
+ * @param spinTime Microseconds to poll the status before waiting a tick at a time.
+ * @return Transfer Aborted... false for success, true for aborted.
+ */
+bool I2C::DoTransaction(UINT32 data, UINT32 dataHigh, UINT8 sendSize,
+	UINT32 *dataReceived, UINT32 *dataReceivedHigh, UINT8 receiveSize, UINT32 spinTime)
+{
+	Synchronized sync(m_semaphore);
+	m_module->m_fpgaDIO->writeI2CConfig_Address(m_deviceAddress, &status);
+	m_module->m_fpgaDIO->writeI2CConfig_BytesToWrite(sendSize, &status);
+	m_module->m_fpgaDIO->writeI2CConfig_BytesToRead(receiveSize, &status);
+	if (sendSize > 0) m_module->m_fpgaDIO->writeI2CDataToSend(data, &status);
+	if (sendSize > sizeof(data)) m_module->m_fpgaDIO->writeI2CConfig_DataToSendHigh(dataHigh, &status);
+	m_module->m_fpgaDIO->writeI2CConfig_BitwiseHandshake(m_compatibilityMode, &status);
+	UINT8 transaction = m_module->m_fpgaDIO->readI2CStatus_Transaction(&status);
+	m_module->m_fpgaDIO->strobeI2CStart(&status);
+	WaitForTransaction(transaction, spinTime);
+	bool aborted = m_module->m_fpgaDIO->readI2CStatus_Aborted(&status);
+	*dataReceived = 0;
+	*dataReceivedHigh = 0;
+	if (receiveSize > 0) *dataReceived = m_module->m_fpgaDIO->readI2CDataReceived(&status);
+	if (receiveSize > sizeof(data)) *dataReceivedHigh = m_module->m_fpgaDIO->readI2CStatus_DataReceivedHigh(&status);
+	return aborted;
+}
+
+/**
+ * Wait for the FPGA to finish the transaction that was just started.
+ * 
+ * The status is polled for up to spinTime microseconds, then the processor is given
+ * up a tick at a time. Synchronous transactions pass 0 and never spin. The queue task
+ * runs above the robot task so a busy robot loop cannot starve the sensor reads it
+ * completes. It only spins for kQueueSpinTime, which catches the transactions that are
+ * already done without holding the processor for a whole read.
+ * 
+ * @param transaction The transaction count read before the transaction was started.
+ * @param spinTime Microseconds to poll before waiting a tick at a time.
+ */
+void I2C::WaitForTransaction(UINT8 transaction, UINT32 spinTime)
+{
+	UINT32 startTime = GetFPGATime();
+	while(transaction == m_module->m_fpgaDIO->readI2CStatus_Transaction(&status) ||
+		!m_module->m_fpgaDIO->readI2CStatus_Done(&status))
 	{
-		data |= (UINT32)dataToSend[i] << (8*i);
+		if (GetFPGATime() - startTime >= spinTime) taskDelay(1);
 	}
-	for(; i<sendSize; i++)
+}
+
+/**
+ * Queue an asynchronous transaction.
+ * 
+ * The transaction is carried out by the I2C queue task in the order it was queued.
+ * Transactions for different devices are run back to back without the caller waiting
+ * on the bus. When the transaction completes, the completion function is called from
+ * the I2C queue task and then any task waiting on the request is released. The
+ * completion function should be short and must not block on I2C.
+ * 
+ * @param request The request to use. It must not be pending.
+ * @param dataToSend Buffer of data to send as part of the transaction. It is copied.
+ * @param sendSize Number of bytes to send as part of the transaction. [0..6]
+ * @param receiveSize Number of bytes to read from the device. [0..7]
+ * @param completion The function to call when the transaction completes, or NULL.
+ * @param param The parameter to pass to the completion function.
+ * @return False if the request was queued, true if it was rejected.
+ */
+bool I2C::StartTransaction(I2CRequest *request, UINT8 *dataToSend, UINT8 sendSize, UINT8 receiveSize,
+	I2CCompletionFunction completion, void *param)
+{
+	if (request == NULL)
+	{
+		wpi_fatal(NullParameter);
+		return true;
+	}
+	if (sendSize > sizeof(request->m_dataToSend) || receiveSize > sizeof(request->m_dataReceived))
 	{
-		dataHigh |= (UINT32)dataToSend[i] << (8*(i-sizeof(data)));
+		wpi_fatal(I2CByteCountError);
+		return true;
+	}
+	if (request->m_pending)
+	{
+		return true;
 	}
 
-	bool aborted = true;
+	if (m_queueTask == NULL)
 	{
 		Synchronized sync(m_semaphore);
-		m_module->m_fpgaDIO->writeI2CConfig_Address(m_deviceAddress, &status);
-		m_module->m_fpgaDIO->writeI2CConfig_BytesToWrite(sendSize, &status);
-		m_module->m_fpgaDIO->writeI2CConfig_BytesToRead(receiveSize, &status);
-		if (sendSize > 0) m_module->m_fpgaDIO->writeI2CDataToSend(data, &status);
-		if (sendSize > sizeof(data)) m_module->m_fpgaDIO->writeI2CConfig_DataToSendHigh(dataHigh, &status);
-		m_module->m_fpgaDIO->writeI2CConfig_BitwiseHandshake(m_compatibilityMode, &status);
-		UINT8 transaction = m_module->m_fpgaDIO->readI2CStatus_Transaction(&status);
-		m_module->m_fpgaDIO->strobeI2CStart(&status);
-		while(transaction == m_module->m_fpgaDIO->readI2CStatus_Transaction(&status)) taskDelay(1);
-		while(!m_module->m_fpgaDIO->readI2CStatus_Done(&status)) taskDelay(1);
-		aborted = m_module->m_fpgaDIO->readI2CStatus_Aborted(&status);
-		if (receiveSize > 0) data = m_module->m_fpgaDIO->readI2CDataReceived(&status);
-		if (receiveSize > sizeof(data)) dataHigh = m_module->m_fpgaDIO->readI2CStatus_DataReceivedHigh(&status);
+		if (m_queueTask == NULL)
+		{
+			m_queueSemaphore = semMCreate(SEM_Q_PRIORITY | SEM_DELETE_SAFE | SEM_INVERSION_SAFE);
+			m_queueCount = semCCreate(SEM_Q_PRIORITY, 0);
+			m_queueTask = new Task("I2CQueue", (FUNCPTR)I2C::QueueTask, kQueuePriority);
+			m_queueTask->Start();
+		}
 	}
 
-	for(i=0; i<receiveSize && i<sizeof(data); i++)
+	request->m_device = this;
+	for (UINT8 i=0; i<sendSize; i++)
 	{
-		dataReceived[i] = (data >> (8*i)) & 0xFF;
+		request->m_dataToSend[i] = dataToSend[i];
 	}
-	for(; i<receiveSize; i++)
+	request->m_sendSize = sendSize;
+	request->m_receiveSize = receiveSize;
+	request->m_aborted = true;
+	request->m_completion = completion;
+	request->m_param = param;
+	request->m_next = NULL;
+	request->m_pending = true;
+	semTake(request->m_doneSemaphore, NO_WAIT);
+
 	{
-		dataReceived[i] = (dataHigh >> (8*(i-sizeof(data)))) & 0xFF;
+		Synchronized sync(m_queueSemaphore);
+		if (m_queueTail == NULL)
+		{
+			m_queueHead = request;
+		}
+		else
+		{
+			m_queueTail->m_next = request;
+		}
+		m_queueTail = request;
+	}
+	semGive(m_queueCount);
+	return false;
+}
+
+/**
+ * Queue an asynchronous write of a single byte to a register on the device.
+ * 
+ * @param request The request to use. It must not be pending.
+ * @param registerAddress The address of the register on the device to be written.
+ * @param data The byte to write to the register on the device.
+ * @param completion The function to call when the transaction completes, or NULL.
+ * @param param The parameter to pass to the completion function.
+ * @return False if the request was queued, true if it was rejected.
+ */
+bool I2C::StartWrite(I2CRequest *request, UINT8 registerAddress, UINT8 data,
+	I2CCompletionFunction completion, void *param)
+{
+	UINT8 buffer[2];
+	buffer[0] = registerAddress;
+	buffer[1] = data;
+	return StartTransaction(request, buffer, sizeof(buffer), 0, completion, param);
+}
+
+/**
+ * Queue an asynchronous read of 1 to 7 bytes from the device.
+ * 
+ * The data is available from I2CRequest::GetDataReceived() once the request completes.
+ * 
+ * @param request The request to use. It must not be pending.
+ * @param registerAddress The register to read first in the transaction.
+ * @param count The number of bytes to read in the transaction. [1..7]
+ * @param completion The function to call when the transaction completes, or NULL.
+ * @param param The parameter to pass to the completion function.
+ * @return False if the request was queued, true if it was rejected.
+ */
+bool I2C::StartRead(I2CRequest *request, UINT8 registerAddress, UINT8 count,
+	I2CCompletionFunction completion, void *param)
+{
+	if (count < 1 || count > 7)
+	{
+		wpi_fatal(I2CByteCountError);
+		return true;
+	}
+	return StartTransaction(request, &registerAddress, sizeof(registerAddress), count, completion, param);
+}
+
+/**
+ * The I2C queue task.
+ * 
+ * Takes the queued requests in order, runs them on the bus and completes them.
+ */
+void I2C::QueueTask()
+{
+	while (semTake(m_queueCount, WAIT_FOREVER) == OK)
+	{
+		I2CRequest *request;
+		{
+			Synchronized sync(m_queueSemaphore);
+			request = m_queueHead;
+			m_queueHead = request->m_next;
+			if (m_queueHead == NULL)
+			{
+				m_queueTail = NULL;
+			}
+		}
+
+		UINT32 data;
+		UINT32 dataHigh;
+		PackI2CData(request->m_dataToSend, request->m_sendSize, &data, &dataHigh);
+		request->m_aborted = request->m_device->DoTransaction(data, dataHigh, request->m_sendSize,
+			&data, &dataHigh, request->m_receiveSize, kQueueSpinTime);
+		UnpackI2CData(data, dataHigh, request->m_dataReceived, request->m_receiveSize);
+		request->m_timestamp = GetFPGATime();
+
+		if (request->m_completion != NULL)
+		{
+			request->m_completion(request, request->m_param);
+		}
+		// The owner may destroy the request as soon as it sees it completed, so
+		// this is the last access. Preemption is held off until both are done, so
+		// a waiter woken by the give never sees the request still pending.
+		taskLock();
+		semGive(request->m_doneSemaphore);
+		request->m_pending = false;
+		taskUnlock();
 	}
-	return aborted;
 }
 
 /**
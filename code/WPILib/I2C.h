@@ -10,6 +10,46 @@
 #include "SensorBase.h"
 
 class DigitalModule;
+class I2C;
+class I2CRequest;
+class Task;
+
+typedef void (*I2CCompletionFunction)(I2CRequest *request, void *param);
+
+/**
+ * Asynchronous I2C transaction.
+ * 
+ * A request is queued with I2C::StartTransaction() and carried out by the I2C
+ * queue task. The caller owns the request and must keep it (and the I2C object)
+ * alive until it completes. A request can be reused once it has completed.
+ */
+class I2CRequest
+{
+	friend class I2C;
+public:
+	I2CRequest();
+	virtual ~I2CRequest();
+	bool IsPending();
+	bool Wait(INT32 timeout = WAIT_FOREVER);
+	bool IsAborted();
+	const UINT8 *GetDataReceived();
+	UINT8 GetReceiveSize();
+	UINT32 GetTimestamp();
+
+private:
+	I2C *m_device;
+	UINT8 m_dataToSend[6];
+	UINT8 m_sendSize;
+	UINT8 m_dataReceived[7];
+	UINT8 m_receiveSize;
+	bool m_aborted;
+	UINT32 m_timestamp;
+	volatile bool m_pending;
+	I2CCompletionFunction m_completion;
+	void *m_param;
+	SEM_ID m_doneSemaphore;
+	I2CRequest *m_next;
+};
 
 /**
  * I2C bus interface class.
@@ -32,10 +72,29 @@ public:
 	void SetCompatibilityMode(bool enable);
 
 	bool VerifySensor(UINT8 registerAddress, UINT8 count, const UINT8 *expected);
+
+	bool StartTransaction(I2CRequest *request, UINT8 *dataToSend, UINT8 sendSize, UINT8 receiveSize,
+		I2CCompletionFunction completion = NULL, void *param = NULL);
+	bool StartWrite(I2CRequest *request, UINT8 registerAddress, UINT8 data,
+		I2CCompletionFunction completion = NULL, void *param = NULL);
+	bool StartRead(I2CRequest *request, UINT8 registerAddress, UINT8 count,
+		I2CCompletionFunction completion = NULL, void *param = NULL);
 private:
+	static const INT32 kQueuePriority = 100;	// above the robot task
+	static const UINT32 kQueueSpinTime = 50;
+
 	static SEM_ID m_semaphore;
+	static SEM_ID m_queueSemaphore;
+	static SEM_ID m_queueCount;
+	static I2CRequest *m_queueHead;
+	static I2CRequest *m_queueTail;
+	static Task *m_queueTask;
 
 	I2C(DigitalModule *module, UINT8 deviceAddress);
+	bool DoTransaction(UINT32 data, UINT32 dataHigh, UINT8 sendSize,
+		UINT32 *dataReceived, UINT32 *dataReceivedHigh, UINT8 receiveSize, UINT32 spinTime);
+	void WaitForTransaction(UINT8 transaction, UINT32 spinTime);
+	static void QueueTask();
 
 	DigitalModule *m_module;
 	UINT8 m_deviceAddress;
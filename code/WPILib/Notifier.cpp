@@ -6,16 +6,26 @@
 
 #include "Notifier.h"
 #include "Synchronized.h"
+#include "Task.h"
 #include "Timer.h"
 #include "Utility.h"
 #include "WPIStatus.h"
+#include "sysLib.h"
+#include <stdio.h>
+#include <string.h>
 
 const UINT32 Notifier::kTimerInterruptNumber;
-Notifier *Notifier::timerQueueHead = NULL;
+const int Notifier::kNotQueued;
+const INT32 Notifier::kStatisticsPriority;
+Notifier **Notifier::timerHeap = NULL;
+int Notifier::heapSize = 0;
+int Notifier::heapCapacity = 0;
 SEM_ID Notifier::queueSemaphore = NULL;
 tAlarm *Notifier::talarm = NULL;
 tInterruptManager *Notifier::manager = NULL;
 int Notifier::refcount = 0;
+Notifier *Notifier::notifierList = NULL;
+Task *Notifier::statisticsTask = NULL;
 
 /**
  * Create a Notifier for timer event notification.
@@ -31,8 +41,10 @@ Notifier::Notifier(TimerEventHandler handler, void *param)
 	m_periodic = false;
 	m_expirationTime = 0;
 	m_period = 0;
-	m_nextEvent = NULL;
-	m_queued = false;
+	m_heapIndex = kNotQueued;
+	m_name = NULL;
+	memset(&m_statistics, 0, sizeof(m_statistics));
+	m_statistics.minLatency = 0xFFFFFFFF;
 	m_handlerSemaphore = semBCreate(SEM_Q_PRIORITY, SEM_FULL);
 	if (queueSemaphore == NULL)
 	{
@@ -49,6 +61,21 @@ Notifier::Notifier(TimerEventHandler handler, void *param)
 			talarm = new tAlarm(&status);
 		}
 		refcount++;
+		m_nextNotifier = notifierList;
+		notifierList = this;
+		// Every Notifier can be queued, so the heap never grows from the handler task
+		if (refcount > heapCapacity)
+		{
+			int capacity = (heapCapacity == 0) ? 16 : heapCapacity * 2;
+			Notifier **heap = new Notifier *[capacity];
+			for (int i = 0; i < heapSize; i++)
+			{
+				heap[i] = timerHeap[i];
+			}
+			delete [] timerHeap;
+			timerHeap = heap;
+			heapCapacity = capacity;
+		}
 	}
 	wpi_assertCleanStatus(status);
 }
@@ -63,6 +90,14 @@ Notifier::~Notifier()
 	{
 		Synchronized sync(queueSemaphore);
 		DeleteFromQueue();
+		for (Notifier **npp = &notifierList; *npp != NULL; npp = &(*npp)->m_nextNotifier)
+		{
+			if (*npp == this)
+			{
+				*npp = m_nextNotifier;
+				break;
+			}
+		}
 
 		// Delete the static variables when the last one is going away
 		if (!(--refcount))
@@ -74,6 +109,9 @@ Notifier::~Notifier()
 			manager->disable(&status);
 			delete manager;
 			manager = NULL;
+			delete [] timerHeap;
+			timerHeap = NULL;
+			heapCapacity = 0;
 			wpi_assertCleanStatus(status);
 		}
 	}
@@ -95,10 +133,10 @@ Notifier::~Notifier()
 void Notifier::UpdateAlarm()
 {
 	tRioStatusCode status = 0;
-	if (timerQueueHead != NULL)
+	if (heapSize > 0)
 	{
 		// write the first item in the queue into the trigger time
-		talarm->writeTriggerTime((UINT32)(timerQueueHead->m_expirationTime * 1e6), &status);
+		talarm->writeTriggerTime((UINT32)(timerHeap[0]->m_expirationTime * 1e6), &status);
 		// Enable the alarm.  The hardware disables itself after each alarm.
 		talarm->writeEnable(true, &status);
 	}
@@ -119,30 +157,50 @@ void Notifier::ProcessQueue(tNIRIO_u32 mask, void *params)
 		{
 			Synchronized sync(queueSemaphore);
 			double currentTime = GetClock();
-			current = timerQueueHead;
-			if (current == NULL || current->m_expirationTime > currentTime)
+			if (heapSize == 0 || timerHeap[0]->m_expirationTime > currentTime)
 			{
 				break;		// no more timer events to process
 			}
 			// need to process this entry
-			timerQueueHead = current->m_nextEvent;
+			current = timerHeap[0];
+			NotifierStatistics *stats = &current->m_statistics;
+			UINT32 latency = (UINT32)((currentTime - current->m_expirationTime) * 1e6);
+			stats->calls++;
+			stats->totalLatency += latency;
+			if (latency < stats->minLatency) stats->minLatency = latency;
+			if (latency > stats->maxLatency) stats->maxLatency = latency;
 			if (current->m_periodic)
 			{
-				// if periodic, requeue the event
-				// compute when to put into queue
-				current->InsertInQueue(true);
+				// if periodic, requeue the event in place
+				current->m_expirationTime += current->m_period;
+				if (current->m_expirationTime <= currentTime)
+				{
+					// the next period is already overdue, it will be called back to back
+					stats->missedPeriods++;
+				}
+				SiftDown(0);
 			}
 			else
 			{
 				// not periodic; removed from queue
-				current->m_queued = false;
+				current->RemoveFromHeap();
 			}
 			// Take handler semaphore while holding queue semaphore to make sure
 			//  the handler will execute to completion in case we are being deleted.
 			semTake(current->m_handlerSemaphore, WAIT_FOREVER);
 		}
 
+		UINT32 startTime = GetFPGATime();
 		current->m_handler(current->m_param);	// call the event handler
+		UINT32 execTime = GetFPGATime() - startTime;
+		{
+			Synchronized sync(queueSemaphore);
+			current->m_statistics.totalExecTime += execTime;
+			if (execTime > current->m_statistics.maxExecTime)
+			{
+				current->m_statistics.maxExecTime = execTime;
+			}
+		}
 		semGive(current->m_handlerSemaphore);
 	}
 	// reschedule the first item in the queue
@@ -151,17 +209,80 @@ void Notifier::ProcessQueue(tNIRIO_u32 mask, void *params)
 }
 
 /**
- * Insert this Notifier into the timer queue in right place.
+ * Store a Notifier in the timer heap and remember its position.
+ * WARNING: this method does not do synchronization! It must be called from somewhere
+ * that is taking care of synchronizing access to the queue.
+ */
+void Notifier::SetHeapEntry(int index, Notifier *notifier)
+{
+	timerHeap[index] = notifier;
+	notifier->m_heapIndex = index;
+}
+
+/**
+ * Move a heap entry towards the top until its parent expires no later than it does.
+ * WARNING: this method does not do synchronization! It must be called from somewhere
+ * that is taking care of synchronizing access to the queue.
+ */
+void Notifier::SiftUp(int index)
+{
+	Notifier *notifier = timerHeap[index];
+	while (index > 0)
+	{
+		int parent = (index - 1) / 2;
+		if (timerHeap[parent]->m_expirationTime <= notifier->m_expirationTime)
+		{
+			break;
+		}
+		SetHeapEntry(index, timerHeap[parent]);
+		index = parent;
+	}
+	SetHeapEntry(index, notifier);
+}
+
+/**
+ * Move a heap entry towards the bottom until its children expire no earlier than it does.
+ * WARNING: this method does not do synchronization! It must be called from somewhere
+ * that is taking care of synchronizing access to the queue.
+ */
+void Notifier::SiftDown(int index)
+{
+	Notifier *notifier = timerHeap[index];
+	while (true)
+	{
+		int child = 2 * index + 1;
+		if (child >= heapSize)
+		{
+			break;
+		}
+		if (child + 1 < heapSize &&
+			timerHeap[child + 1]->m_expirationTime < timerHeap[child]->m_expirationTime)
+		{
+			child++;
+		}
+		if (notifier->m_expirationTime <= timerHeap[child]->m_expirationTime)
+		{
+			break;
+		}
+		SetHeapEntry(index, timerHeap[child]);
+		index = child;
+	}
+	SetHeapEntry(index, notifier);
+}
+
+/**
+ * Insert this Notifier into the timer queue.
+ * The queue is a binary heap, so inserting takes O(log n) regardless of how many
+ * Notifiers are queued.
  * WARNING: this method does not do synchronization! It must be called from somewhere
  * that is taking care of synchronizing access to the queue.
  * @param reschedule If false, the scheduled alarm is based on the curent time and UpdateAlarm
  * method is called which will enable the alarm if necessary.
- * If true, update the time by adding the period (no drift) when rescheduled periodic from ProcessQueue.
+ * If true, update the time by adding the period (no drift).
  * This ensures that the public methods only update the queue after finishing inserting.
  */
 void Notifier::InsertInQueue(bool reschedule)
 {
-	tRioStatusCode status = 0;
 	if (reschedule)
 	{
 		m_expirationTime += m_period;
@@ -170,33 +291,41 @@ void Notifier::InsertInQueue(bool reschedule)
 	{
 		m_expirationTime = GetClock() + m_period;
 	}
-	if (timerQueueHead == NULL || timerQueueHead->m_expirationTime >= this->m_expirationTime)
+	wpi_assert(heapSize < heapCapacity);
+	SetHeapEntry(heapSize++, this);
+	SiftUp(m_heapIndex);
+	if (m_heapIndex == 0 && !reschedule)
 	{
-		// the queue is empty or greater than the new entry
-		// the new entry becomes the first element
-		this->m_nextEvent = timerQueueHead;
-		timerQueueHead = this;
-		if (!reschedule)
-		{
-			// since the first element changed, update alarm, unless we already plan to
-			UpdateAlarm();
-		}
-		wpi_assertCleanStatus(status);
+		// since the first element changed, update alarm, unless we already plan to
+		UpdateAlarm();
 	}
-	else
+}
+
+/**
+ * Remove this Notifier from the timer heap without touching the alarm.
+ * WARNING: this method does not do synchronization! It must be called from somewhere
+ * that is taking care of synchronizing access to the queue.
+ */
+void Notifier::RemoveFromHeap()
+{
+	int index = m_heapIndex;
+	m_heapIndex = kNotQueued;
+	wpi_assert(heapSize > 0);
+	heapSize--;
+	if (index < heapSize)
 	{
-		for (Notifier **npp = &(timerQueueHead->m_nextEvent); ; npp = &(*npp)->m_nextEvent)
+		// fill the hole with the last entry and restore the heap order
+		Notifier *last = timerHeap[heapSize];
+		SetHeapEntry(index, last);
+		if (index > 0 && last->m_expirationTime < timerHeap[(index - 1) / 2]->m_expirationTime)
 		{
-			Notifier *n = *npp;
-			if (n == NULL || n->m_expirationTime > this->m_expirationTime)
-			{
-				*npp = this;
-				this->m_nextEvent = n;
-				break;
-			}
+			SiftUp(index);
+		}
+		else
+		{
+			SiftDown(index);
 		}
 	}
-	m_queued = true;
 }
 
 /**
@@ -208,27 +337,15 @@ void Notifier::InsertInQueue(bool reschedule)
  */
 void Notifier::DeleteFromQueue()
 {
-	if (m_queued)
+	if (m_heapIndex != kNotQueued)
 	{
-		m_queued = false;
-		wpi_assert(timerQueueHead != NULL);
-		if (timerQueueHead == this)
+		bool first = (m_heapIndex == 0);
+		RemoveFromHeap();
+		if (first)
 		{
-			// remove the first item in the list - update the alarm
-			timerQueueHead = this->m_nextEvent;
+			// removed the first item in the queue - update the alarm
 			UpdateAlarm();
 		}
-		else
-		{
-			for (Notifier *n = timerQueueHead; n != NULL; n = n->m_nextEvent)
-			{
-				if (n->m_nextEvent == this)
-				{
-					// this element is the next element from *n from the queue
-					n->m_nextEvent = this->m_nextEvent;	// point around this one
-				}
-			}
-		}
 	}
 }
 
@@ -277,3 +394,126 @@ void Notifier::Stop()
 	// Wait for a currently executing handler to complete before returning from Stop()
 	Synchronized sync(m_handlerSemaphore);
 }
+
+/**
+ * Set the name of this Notifier.
+ * The name identifies the Notifier in PrintStatistics.
+ * @param name The name. The string is not copied and must outlive the Notifier.
+ */
+void Notifier::SetName(const char *name)
+{
+	m_name = name;
+}
+
+/**
+ * Get the timing statistics of this Notifier.
+ * @param stats Receives a consistent copy of the statistics.
+ */
+void Notifier::GetStatistics(NotifierStatistics *stats)
+{
+	Synchronized sync(queueSemaphore);
+	*stats = m_statistics;
+}
+
+/**
+ * Reset the timing statistics of this Notifier.
+ */
+void Notifier::ResetStatistics()
+{
+	Synchronized sync(queueSemaphore);
+	memset(&m_statistics, 0, sizeof(m_statistics));
+	m_statistics.minLatency = 0xFFFFFFFF;
+}
+
+/**
+ * Print the timing statistics of all the Notifiers.
+ * The statistics are copied while the queue is locked and printed afterwards, so
+ * the queue is not locked while printing. At most kMaxPrintedNotifiers are printed.
+ */
+void Notifier::PrintStatistics()
+{
+	NotifierStatistics stats[kMaxPrintedNotifiers];
+	const char *names[kMaxPrintedNotifiers];
+	TimerEventHandler handlers[kMaxPrintedNotifiers];
+	double periods[kMaxPrintedNotifiers];
+	int count = 0;
+
+	if (queueSemaphore == NULL)
+	{
+		return;
+	}
+	{
+		Synchronized sync(queueSemaphore);
+		for (Notifier *n = notifierList; n != NULL && count < kMaxPrintedNotifiers; n = n->m_nextNotifier)
+		{
+			stats[count] = n->m_statistics;
+			names[count] = n->m_name;
+			handlers[count] = n->m_handler;
+			periods[count] = n->m_periodic ? n->m_period : 0.0;
+			count++;
+		}
+	}
+
+	printf("Notifier              period(ms)    calls   missed latency(us) min/avg/max  exec(us) avg/max\n");
+	for (int i = 0; i < count; i++)
+	{
+		NotifierStatistics *s = &stats[i];
+		UINT32 calls = (s->calls > 0) ? s->calls : 1;
+		if (names[i] != NULL)
+		{
+			printf("%-20.20s", names[i]);
+		}
+		else
+		{
+			printf("handler %-12p", handlers[i]);
+		}
+		printf("  %10.3f %8u %8u %8u/%8u/%8u  %8u/%8u\n",
+			periods[i] * 1000.0, s->calls, s->missedPeriods,
+			(s->calls > 0) ? s->minLatency : 0, (UINT32)(s->totalLatency / calls), s->maxLatency,
+			(UINT32)(s->totalExecTime / calls), s->maxExecTime);
+	}
+}
+
+/**
+ * Body of the low priority task that prints the statistics periodically.
+ * The task is made safe from deletion while it prints, so stopping it cannot leave
+ * the queue locked.
+ * @param ticks Clock ticks between two printouts.
+ */
+void Notifier::StatisticsTask(UINT32 ticks)
+{
+	while (true)
+	{
+		taskDelay(ticks);
+		taskSafe();
+		PrintStatistics();
+		taskUnsafe();
+	}
+}
+
+/**
+ * Print the timing statistics of all the Notifiers periodically.
+ * The printout runs in a low priority task rather than in the timer task, so
+ * printing to the console does not delay the other Notifiers.
+ * @param period Seconds between two printouts.
+ */
+void Notifier::StartStatisticsDump(double period)
+{
+	StopStatisticsDump();
+	UINT32 ticks = (UINT32)(period * sysClkRateGet());
+	if (ticks == 0)
+	{
+		ticks = 1;
+	}
+	statisticsTask = new Task("NotifierStatistics", (FUNCPTR)Notifier::StatisticsTask, kStatisticsPriority);
+	statisticsTask->Start(ticks);
+}
+
+/**
+ * Stop printing the timing statistics periodically.
+ */
+void Notifier::StopStatisticsDump()
+{
+	delete statisticsTask;
+	statisticsTask = NULL;
+}
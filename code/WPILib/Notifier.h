@@ -10,8 +10,26 @@
 #include "ChipObject.h"
 #include "Base.h"
 
+class Task;
+
 typedef void (*TimerEventHandler)(void *param);
 
+/**
+ * Timing statistics of a Notifier.
+ * Times are in microseconds. Latency is how late the handler was called
+ * relative to its scheduled expiration time.
+ */
+struct NotifierStatistics
+{
+	UINT32 calls;				// number of handler calls
+	UINT32 missedPeriods;		// periodic events that were already overdue when rescheduled
+	UINT32 minLatency;
+	UINT32 maxLatency;
+	double totalLatency;
+	UINT32 maxExecTime;			// longest handler execution time
+	double totalExecTime;
+};
+
 class Notifier
 {
 public:
@@ -20,25 +38,46 @@ public:
 	void StartSingle(double delay);
 	void StartPeriodic(double period);
 	void Stop();
+	void SetName(const char *name);
+	void GetStatistics(NotifierStatistics *stats);
+	void ResetStatistics();
+
+	static void PrintStatistics();
+	static void StartStatisticsDump(double period);
+	static void StopStatisticsDump();
 private:
-	static Notifier *timerQueueHead;
+	static Notifier **timerHeap;		// binary min-heap ordered by expiration time
+	static int heapSize;				// number of queued Notifiers
+	static int heapCapacity;			// number of allocated heap entries
 	static SEM_ID queueSemaphore;
 	static tAlarm *talarm;
 	static tInterruptManager *manager;
 	static int refcount;
+	static Notifier *notifierList;		// all Notifiers, for the statistics dump
+	static Task *statisticsTask;		// prints the statistics periodically
 
 	static const UINT32 kTimerInterruptNumber = 28;
+	static const int kNotQueued = -1;
+	static const int kMaxPrintedNotifiers = 32;
+	static const INT32 kStatisticsPriority = 150;
+	static void StatisticsTask(UINT32 ticks);
 	static void ProcessQueue(tNIRIO_u32 mask, void *params); // process the timer queue on a timer event
 	static void UpdateAlarm();			// update the FPGA alarm since the queue has changed
+	static void SetHeapEntry(int index, Notifier *notifier);
+	static void SiftUp(int index);
+	static void SiftDown(int index);
 	void InsertInQueue(bool reschedule);	// insert this Notifier in the timer queue
 	void DeleteFromQueue();				// delete this Notifier from the timer queue
+	void RemoveFromHeap();				// remove this Notifier from the heap, leaving the alarm alone
 	TimerEventHandler m_handler;			// address of the handler
 	void *m_param;							// a parameter to pass to the handler
 	double m_period;						// the relative time (either periodic or single)
 	double m_expirationTime;				// absolute expiration time for the current event
-	Notifier *m_nextEvent;					// next Nofifier event
+	int m_heapIndex;						// position in the timer heap or kNotQueued
 	bool m_periodic;						// true if this is a periodic event
-	bool m_queued;							// indicates if this entry is queued
+	const char *m_name;						// name shown by PrintStatistics
+	Notifier *m_nextNotifier;				// next Notifier in notifierList
+	NotifierStatistics m_statistics;		// protected by queueSemaphore
 	SEM_ID m_handlerSemaphore;				// held by interrupt manager task while handler call is in progress 
 	DISALLOW_COPY_AND_ASSIGN(Notifier);
 };
@@ -272,6 +272,27 @@ void RobotDrive::TankDrive(GenericHID &leftStick, UINT32 leftAxis,
 	TankDrive(leftStick.GetRawAxis(leftAxis), rightStick.GetRawAxis(rightAxis));
 }
 
+/**
+ * Provide tank steering using the stored robot configuration.
+ * The axes are read from the joystick states of a DriverStation snapshot, so the values
+ * are already converted and shaped.
+ * @param leftStick The joystick state to use for the left side of the robot.
+ * @param leftAxis The axis to select on the left side joystick, 1 - 6.
+ * @param rightStick The joystick state to use for the right side of the robot.
+ * @param rightAxis The axis to select on the right side joystick, 1 - 6.
+ */
+void RobotDrive::TankDrive(const DriverStation::StickState &leftStick, UINT32 leftAxis,
+		const DriverStation::StickState &rightStick, UINT32 rightAxis)
+{
+	if (leftAxis < 1 || leftAxis > DriverStation::kJoystickAxes ||
+		rightAxis < 1 || rightAxis > DriverStation::kJoystickAxes)
+	{
+		wpi_fatal(BadJoystickAxis);
+		return;
+	}
+	TankDrive(leftStick.axes[leftAxis - 1], rightStick.axes[rightAxis - 1]);
+}
+
 
 /**
  * Provide tank steering using the stored robot configuration.
@@ -375,6 +396,29 @@ void RobotDrive::ArcadeDrive(GenericHID &moveStick, UINT32 moveAxis,
 	ArcadeDrive(moveValue, rotateValue, squaredInputs);
 }
 
+/**
+ * Arcade drive implements single stick driving.
+ * The axes are read from the joystick states of a DriverStation snapshot, so the values
+ * are already converted and shaped. Pass the same state twice for single stick driving.
+ * @param moveStick The joystick state that represents the forward/backward direction
+ * @param moveAxis The axis on the moveStick to use for fowards/backwards (typically Y_AXIS)
+ * @param rotateStick The joystick state that represents the rotation value
+ * @param rotateAxis The axis on the rotateStick to use for the rotate right/left (typically X_AXIS)
+ * @param squaredInputs Setting this parameter to true increases the sensitivity at lower speeds
+ */
+void RobotDrive::ArcadeDrive(const DriverStation::StickState &moveStick, UINT32 moveAxis,
+								const DriverStation::StickState &rotateStick, UINT32 rotateAxis,
+								bool squaredInputs)
+{
+	if (moveAxis < 1 || moveAxis > DriverStation::kJoystickAxes ||
+		rotateAxis < 1 || rotateAxis > DriverStation::kJoystickAxes)
+	{
+		wpi_fatal(BadJoystickAxis);
+		return;
+	}
+	ArcadeDrive(moveStick.axes[moveAxis - 1], rotateStick.axes[rotateAxis - 1], squaredInputs);
+}
+
 /**
  * Arcade drive implements single stick driving.
  * This function lets you directly provide joystick values from any source.
@@ -12,6 +12,7 @@
 #include <vxWorks.h>
 #include "MotorSafety.h"
 #include "MotorSafetyHelper.h"
+#include "DriverStation.h"
 
 class SpeedController;
 class GenericHID;
@@ -51,11 +52,15 @@ public:
 	void TankDrive(GenericHID &leftStick, GenericHID &rightStick);
 	void TankDrive(GenericHID *leftStick, UINT32 leftAxis, GenericHID *rightStick, UINT32 rightAxis);
 	void TankDrive(GenericHID &leftStick, UINT32 leftAxis, GenericHID &rightStick, UINT32 rightAxis);
+	void TankDrive(const DriverStation::StickState &leftStick, UINT32 leftAxis,
+			const DriverStation::StickState &rightStick, UINT32 rightAxis);
 	void TankDrive(float leftValue, float rightValue);
 	void ArcadeDrive(GenericHID *stick, bool squaredInputs = true);
 	void ArcadeDrive(GenericHID &stick, bool squaredInputs = true);
 	void ArcadeDrive(GenericHID *moveStick, UINT32 moveChannel, GenericHID *rotateStick, UINT32 rotateChannel, bool squaredInputs = true);
 	void ArcadeDrive(GenericHID &moveStick, UINT32 moveChannel, GenericHID &rotateStick, UINT32 rotateChannel, bool squaredInputs = true);
+	void ArcadeDrive(const DriverStation::StickState &moveStick, UINT32 moveAxis,
+			const DriverStation::StickState &rotateStick, UINT32 rotateAxis, bool squaredInputs = true);
 	void ArcadeDrive(float moveValue, float rotateValue, bool squaredInputs = true);
 	void MecanumDrive_Cartesian(float x, float y, float rotation, float gyroAngle = 0.0);
 	void MecanumDrive_Polar(float magnitude, float direction, float rotation);
@@ -8,17 +8,28 @@
 #include "DriverStation.h"
 #include "SmartDashboard.h"
 #include "SmartDashboardPacketFactory.h"
+#include <math.h>
+
+// Keeps the compiler from moving memory accesses across the staging sequence updates.
+#define COMPILER_BARRIER() __asm__ __volatile__("" ::: "memory")
 
 const INT32 SmartDashboard::BUFFER_SIZE = 768;
+const SmartDashboard::FieldHandle SmartDashboard::kInvalidField;
+const INT32 SmartDashboard::kMaxHandleFields;
 const double SmartDashboard::REANNOUNCEMENT_INTERVAL_SEC = 5.0;
 SmartDashboard* SmartDashboard::instance =
 	new SmartDashboard(DriverStation::GetInstance()->GetUserStatusDataSem());
 bool SmartDashboard::initialized = false;
 
 SmartDashboard::SmartDashboard(SEM_ID statusDataSemaphore)
-	: m_buff(BUFFER_SIZE),
+	: m_buffA(BUFFER_SIZE),
+	  m_buffB(BUFFER_SIZE),
+	  m_buff(&m_buffA),
+	  m_sendBuff(&m_buffB),
+	  m_reannounceNext(0),
 	  m_reannouncementTimer(),
-	  m_userStatusDataSem(statusDataSemaphore) {
+	  m_userStatusDataSem(statusDataSemaphore),
+	  m_numHandleFields(0) {
 	m_reannouncementTimer.Reset();
 	m_reannouncementTimer.Start();
 }
@@ -35,8 +46,13 @@ void SmartDashboard::init() {
  */
 void SmartDashboard::GetStatusBuffer(char** userStatusData,
 		INT32* userStatusDataSize) {
-	*userStatusData = m_buff.GetBuffer();
-	*userStatusDataSize = m_buff.GetBufferSize();
+	WriteHandleFields();
+	ReannounceFields();
+	Buffer* filled = m_buff;
+	m_buff = m_sendBuff;
+	m_sendBuff = filled;
+	*userStatusData = m_sendBuff->GetBuffer();
+	*userStatusDataSize = m_sendBuff->GetBufferSize();
 }
 
 /**
@@ -121,9 +137,7 @@ SmartDashboard::RETCODE SmartDashboard::Log(const char* value, const char* name)
 		return ERROR_STRING_TOO_LONG;
 	if ((code = instance->UpdatePrefix(name, length + 2)) != SUCCESS)
 		return code;
-	instance->m_buff.WriteUTF(value);
-
-	instance->PeriodicallyReannounce();
+	instance->m_buff->WriteUTF(value);
 
 	DriverStation::GetInstance()->IncrementUpdateNumber();
 
@@ -149,65 +163,315 @@ SmartDashboard::RETCODE SmartDashboard::LogNumber(INT64 value, int numBytes,
 	if ((code = instance->UpdatePrefix(name, numBytes)) != SUCCESS)
 		return code;
 	for (int shift = (numBytes - 1) * 8; shift >= 0; shift -= 8) {
-		instance->m_buff.WriteByte((value >> shift) & 0xFF);
+		instance->m_buff->WriteByte((value >> shift) & 0xFF);
 	}
 
-	instance->PeriodicallyReannounce();
-
 	DriverStation::GetInstance()->IncrementUpdateNumber();
 
 	return SUCCESS;
 	// *** End Critical Region (upon auto-destruction of sync) ***
 }
 
+/**
+ * Register a field to be logged through its handle.
+ * The field is announced right away if there is room. Logging it through the
+ * handle skips the name lookup and the semaphore, so it is cheap enough to log
+ * dozens of values every loop. Registering the same name twice returns the same handle.
+ * Only values that changed by more than the tolerance since the last value sent
+ * are transmitted. The value is converted to the declared type, so declaring
+ * e.g. FLOAT_TYPE or SHORT_TYPE for a value logged as a double sends fewer bytes.
+ * Values outside the range of a BYTE_TYPE, SHORT_TYPE or INT_TYPE field are
+ * clamped to the range, e.g. 300.0 is sent as 127 in a BYTE_TYPE field.
+ * The field is registered even if its announcement does not fit in the current
+ * packet. It is then announced with a later packet, and its values are held
+ * back until it has been announced.
+ * SmartDashboard assumes the name string will remain valid. It does not make a copy.
+ * @param name The name of the field.
+ * @param type The type sent to the dashboard. Strings and characters are not supported.
+ * @param tolerance Changes up to this much are not sent.
+ * @param priority Higher priority fields are sent first when the packet is full.
+ * @return The handle of the field, or kInvalidField if it could not be registered
+ * or the name was already logged with a different type.
+ */
+SmartDashboard::FieldHandle SmartDashboard::RegisterField(const char* name,
+		FIELD_TYPE type, double tolerance, FIELD_PRIORITY priority) {
+	if (!initialized)
+		init();
+
+	UINT8 size;
+	switch (type) {
+	case BYTE_TYPE: case BOOL_TYPE: size = 1; break;
+	case SHORT_TYPE: size = 2; break;
+	case INT_TYPE: case FLOAT_TYPE: size = 4; break;
+	case LONG_TYPE: case DOUBLE_TYPE: size = 8; break;
+	default: return kInvalidField;
+	}
+
+	Synchronized sync(instance->m_userStatusDataSem);
+
+	// a field that does not fit is announced by ReannounceFields() later
+	instance->AnnounceIfNecessary(type, name, true);
+	FieldRecord &r = instance->m_fields[name];
+	// the dashboard decodes the field with the type it was announced with
+	if (r.type != type)
+		return kInvalidField;
+	if (r.handle != kInvalidField)
+		return r.handle;
+	if (instance->m_numHandleFields >= kMaxHandleFields)
+		return kInvalidField;
+
+	HandleField &field = instance->m_handleFields[instance->m_numHandleFields];
+	field.id = r.id;
+	field.size = size;
+	field.type = type;
+	field.priority = priority;
+	field.tolerance = tolerance;
+	field.reference = 0.0;
+	field.longReference = 0;
+	field.staged = false;
+	field.sequence = 0;
+	field.dirty = false;
+	r.handle = instance->m_numHandleFields++;
+	instance->m_fieldsById[r.id].handle = r.handle;
+	return r.handle;
+}
+
+/**
+ * Log a 32-bit signed integer value to a registered field.
+ */
+SmartDashboard::RETCODE SmartDashboard::LogField(FieldHandle field, INT32 value) {
+	return StageField(field, value);
+}
+
+/**
+ * Log a 64-bit signed integer value to a registered field.
+ * A LONG_TYPE field keeps the full 64 bits.
+ */
+SmartDashboard::RETCODE SmartDashboard::LogField(FieldHandle field, INT64 value) {
+	return StageLongField(field, value);
+}
+
+/**
+ * Log a boolean value to a registered field.
+ */
+SmartDashboard::RETCODE SmartDashboard::LogField(FieldHandle field, bool value) {
+	return StageField(field, value ? 1.0 : 0.0);
+}
+
+/**
+ * Log a single precision floating point value to a registered field.
+ */
+SmartDashboard::RETCODE SmartDashboard::LogField(FieldHandle field, float value) {
+	return StageField(field, value);
+}
+
+/**
+ * Log a double precision floating point value to a registered field.
+ */
+SmartDashboard::RETCODE SmartDashboard::LogField(FieldHandle field, double value) {
+	return StageField(field, value);
+}
+
+/**
+ * Stage the value of a handle field for the next status packet.
+ * The value is dropped if it is within the tolerance of the last staged value.
+ * Otherwise it is encoded in the declared type of the field.
+ * This does not take the status data semaphore. Only one task may log a given
+ * field. The sequence number lets the DriverStation task skip a value that is
+ * being written; it is then sent with the next packet.
+ * Returns ERR_INVALID_FIELD if the handle was not returned by RegisterField().
+ */
+SmartDashboard::RETCODE SmartDashboard::StageField(FieldHandle handle, double dvalue) {
+	if (handle < 0 || handle >= instance->m_numHandleFields)
+		return ERR_INVALID_FIELD;
+	HandleField &field = instance->m_handleFields[handle];
+	if (field.staged && fabs(dvalue - field.reference) <= field.tolerance)
+		return SUCCESS;
+	field.reference = dvalue;
+	field.staged = true;
+
+	INT64 value;
+	if (field.type == FLOAT_TYPE) {
+		float fvalue = (float) dvalue;
+		value = *reinterpret_cast<INT32*>(&fvalue);
+	} else if (field.type == DOUBLE_TYPE) {
+		value = *reinterpret_cast<INT64*>(&dvalue);
+	} else {
+		// out of range values are clamped rather than wrapped
+		double minValue = dvalue, maxValue = dvalue;
+		switch (field.type) {
+		case BYTE_TYPE: minValue = -128.0; maxValue = 127.0; break;
+		case SHORT_TYPE: minValue = -32768.0; maxValue = 32767.0; break;
+		case INT_TYPE: minValue = -2147483648.0; maxValue = 2147483647.0; break;
+		default: break;
+		}
+		if (dvalue < minValue)
+			dvalue = minValue;
+		else if (dvalue > maxValue)
+			dvalue = maxValue;
+		value = (INT64) ((dvalue < 0.0) ? dvalue - 0.5 : dvalue + 0.5);
+		field.longReference = value;
+	}
+	WriteFieldValue(field, value);
+	return SUCCESS;
+}
+
+/**
+ * Stage a 64-bit integer value of a handle field.
+ * A LONG_TYPE field is staged as is, so values beyond 2^53 keep their
+ * precision. Other types have no 64-bit encoding and go through StageField().
+ */
+SmartDashboard::RETCODE SmartDashboard::StageLongField(FieldHandle handle, INT64 value) {
+	if (handle < 0 || handle >= instance->m_numHandleFields)
+		return ERR_INVALID_FIELD;
+	HandleField &field = instance->m_handleFields[handle];
+	if (field.type != LONG_TYPE)
+		return StageField(handle, (double) value);
+	if (field.staged && fabs((double) (value - field.longReference)) <= field.tolerance)
+		return SUCCESS;
+	field.reference = (double) value;
+	field.longReference = value;
+	field.staged = true;
+	WriteFieldValue(field, value);
+	return SUCCESS;
+}
+
+/**
+ * Write an encoded value into a handle field and mark it for sending.
+ */
+void SmartDashboard::WriteFieldValue(HandleField &field, INT64 value) {
+	field.sequence++;
+	COMPILER_BARRIER();
+	for (int i = field.size - 1; i >= 0; i--) {
+		field.value[i] = value & 0xFF;
+		value >>= 8;
+	}
+	COMPILER_BARRIER();
+	field.sequence++;
+	field.dirty = true;
+}
+
+/**
+ * Write the handle fields with new values into the status buffer.
+ * Called by the DriverStation task while holding the status data semaphore.
+ * Fields are written in priority order. Fields that do not fit stay dirty and
+ * are sent with the next packet.
+ */
+void SmartDashboard::WriteHandleFields() {
+	bool updated = false;
+	for (INT32 n = 0; n < NUM_PRIORITIES * m_numHandleFields; n++) {
+		HandleField &field = m_handleFields[n % m_numHandleFields];
+		if (field.priority != n / m_numHandleFields || !field.dirty)
+			continue;
+		// the dashboard cannot decode a value before the announcement
+		if (!m_fieldsById[field.id].announced)
+			continue;
+		if (!m_buff->HasRoom(SmartDashboardPacketFactory::GetUpdateLength(field.size)))
+			continue;
+
+		UINT8 value[8];
+		field.dirty = false;
+		UINT32 sequence = field.sequence;
+		COMPILER_BARRIER();
+		memcpy(value, field.value, field.size);
+		COMPILER_BARRIER();
+		if ((sequence & 1) != 0 || sequence != field.sequence) {
+			// being written by a preempted task; send it next time
+			field.dirty = true;
+			continue;
+		}
+
+		SmartDashboardPacketFactory::UpdatePrefix(*m_buff, field.id, field.size);
+		for (int j = 0; j < field.size; j++) {
+			m_buff->WriteByte(value[j]);
+		}
+		updated = true;
+	}
+	if (updated)
+		DriverStation::GetInstance()->IncrementUpdateNumber();
+}
+
+/**
+ * Add a new field and announce it.
+ * If the announcement does not fit, the field is not added and ERR_BUFFER_FULL
+ * is returned, unless defer is set. A deferred field is added anyway and is
+ * announced by ReannounceFields() with a later packet. Until then, logging
+ * to the field by name also returns ERR_BUFFER_FULL.
+ */
 SmartDashboard::RETCODE SmartDashboard::AnnounceIfNecessary(FIELD_TYPE type,
-		const char* name) {
+		const char* name, bool defer) {
 	if (m_fields.count(name) < 1) {
-		if (!m_buff.HasRoom(
-				SmartDashboardPacketFactory::GetAnnounceLength(name)))
+		bool fits = m_buff->HasRoom(
+				SmartDashboardPacketFactory::GetAnnounceLength(name));
+		if (!fits && !defer)
 			return ERR_BUFFER_FULL;
 
 		FieldRecord r;
 		r.name = name;
 		r.type = type;
 		r.id = m_fields.size();
+		r.handle = kInvalidField;
+		r.announced = fits;
 
 		m_fields[name] = r;
+		m_fieldsById.push_back(r);
+		if (!fits)
+			return ERR_BUFFER_FULL;
+		// a new field needs no re-announcement until the next round
+		if (m_reannounceNext == (UINT32) r.id)
+			m_reannounceNext++;
 
-		SmartDashboardPacketFactory::Announce(m_buff, r.id, r.type, r.name);
+		SmartDashboardPacketFactory::Announce(*m_buff, r.id, r.type, r.name);
 		DriverStation::GetInstance()->IncrementUpdateNumber();
+	} else if (!m_fieldsById[m_fields[name].id].announced) {
+		// no values can be sent until the deferred announcement goes out
+		return ERR_BUFFER_FULL;
 	}
 
 	return SUCCESS;
 }
 
-/** Periodically re-announce all fields for receivers that tune in late. */
-void SmartDashboard::PeriodicallyReannounce() {
-	if (m_reannouncementTimer.HasPeriodPassed(REANNOUNCEMENT_INTERVAL_SEC)) {
-		for (FieldMap::iterator it = m_fields.begin(); it != m_fields.end(); it++) {
-			FieldRecord &r = it->second;
-			if (m_buff.HasRoom(SmartDashboardPacketFactory::GetAnnounceLength(r.name))) {
-				SmartDashboardPacketFactory::Announce(m_buff, r.id, r.type, r.name);
-			} else {
-				// there isn't enough room for this name but there might be room
-				// for a shorter name; hopefully there'll be room next time
-			}
+/**
+ * Periodically re-announce all fields for receivers that tune in late.
+ * Called by the DriverStation task while holding the status data semaphore.
+ * The announcements only use the room left after the values, and a round of
+ * announcements is spread over as many packets as it takes. A re-announced
+ * handle field also has its value sent again. Deferred fields that were never
+ * announced are always picked up by the round in progress.
+ */
+void SmartDashboard::ReannounceFields() {
+	if (m_reannounceNext >= m_fieldsById.size()) {
+		if (!m_reannouncementTimer.HasPeriodPassed(REANNOUNCEMENT_INTERVAL_SEC))
+			return;
+		m_reannounceNext = 0;
+	}
+	while (m_reannounceNext < m_fieldsById.size()) {
+		FieldRecord &r = m_fieldsById[m_reannounceNext];
+		if (!m_buff->HasRoom(SmartDashboardPacketFactory::GetAnnounceLength(r.name)))
+			break;
+		SmartDashboardPacketFactory::Announce(*m_buff, r.id, r.type, r.name);
+		if (!r.announced) {
+			r.announced = true;
+			DriverStation::GetInstance()->IncrementUpdateNumber();
 		}
+		if (r.handle != kInvalidField && m_handleFields[r.handle].staged)
+			m_handleFields[r.handle].dirty = true;
+		m_reannounceNext++;
 	}
 }
 
 SmartDashboard::RETCODE SmartDashboard::UpdatePrefix(const char* name,
 		int dataLen) {
-	if (!m_buff.HasRoom(SmartDashboardPacketFactory::GetUpdateLength(dataLen)))
+	if (!m_buff->HasRoom(SmartDashboardPacketFactory::GetUpdateLength(dataLen)))
 		return ERR_BUFFER_FULL;
 
 	FieldRecord& r = m_fields[name];
-	SmartDashboardPacketFactory::UpdatePrefix(m_buff, r.id, dataLen);
+	SmartDashboardPacketFactory::UpdatePrefix(*m_buff, r.id, dataLen);
 	return SUCCESS;
 }
 
 void SmartDashboard::Flush() {
-	m_buff.Flush();
+	m_sendBuff->Flush();
 }
 
 
@@ -12,6 +12,7 @@
 #include <vxWorks.h>
 #include <cstring>
 #include <map>
+#include <vector>
 
 using std::map;
 
@@ -23,10 +24,17 @@ public:
 		SHORT_TYPE = 4, FLOAT_TYPE = 5, DOUBLE_TYPE = 6, STRING_UTF16_TYPE = 7,
 		BOOL_TYPE = 8, STRING_UTF8_TYPE = 9
 	} FIELD_TYPE;
-	typedef enum { SUCCESS, ERR_BUFFER_FULL, ERROR_STRING_TOO_LONG } RETCODE;
+	typedef enum { SUCCESS, ERR_BUFFER_FULL, ERROR_STRING_TOO_LONG, ERR_INVALID_FIELD } RETCODE;
+	// When the status packet is short on space, higher priority fields are sent first.
+	typedef enum { PRIORITY_HIGH = 0, PRIORITY_NORMAL = 1, PRIORITY_LOW = 2, NUM_PRIORITIES = 3 } FIELD_PRIORITY;
 
 	static const INT32 BUFFER_SIZE;
 
+	// Handle of a field registered with RegisterField().
+	typedef INT32 FieldHandle;
+	static const FieldHandle kInvalidField = -1;
+	static const INT32 kMaxHandleFields = 64;
+
 	explicit SmartDashboard(SEM_ID statusDataSemaphore);
 
 	//** Initialize the SmartDashboard. The Log() methods will call this if needed. */
@@ -43,6 +51,15 @@ public:
 	static RETCODE Log(double value, const char* name);
 	static RETCODE Log(const char* value, const char* name);
 
+	/** Register a field once and log it through its handle every loop. */
+	static FieldHandle RegisterField(const char* name, FIELD_TYPE type,
+			double tolerance = 0.0, FIELD_PRIORITY priority = PRIORITY_NORMAL);
+	static RETCODE LogField(FieldHandle field, INT32 value);
+	static RETCODE LogField(FieldHandle field, INT64 value);
+	static RETCODE LogField(FieldHandle field, bool value);
+	static RETCODE LogField(FieldHandle field, float value);
+	static RETCODE LogField(FieldHandle field, double value);
+
 	void Flush();
 
 	class Buffer {
@@ -69,6 +86,22 @@ private:
 		int id;
 		FIELD_TYPE type;
 		const char* name;
+		FieldHandle handle;
+		bool announced;		// false until a deferred announcement is sent
+	};
+	// The latest value of a handle field, staged until the next status packet.
+	struct HandleField {
+		UINT8 id;
+		UINT8 size;
+		FIELD_TYPE type;
+		FIELD_PRIORITY priority;
+		double tolerance;			// changes up to this much are not sent
+		double reference;			// last value staged for sending
+		INT64 longReference;		// reference of a LONG_TYPE field, exact
+		bool staged;				// reference is valid
+		volatile UINT32 sequence;	// odd while the value is being written
+		volatile bool dirty;		// a new value has not been sent yet
+		UINT8 value[8];				// big-endian
 	};
 	struct CStringLessThan {
 		bool operator()(const char* s1, const char* s2) const {
@@ -81,19 +114,33 @@ private:
 	static bool initialized;
 	static SmartDashboard* GetInstance() {return instance;}
 
-	Buffer m_buff;
+	// The user writes into m_buff while the DriverStation task sends m_sendBuff.
+	// They are swapped in GetStatusBuffer() rather than copied.
+	Buffer m_buffA;
+	Buffer m_buffB;
+	Buffer* m_buff;
+	Buffer* m_sendBuff;
 	typedef map<const char*, FieldRecord, CStringLessThan> FieldMap;
 	FieldMap m_fields;
+	std::vector<FieldRecord> m_fieldsById;
+	UINT32 m_reannounceNext;	// next field ID to re-announce
 	Timer m_reannouncementTimer;
 	SEM_ID m_userStatusDataSem;
+	HandleField m_handleFields[kMaxHandleFields];
+	INT32 m_numHandleFields;
 
 	DISALLOW_COPY_AND_ASSIGN(SmartDashboard);
 
 	static RETCODE LogNumber(INT64 value, int numBytes, FIELD_TYPE type,
 			const char* name);
-	RETCODE AnnounceIfNecessary(FIELD_TYPE type, const char* name);
-	void PeriodicallyReannounce();
+	RETCODE AnnounceIfNecessary(FIELD_TYPE type, const char* name,
+			bool defer = false);
+	void ReannounceFields();
 	RETCODE UpdatePrefix(const char* name, int dataLength);
+	static RETCODE StageField(FieldHandle field, double value);
+	static RETCODE StageLongField(FieldHandle field, INT64 value);
+	static void WriteFieldValue(HandleField &field, INT64 value);
+	void WriteHandleFields();
 };
 
 #endif
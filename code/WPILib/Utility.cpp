@@ -159,6 +159,8 @@ static void wpiSelfTrace()
 
 static bool stackTraceEnabled = false;
 static bool suspendOnAssertEnabled = false;
+static WPIFatalHook fatalHook = NULL;
+static void *fatalHookParam = NULL;
 
 /**
  * Enable Stack trace after asserts.
@@ -179,6 +181,17 @@ void wpi_suspendOnAssertEnabled(bool enabled)
 	suspendOnAssertEnabled = enabled;
 }
 
+/**
+ * Set a function to be called after a fatal error is reported.
+ * This allows the user program to save its state (e.g. a flight recorder)
+ * before the robot is restarted. Pass NULL to remove the hook.
+ */
+void wpi_setFatalHook(WPIFatalHook hook, void *param)
+{
+	fatalHookParam = param;
+	fatalHook = hook;
+}
+
 static void wpi_handleTracing()
 {
 	if (stackTraceEnabled)
@@ -359,6 +372,8 @@ void wpi_fatal_impl(const INT32 statusCode, const char *statusString,
 	setErrorData(error, strlen(error), 100);
 
 	wpi_handleTracing();
+	if (fatalHook != NULL)
+		fatalHook(fatalHookParam, statusCode, fileName, lineNumber);
 }
 
 
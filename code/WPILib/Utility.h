@@ -37,6 +37,9 @@ void wpi_fatal_impl(const INT32 statusCode, const char *statusString, const char
 
 void wpi_suspendOnAssertEnabled(bool enabled);
 void wpi_stackTraceEnable(bool enabled);
+typedef void (*WPIFatalHook)(void *param, INT32 statusCode,
+							 const char *fileName, UINT32 lineNumber);
+void wpi_setFatalHook(WPIFatalHook hook, void *param);
 
 UINT16 GetFPGAVersion();
 UINT32 GetFPGARevision();
@@ -25,6 +25,7 @@
 #include "DigitalModule.h"
 #include "DigitalOutput.h"
 #include "DigitalSource.h"
+#include "DMA.h"
 #include "DoubleSolenoid.h"
 #include "DriverStation.h"
 #include "DriverStationEnhancedIO.h"
@@ -45,6 +45,8 @@ S(EnhancedIOMissing, -26, "IO is not attached or Enhanced IO is not enabled.");
 S(LineNotOutput, -27, "Cannot SetDigitalOutput for a line not configured for output.");
 S(ParameterOutOfRange, -28, "A parameter is out of range.");
 S(SPIClockRateTooLow, -29, "SPI clock rate was below the minimum supported");
+S(DMAConfigWhileRunning, -30, "DMA sensors cannot be added while DMA is running");
+S(DMAGroupNotCaptured, -31, "The DMA sample does not contain the requested sensor");
 /*
  * Warnings
  */
@@ -24,6 +24,25 @@
 #endif
 #define MOD_NAME                "CoopMTRobot"
 
+//
+// Loop timing statistics.
+//
+#define LOOPSTAT_INPUT_TASKS    0
+#define LOOPSTAT_PERIODIC       1
+#define LOOPSTAT_ACTION_TASKS   2
+#define LOOPSTAT_LOOP_TIME      3
+#define LOOPSTAT_PERIOD         4
+#define LOOPSTAT_JITTER         5
+#define NUM_LOOPSTATS           6
+
+//
+// The robot loop blocks until woken up by new Driver Station data or a
+// timebase tick. The wake timeout makes sure the watchdog is still fed and
+// mode changes are still noticed if both stop coming.
+//
+#define LOOP_WAKE_TIMEOUT       0.1     //in seconds
+#define STATUS_UPDATE_PERIOD    100000  //in usec
+
 /**
  * This class defines and implements the CoopMTRobot object. The CoopMTRobot
  * object implements a cooperative multitasking robot. It inherits the
@@ -31,7 +50,9 @@
  * loop at various points, it will do callbacks to the registered subsystems.
  * This basically simulates a cooperative multitasking scheduler that task
  * switches between different subsystems allowing them to execute in various
- * contexts.
+ * contexts. Subsystems registered in the control or telemetry rate groups
+ * are called at their own rate off a single timebase Notifier, so closed
+ * loop control can run faster than the Driver Station packets.
  */
 class CoopMTRobot: public RobotBase
 {
@@ -40,6 +61,245 @@ private:
     double          m_loopPeriod;
     Timer           m_loopTimer;
     UINT32          m_periodPacket;     //in ms
+    //
+    // Loop timing statistics, all times are in usec.
+    //
+    TrcHistogram    m_loopStats[NUM_LOOPSTATS];
+    UINT32          m_timeAutonomousPeriod;
+    UINT32          m_timeTeleOpPeriod;
+    UINT32          m_cntAutonomousLoops;
+    UINT32          m_cntTeleOpLoops;
+    UINT32          m_timePrevLoop;
+    //
+    // Rate groups other than the operator rate group are driven by a
+    // single FPGA alarm based Notifier, all times are in usec. The robot
+    // loop sleeps on the wake semaphore which is given by the timebase
+    // Notifier and by the Driver Station when new data arrives.
+    //
+    Notifier       *m_timebase;
+    SEM_ID          m_wakeSem;
+    int             m_wakeTimeout;      //in ticks
+    UINT32          m_rateGroupPeriod[MAX_NUM_RATEGROUPS];
+    UINT32          m_rateGroupNext[MAX_NUM_RATEGROUPS];
+    bool            m_rateGroupActive[MAX_NUM_RATEGROUPS];
+    //
+    // Throttled status display.
+    //
+    DriverStationLCD *m_statusLCD;
+    UINT32          m_statusContext;
+    UINT32          m_statusNextUpdate;
+
+    /**
+     * This function is called by the timebase Notifier on every tick to
+     * wake up the robot loop.
+     *
+     * @param robot Points to the CoopMTRobot object.
+     */
+    static
+    void
+    CallTimebase(
+        __in void *robot
+        )
+    {
+        TLevel(HIFREQ);
+        TEnterMsg(("robot=%p", robot));
+        semGive(((CoopMTRobot *)robot)->m_wakeSem);
+        TExit();
+    }   //CallTimebase
+
+    /**
+     * This function starts the timebase Notifier ticking at the fastest
+     * period of the rate groups that have subsystems registered, or of the
+     * main loop if it is not synchronized to the Driver Station. It records
+     * which rate groups have subsystems, so RunRateGroups can restart the
+     * timebase when a subsystem registers into an empty group later.
+     */
+    void
+    StartTimebase(
+        void
+        )
+    {
+        UINT32 tickPeriod = 0;
+
+        TLevel(INIT);
+        TEnter();
+
+        for (UINT32 group = RATEGROUP_OPERATOR;
+             group < MAX_NUM_RATEGROUPS;
+             group++)
+        {
+            m_rateGroupActive[group] =
+                (group == RATEGROUP_OPERATOR) ||
+                (m_subsysMgr->GetNumSubSystems(group) > 0);
+            if ((m_rateGroupPeriod[group] != 0) &&
+                m_rateGroupActive[group] &&
+                ((tickPeriod == 0) || (m_rateGroupPeriod[group] < tickPeriod)))
+            {
+                tickPeriod = m_rateGroupPeriod[group];
+            }
+        }
+
+        m_timebase->Stop();
+        if (tickPeriod != 0)
+        {
+            TInfo(("Timebase period=%d us", tickPeriod));
+            m_timebase->StartPeriodic((double)tickPeriod/1000000.0);
+        }
+
+        TExit();
+    }   //StartTimebase
+
+    /**
+     * This function runs the subsystems of the rate groups whose period has
+     * come due. If a subsystem was registered into a rate group that had
+     * none, e.g. one created in AutonomousStart, the timebase is restarted
+     * so the group gets its own tick.
+     *
+     * @param context Specifies the caller context.
+     */
+    void
+    RunRateGroups(
+        __in UINT32 context
+        )
+    {
+        bool fRetune = false;
+
+        TLevel(HIFREQ);
+        TEnterMsg(("context=%d", context));
+
+        for (UINT32 group = RATEGROUP_OPERATOR + 1;
+             group < MAX_NUM_RATEGROUPS;
+             group++)
+        {
+            if ((m_rateGroupPeriod[group] != 0) &&
+                !m_rateGroupActive[group] &&
+                (m_subsysMgr->GetNumSubSystems(group) > 0))
+            {
+                m_rateGroupNext[group] = GetFPGATime();
+                fRetune = true;
+            }
+        }
+        if (fRetune)
+        {
+            StartTimebase();
+        }
+
+        for (UINT32 group = RATEGROUP_OPERATOR + 1;
+             group < MAX_NUM_RATEGROUPS;
+             group++)
+        {
+            UINT32 timeCurr = GetFPGATime();
+            if ((m_rateGroupPeriod[group] != 0) &&
+                ((INT32)(timeCurr - m_rateGroupNext[group]) >= 0))
+            {
+                m_subsysMgr->SubSystemInputTasks(context, group);
+                m_subsysMgr->SubSystemActionTasks(context, group);
+                m_rateGroupNext[group] += m_rateGroupPeriod[group];
+                if ((INT32)(timeCurr - m_rateGroupNext[group]) >= 0)
+                {
+                    //
+                    // We fell behind by more than a period, skip the
+                    // missed periods instead of running back-to-back.
+                    //
+                    TWarn(("Rate group %d missed its period", group));
+                    m_rateGroupNext[group] = timeCurr +
+                                             m_rateGroupPeriod[group];
+                }
+            }
+        }
+
+        TExit();
+    }   //RunRateGroups
+
+    /**
+     * This function shows the robot context on the Driver Station LCD. To
+     * keep the LCD traffic out of the robot loop, the LCD is only updated
+     * when the context has changed and no more often than every
+     * STATUS_UPDATE_PERIOD.
+     *
+     * @param context Specifies the caller context.
+     */
+    void
+    UpdateStatus(
+        __in UINT32 context
+        )
+    {
+        TLevel(HIFREQ);
+        TEnterMsg(("context=%d", context));
+
+        UINT32 timeCurr = GetFPGATime();
+        if ((context != m_statusContext) &&
+            ((INT32)(timeCurr - m_statusNextUpdate) >= 0))
+        {
+            m_statusLCD->PrintfLine(DriverStationLCD::kUser_Line4,
+                                    "Context=%d", context);
+            m_statusLCD->UpdateLCD();
+            m_statusContext = context;
+            m_statusNextUpdate = timeCurr + STATUS_UPDATE_PERIOD;
+        }
+
+        TExit();
+    }   //UpdateStatus
+
+    /**
+     * This function runs one period of the robot loop in the given context.
+     * It calls the subsystem input tasks, the periodic function of the
+     * context and the subsystem action tasks, timing each phase.
+     *
+     * @param context Specifies the caller context.
+     *
+     * @return Returns the time used by the period in usec.
+     */
+    UINT32
+    RunPeriod(
+        __in UINT32 context
+        )
+    {
+        TLevel(HIFREQ);
+        TEnterMsg(("context=%d", context));
+
+        UINT32 timeBegin = GetFPGATime();
+        //
+        // GetPeriod() in DS mode is the measured packet interval, so the
+        // jitter is measured against the nominal DS update period instead.
+        //
+        UINT32 nominalPeriod = (UINT32)(((m_loopPeriod > 0.0)?
+                                         m_loopPeriod:
+                                         DriverStation::kUpdatePeriod)*
+                                        1000000.0);
+
+        if (m_timePrevLoop != 0)
+        {
+            UINT32 period = timeBegin - m_timePrevLoop;
+            m_loopStats[LOOPSTAT_PERIOD].Add(period);
+            m_loopStats[LOOPSTAT_JITTER].Add(
+                (period > nominalPeriod)? period - nominalPeriod:
+                                          nominalPeriod - period);
+        }
+        m_timePrevLoop = timeBegin;
+
+        m_subsysMgr->SubSystemInputTasks(context);
+        UINT32 timeInput = GetFPGATime();
+        if (context == CONTEXT_AUTONOMOUS)
+        {
+            AutonomousPeriodic();
+        }
+        else
+        {
+            TeleOpPeriodic();
+        }
+        UINT32 timePeriodic = GetFPGATime();
+        m_subsysMgr->SubSystemActionTasks(context);
+        UINT32 timeEnd = GetFPGATime();
+
+        m_loopStats[LOOPSTAT_INPUT_TASKS].Add(timeInput - timeBegin);
+        m_loopStats[LOOPSTAT_PERIODIC].Add(timePeriodic - timeInput);
+        m_loopStats[LOOPSTAT_ACTION_TASKS].Add(timeEnd - timePeriodic);
+        m_loopStats[LOOPSTAT_LOOP_TIME].Add(timeEnd - timeBegin);
+
+        TExitMsg(("=%d", timeEnd - timeBegin));
+        return timeEnd - timeBegin;
+    }   //RunPeriod
 
     /**
      * This function is called to determine if the next period has
@@ -92,6 +352,13 @@ public:
      */
     static const double kDefaultPeriod = 0.0;
 
+    /*
+     * The default periods of the control and telemetry rate groups
+     * (seconds).
+     */
+    static const double kDefaultControlPeriod = 0.005;
+    static const double kDefaultTelemetryPeriod = 0.1;
+
     /**
      * This function is called one time to do robot-wide initialization.
      */
@@ -146,14 +413,12 @@ public:
     {
         TLevel(HIFREQ);
         TEnter();
-
-        taskDelay(1);
-
         TExit();
     }   //AutonomousPeriodic
 
     /**
-     * This function is called continuously in autonomous mode.
+     * This function is called every time the robot loop wakes up in
+     * autonomous mode.
      */
     virtual
     void
@@ -163,9 +428,6 @@ public:
     {
         TLevel(HIFREQ);
         TEnter();
-
-        taskDelay(1);
-
         TExit();
     }   //AutonomousContinuous
 
@@ -208,14 +470,12 @@ public:
     {
         TLevel(HIFREQ);
         TEnter();
-
-        taskDelay(1);
-
         TExit();
     }   //TeleOpPeriodic
 
     /**
-     * This function is called continuously in teleop mode.
+     * This function is called every time the robot loop wakes up in teleop
+     * mode.
      */
     virtual
     void
@@ -225,9 +485,6 @@ public:
     {
         TLevel(HIFREQ);
         TEnter();
-
-        taskDelay(1);
-
         TExit();
     }   //TeleOpContinuous
 
@@ -261,10 +518,46 @@ public:
             m_loopTimer.Stop();
         }
         m_loopPeriod = period;
+        m_rateGroupPeriod[RATEGROUP_OPERATOR] = (UINT32)(period*1000000.0);
+        StartTimebase();
 
         TExit();
     }   //SetPeriod
     
+    /**
+     * This function sets the period of a rate group. Setting the period of
+     * the operator rate group is the same as calling SetPeriod. It must be
+     * called before StartCompetition, typically in the robot constructor.
+     * The rate groups run in the robot loop after the operator period, so a
+     * rate group that comes due while the operator period is running waits
+     * for it. The latency of the control rate group is therefore bounded by
+     * the execution time of the operator period, not by its own period.
+     *
+     * @param rateGroup Specifies the rate group.
+     * @param period Specifies the period in seconds of the rate group.
+     *        0.0 disables the rate group.
+     */
+    void
+    SetRateGroupPeriod(
+        __in UINT32 rateGroup,
+        __in double period
+        )
+    {
+        TLevel(API);
+        TEnterMsg(("group=%d,period=%f", rateGroup, period));
+
+        if (rateGroup == RATEGROUP_OPERATOR)
+        {
+            SetPeriod(period);
+        }
+        else if (rateGroup < MAX_NUM_RATEGROUPS)
+        {
+            m_rateGroupPeriod[rateGroup] = (UINT32)(period*1000000.0);
+        }
+
+        TExit();
+    }   //SetRateGroupPeriod
+
     /**
      * This function gets the period for the periodic functions.
      *
@@ -305,15 +598,103 @@ public:
         return freq;
     }   //GetLoopsPerSec
 
+    /**
+     * This function gets the loop count and the accumulated loop time of a
+     * context.
+     *
+     * @param context Specifies CONTEXT_AUTONOMOUS or CONTEXT_TELEOP.
+     * @param cntLoops Points to the variable to hold the loop count.
+     * @param totalTime Points to the variable to hold the accumulated time
+     *        in usec spent in the periods of the context.
+     */
+    void
+    GetLoopCounts(
+        __in  UINT32  context,
+        __out UINT32 *cntLoops,
+        __out UINT32 *totalTime
+        )
+    {
+        TLevel(API);
+        TEnterMsg(("context=%d", context));
+
+        *cntLoops = (context == CONTEXT_AUTONOMOUS)? m_cntAutonomousLoops:
+                                                     m_cntTeleOpLoops;
+        *totalTime = (context == CONTEXT_AUTONOMOUS)? m_timeAutonomousPeriod:
+                                                      m_timeTeleOpPeriod;
+
+        TExitMsg(("cntLoops=%d,totalTime=%d", *cntLoops, *totalTime));
+        return;
+    }   //GetLoopCounts
+
+    /**
+     * This function gets a loop timing histogram so that it can be sent to
+     * the dashboard.
+     *
+     * @param stat Specifies the LOOPSTAT_* statistics to get.
+     *
+     * @return Returns the histogram of the statistics in usec.
+     */
+    TrcHistogram *
+    GetLoopStats(
+        __in UINT32 stat
+        )
+    {
+        TLevel(API);
+        TEnterMsg(("stat=%d", stat));
+        TrcHistogram *hist = (stat < NUM_LOOPSTATS)? &m_loopStats[stat]: NULL;
+        TExitMsg(("=%p", hist));
+        return hist;
+    }   //GetLoopStats
+
+    /**
+     * This function prints the loop timing statistics and the subsystem
+     * timing statistics to the console.
+     *
+     * @param fReset If true, resets the loop statistics after dumping them.
+     */
+    void
+    DumpLoopStats(
+        __in bool fReset = false
+        )
+    {
+        static const char *statNames[NUM_LOOPSTATS] =
+        {
+            "InputTasks",
+            "Periodic",
+            "ActionTasks",
+            "LoopTime",
+            "Period",
+            "Jitter"
+        };
+
+        TLevel(API);
+        TEnterMsg(("fReset=%d", fReset));
+
+        printf("Auto: %d loops, %d us; TeleOp: %d loops, %d us\n",
+               m_cntAutonomousLoops, m_timeAutonomousPeriod,
+               m_cntTeleOpLoops, m_timeTeleOpPeriod);
+        for (int i = 0; i < NUM_LOOPSTATS; i++)
+        {
+            m_loopStats[i].Dump(statNames[i]);
+            if (fReset)
+            {
+                m_loopStats[i].Reset();
+            }
+        }
+        m_subsysMgr->DumpTimingStats();
+
+        TExit();
+    }   //DumpLoopStats
+
     /**
      * Start a competition.
-     * This specific StartCompetition() implements "main loop" behavior like
-     * that of the FRC control system in 2008 and earlier, with a primary
-     * (slow) loop that is called periodically, and a "fast loop" (a.k.a.
-     * "spin loop") that is called as fast as possible with no delay between
-     * calls. This code needs to track the order of the field starting to
-     * ensure that everything happens in the right order. Repeatedly run the
-     * correct method, either Autonomous or OperatorControl when the robot is
+     * This specific StartCompetition() implements an event driven main loop.
+     * The loop sleeps until new Driver Station data arrives or the timebase
+     * ticks for one of the rate groups, then calls the periodic functions
+     * whose period is ready followed by the continuous functions. This code
+     * needs to track the order of the field starting to ensure that
+     * everything happens in the right order. Repeatedly run the correct
+     * method, either Autonomous or OperatorControl when the robot is
      * enabled. After running the correct method, wait for some state to
      * change, either the other mode starts or the robot is disabled. Then go
      * back and wait for the robot to be enabled again.
@@ -327,12 +708,7 @@ public:
         TEnter();
 
         UINT32 context = CONTEXT_DISABLED;
-        UINT32 timeAutonomousPeriod = 0;
-        UINT32 timeTeleOpPeriod = 0;
-        UINT32 cntLoops = 0;
-        UINT32 timeBegin = 0;
         UINT32 timeUsed = 0;
-        DriverStationLCD *dsLCD = DriverStationLCD::GetInstance();
 
         //
         // One-time robot initialization.
@@ -346,6 +722,8 @@ public:
 
         RobotInit();
         m_subsysMgr->InitSubSystems();
+        StartTimebase();
+        m_ds->SetNewDataUserSem(m_wakeSem);
 
         //
         // Set normal watchdog timeout.
@@ -361,13 +739,12 @@ public:
         //
         while (true)
         {
+            semTake(m_wakeSem, m_wakeTimeout);
             GetWatchdog().Feed();
 
             //TPeriodStart();
 
-            dsLCD->PrintfLine(DriverStationLCD::kUser_Line4,
-                              "Context=%d", context);
-            dsLCD->UpdateLCD();
+            UpdateStatus(context);
 
             switch (context)
             {
@@ -377,53 +754,50 @@ public:
                         TInfo(("Entering enabled state."));
                         if (IsAutonomous())
                         {
-                            GetWatchdog().Feed();
                             context = CONTEXT_AUTONOMOUS;
                             TInfo(("Starting autonomous."));
                             AutonomousStart();
                         }
                         else
                         {
-                            GetWatchdog().Feed();
                             context = CONTEXT_TELEOP;
                             TInfo(("Starting teleop."));
                             TeleOpStart();
                         }
                         TInfo(("Starting subsystems."));
                         m_subsysMgr->StartSubSystems(context);
+                        m_timePrevLoop = 0;
+                        for (UINT32 group = 0;
+                             group < MAX_NUM_RATEGROUPS;
+                             group++)
+                        {
+                            m_rateGroupNext[group] = GetFPGATime();
+                        }
                     }
                     break;
 
                 case CONTEXT_AUTONOMOUS:
                     if (IsEnabled() && IsAutonomous())
                     {
-                        GetWatchdog().Feed();
                         if (NextPeriodReady())
                         {
-                            GetWatchdog().Feed();
-                            timeBegin = GetMsecTime();
-                            m_subsysMgr->SubSystemInputTasks(context);
-                            AutonomousPeriodic();
-                            m_subsysMgr->SubSystemActionTasks(context);
-                            timeUsed = GetMsecTime() - timeBegin;
-                            timeAutonomousPeriod += timeUsed;
-                            cntLoops++;
-                            if ((float)timeUsed/1000.0 > GetPeriod()*0.9)
+                            timeUsed = RunPeriod(context);
+                            m_timeAutonomousPeriod += timeUsed;
+                            m_cntAutonomousLoops++;
+                            if ((float)timeUsed/1000000.0 > GetPeriod()*0.9)
                             {
-                                GetWatchdog().Feed();
                                 //
                                 // Execution time exceeds 90% of the period.
                                 //
-                                TWarn(("Autonomous period executed too long (%d ms)",
+                                TWarn(("Autonomous period executed too long (%d us)",
                                        timeUsed));
                             }
                         }
-                        GetWatchdog().Feed();
+                        RunRateGroups(context);
                         AutonomousContinuous();
                     }
                     else
                     {
-                        GetWatchdog().Feed();
                         m_subsysMgr->StopSubSystems(context);
                         AutonomousStop();
                         context = CONTEXT_DISABLED;
@@ -431,39 +805,27 @@ public:
                     break;
 
                 case CONTEXT_TELEOP:
-                    GetWatchdog().Feed();
                     if (IsEnabled() && IsOperatorControl())
                     {
-                        GetWatchdog().Feed();
                         if (NextPeriodReady())
                         {
-                            GetWatchdog().Feed();
-                            timeBegin = GetMsecTime();
-                            TInfo(("TeleOp Input Task:"));
-                            m_subsysMgr->SubSystemInputTasks(context);
-                            TInfo(("TeleOp Periodic:"));
-                            TeleOpPeriodic();
-                            TInfo(("TeleOp Action Tasks:"));
-                            m_subsysMgr->SubSystemActionTasks(context);
-                            timeUsed = GetMsecTime() - timeBegin;
-                            timeTeleOpPeriod += timeUsed;
-                            cntLoops++;
-                            if ((float)timeUsed/1000.0 > GetPeriod()*0.9)
+                            timeUsed = RunPeriod(context);
+                            m_timeTeleOpPeriod += timeUsed;
+                            m_cntTeleOpLoops++;
+                            if ((float)timeUsed/1000000.0 > GetPeriod()*0.9)
                             {
-                                GetWatchdog().Feed();
                                 //
                                 // Execution time exceeds 90% of the period.
                                 //
-                                TWarn(("TeleOp period executed too long (%d ms)",
+                                TWarn(("TeleOp period executed too long (%d us)",
                                        timeUsed));
                             }
                         }
-                        GetWatchdog().Feed();
+                        RunRateGroups(context);
                         TeleOpContinuous();
                     }
                     else
                     {
-                        GetWatchdog().Feed();
                         m_subsysMgr->StopSubSystems(context);
                         TeleOpStop();
                         context = CONTEXT_DISABLED;
@@ -484,12 +846,34 @@ protected:
     CoopMTRobot(
         void
         ): m_loopPeriod(kDefaultPeriod),
-           m_periodPacket(0)
+           m_periodPacket(0),
+           m_timeAutonomousPeriod(0),
+           m_timeTeleOpPeriod(0),
+           m_cntAutonomousLoops(0),
+           m_cntTeleOpLoops(0),
+           m_timePrevLoop(0)
     {
         TLevel(INIT);
         TEnter();
 
         m_subsysMgr = SubSystemMgr::GetInstance();
+        m_wakeSem = semBCreate(SEM_Q_PRIORITY, SEM_EMPTY);
+        m_wakeTimeout = (int)(LOOP_WAKE_TIMEOUT*sysClkRateGet());
+        m_timebase = new Notifier(CoopMTRobot::CallTimebase, this);
+        m_statusLCD = DriverStationLCD::GetInstance();
+        m_statusContext = CONTEXT_NONE;
+        m_statusNextUpdate = 0;
+        m_rateGroupPeriod[RATEGROUP_OPERATOR] =
+            (UINT32)(m_loopPeriod*1000000.0);
+        m_rateGroupPeriod[RATEGROUP_CONTROL] =
+            (UINT32)(kDefaultControlPeriod*1000000.0);
+        m_rateGroupPeriod[RATEGROUP_TELEMETRY] =
+            (UINT32)(kDefaultTelemetryPeriod*1000000.0);
+        for (UINT32 group = 0; group < MAX_NUM_RATEGROUPS; group++)
+        {
+            m_rateGroupNext[group] = 0;
+            m_rateGroupActive[group] = false;
+        }
         m_watchdog.SetEnabled(false);
 
         TExit();
@@ -505,6 +889,9 @@ protected:
         TLevel(INIT);
         TEnter();
 
+        m_ds->SetNewDataUserSem(0);
+        SAFE_DELETE(m_timebase);
+        semDelete(m_wakeSem);
         SubSystemMgr::DeleteInstance();
 
         TExit();
@@ -34,6 +34,13 @@
 #define MOD_EVENT               0x00100000
 #define MOD_SUBSYS              0x00200000
 #define MOD_COOPMTROBOT         0x00400000
+#define MOD_HISTOGRAM           0x00800000
+#define MOD_FLTREC              0x01000000
+#define MOD_PIDBANK             0x02000000
+#define MOD_MOTIONPROFILE       0x04000000
+#define MOD_ODOMETRY            0x08000000
+#define MOD_SAMPLER             0x10000000
+#define MOD_TRCSM               0x20000000
 
 #define MOD_MAIN                0x00000001
 #define TGenModId(n)            ((MOD_MAIN << (n)) & 0xff)
@@ -63,62 +70,146 @@
 
 #define TPrintf                 printf
 
+//
+// Build time trace filtering. Trace points of modules not in
+// TRACE_BUILD_MODULES or above TRACE_BUILD_LEVEL/TRACE_BUILD_MSGLEVEL are
+// resolved at compile time and generate no code. The runtime settings
+// passed to TraceInit can only narrow down what is built in. For example,
+// defining TRACE_BUILD_LEVEL as FUNC before including the library removes
+// all UTIL and HIFREQ trace points from the high frequency paths.
+//
+#ifndef TRACE_BUILD_MODULES
+  #define TRACE_BUILD_MODULES   0xffffffff
+#endif
+
+#ifndef TRACE_BUILD_LEVEL
+  #define TRACE_BUILD_LEVEL     HIFREQ
+#endif
+
+#ifndef TRACE_BUILD_MSGLEVEL
+  #define TRACE_BUILD_MSGLEVEL  VERBOSE
+#endif
+
+#define TBuildEnabled(m,l,b)    ((((m) & TRACE_BUILD_MODULES) != 0) && \
+                                 ((l) <= (b)))
+
 //
 // Trace macros.
 //
 #ifdef _DBGTRACE_ENABLED
-    #define TModEnterMsg(m,p)   if (g_Trace.m_fTraceEnabled && \
+    #define TModEnterMsg(m,p)   if (TBuildEnabled(m, _traceLevel, \
+                                                  TRACE_BUILD_LEVEL) && \
+                                    g_Trace.m_fTraceEnabled && \
                                     ((g_Trace.m_traceModules & (m)) != 0) && \
                                     (_traceLevel <= g_Trace.m_traceLevel)) \
                                 { \
-                                    g_Trace.FuncPrefix(MOD_NAME, \
-                                                       __FUNCTION__, \
-                                                       true, \
-                                                       false); \
-                                    TPrintf p; \
-                                    TPrintf(")\n"); \
+                                    if (g_Trace.m_fBinaryMode) \
+                                    { \
+                                        TraceRecorder(MOD_NAME, \
+                                                      __FUNCTION__, \
+                                                      TRACEREC_FUNC_ENTER, \
+                                                      _traceLevel) p; \
+                                    } \
+                                    else \
+                                    { \
+                                        g_Trace.FuncPrefix(MOD_NAME, \
+                                                           __FUNCTION__, \
+                                                           true, \
+                                                           false); \
+                                        TPrintf p; \
+                                        TPrintf(")\n"); \
+                                    } \
                                 }
-    #define TModEnter(m)        if (g_Trace.m_fTraceEnabled && \
+    #define TModEnter(m)        if (TBuildEnabled(m, _traceLevel, \
+                                                  TRACE_BUILD_LEVEL) && \
+                                    g_Trace.m_fTraceEnabled && \
                                     ((g_Trace.m_traceModules & (m)) != 0) && \
                                     (_traceLevel <= g_Trace.m_traceLevel)) \
                                 { \
-                                    g_Trace.FuncPrefix(MOD_NAME, \
-                                                       __FUNCTION__, \
-                                                       true, \
-                                                       true); \
+                                    if (g_Trace.m_fBinaryMode) \
+                                    { \
+                                        TraceRecorder(MOD_NAME, \
+                                                      __FUNCTION__, \
+                                                      TRACEREC_FUNC_ENTER, \
+                                                      _traceLevel)(NULL); \
+                                    } \
+                                    else \
+                                    { \
+                                        g_Trace.FuncPrefix(MOD_NAME, \
+                                                           __FUNCTION__, \
+                                                           true, \
+                                                           true); \
+                                    } \
                                 }
-    #define TModExitMsg(m,p)    if (g_Trace.m_fTraceEnabled && \
+    #define TModExitMsg(m,p)    if (TBuildEnabled(m, _traceLevel, \
+                                                  TRACE_BUILD_LEVEL) && \
+                                    g_Trace.m_fTraceEnabled && \
                                     ((g_Trace.m_traceModules & (m)) != 0) && \
                                     (_traceLevel <= g_Trace.m_traceLevel)) \
                                 { \
-                                    g_Trace.FuncPrefix(MOD_NAME, \
-                                                       __FUNCTION__, \
-                                                       false, \
-                                                       false); \
-                                    TPrintf p; \
-                                    TPrintf("\n"); \
+                                    if (g_Trace.m_fBinaryMode) \
+                                    { \
+                                        TraceRecorder(MOD_NAME, \
+                                                      __FUNCTION__, \
+                                                      TRACEREC_FUNC_EXIT, \
+                                                      _traceLevel) p; \
+                                    } \
+                                    else \
+                                    { \
+                                        g_Trace.FuncPrefix(MOD_NAME, \
+                                                           __FUNCTION__, \
+                                                           false, \
+                                                           false); \
+                                        TPrintf p; \
+                                        TPrintf("\n"); \
+                                    } \
                                 }
-    #define TModExit(m)         if (g_Trace.m_fTraceEnabled && \
+    #define TModExit(m)         if (TBuildEnabled(m, _traceLevel, \
+                                                  TRACE_BUILD_LEVEL) && \
+                                    g_Trace.m_fTraceEnabled && \
                                     ((g_Trace.m_traceModules & (m)) != 0) && \
                                     (_traceLevel <= g_Trace.m_traceLevel)) \
                                 { \
-                                    g_Trace.FuncPrefix(MOD_NAME, \
-                                                       __FUNCTION__, \
-                                                       false, \
-                                                       true); \
+                                    if (g_Trace.m_fBinaryMode) \
+                                    { \
+                                        TraceRecorder(MOD_NAME, \
+                                                      __FUNCTION__, \
+                                                      TRACEREC_FUNC_EXIT, \
+                                                      _traceLevel)(NULL); \
+                                    } \
+                                    else \
+                                    { \
+                                        g_Trace.FuncPrefix(MOD_NAME, \
+                                                           __FUNCTION__, \
+                                                           false, \
+                                                           true); \
+                                    } \
                                 }
-    #define TModMsg(m,e,p)      if (((g_Trace.m_traceModules & (m)) != 0) && \
+    #define TModMsg(m,e,p)      if (TBuildEnabled(m, e, \
+                                                  TRACE_BUILD_MSGLEVEL) && \
+                                    ((g_Trace.m_traceModules & (m)) != 0) && \
                                     ((e) <= g_Trace.m_msgLevel)) \
                                 { \
-                                    g_Trace.MsgPrefix(MOD_NAME, \
+                                    if (g_Trace.m_fBinaryMode) \
+                                    { \
+                                        TraceRecorder(MOD_NAME, \
                                                       __FUNCTION__, \
-                                                      e); \
-                                    TPrintf p; \
-                                    TPrintf("\n"); \
+                                                      TRACEREC_MSG, \
+                                                      e) p; \
+                                    } \
+                                    else \
+                                    { \
+                                        g_Trace.MsgPrefix(MOD_NAME, \
+                                                          __FUNCTION__, \
+                                                          e); \
+                                        TPrintf p; \
+                                        TPrintf("\n"); \
+                                    } \
                                 }
     #define TEnable(b)          g_Trace.m_fTraceEnabled = (b)
     #define TraceInit(m,l,e)    g_Trace.Initialize(m, l, e)
-    #define TLevel(l)           UINT32 _traceLevel = l
+    #define TBinaryMode(b,f)    g_Trace.SetBinaryMode(b, f)
+    #define TLevel(l)           const UINT32 _traceLevel = l
     #define TEnterMsg(p)        TModEnterMsg(MOD_ID, p)
     #define TEnter()            TModEnter(MOD_ID)
     #define TExitMsg(p)         TModExitMsg(MOD_ID, p)
@@ -129,7 +220,9 @@
     #define TWarn(p)            TModMsg(MOD_ID, WARN, p)
     #define TInfo(p)            TModMsg(MOD_ID, INFO, p)
     #define TVerbose(p)         TModMsg(MOD_ID, VERBOSE, p)
-    #define TMsgPeriod(t,p)     { \
+    #define TMsgPeriod(t,p)     if (TBuildEnabled(MOD_ID, INFO, \
+                                                  TRACE_BUILD_MSGLEVEL)) \
+                                { \
                                     static UINT32 _usecNextTime = 0; \
                                     if (GetFPGATime() >= _usecNextTime) \
                                     { \
@@ -161,6 +254,7 @@
 #else
     #define TEnable(b)
     #define TraceInit(m,l,e)
+    #define TBinaryMode(b,f)
     #define TLevel(l)
     #define TEnterMsg(p)
     #define TEnter()
@@ -179,6 +273,660 @@
     #define TPeriodEnd()
 #endif  //ifdef _DBGTRACE_ENABLED
 
+//
+// Binary trace mode. Trace points write fixed size records into a ring
+// buffer owned by the calling task instead of calling printf, and a low
+// priority drain task formats the records later.
+//
+#define TRACEREC_FUNC_ENTER     0
+#define TRACEREC_FUNC_EXIT      1
+#define TRACEREC_MSG            2
+
+#define TRACEREC_MAX_ARGS       4
+#define TRACEBUF_NUM_RECS       256     //per task, must be a power of 2
+#define TRACEBUF_MAX_RINGS      8
+#define TRACEBUF_DRAIN_PERIOD   100     //in msec
+#define TRACEBUF_DRAIN_PRIORITY 200
+#define TRACEBUF_LINE_LEN       256
+#define TRACEBUF_TASKNAME_LEN   16
+
+//
+// Make sure the record is filled in before it is published.
+//
+#define TRACEBUF_BARRIER()      MEMORY_BARRIER()
+
+/**
+ * This union holds a captured trace argument. Floating point arguments are
+ * kept as float to keep the record small. String arguments are kept by
+ * pointer, so only strings that outlive the drain (e.g. string constants)
+ * should be traced in binary mode.
+ */
+typedef union _TraceArg
+{
+    UINT32      u;
+    float       f;
+    const char *s;
+} TraceArg;
+
+/**
+ * This structure is one binary trace record.
+ */
+typedef struct _TraceRecord
+{
+    UINT32      timestamp;
+    const char *modName;
+    const char *funcName;
+    const char *format;
+    UINT8       type;
+    UINT8       level;
+    UINT8       numArgs;
+    TraceArg    args[TRACEREC_MAX_ARGS];
+} TraceRecord;
+
+/**
+ * This structure is the ring buffer of one task. Only the owner task moves
+ * the head and only the drain task moves the tail, so no lock is needed.
+ */
+typedef struct _TraceRing
+{
+    volatile INT32  taskId;         //0 if the ring is free
+    char            name[TRACEBUF_TASKNAME_LEN];
+    volatile UINT32 head;
+    volatile UINT32 tail;
+    volatile UINT32 dropped;
+    UINT32          droppedReported;
+    INT32           indentLevel;
+    TraceRecord     recs[TRACEBUF_NUM_RECS];
+} TraceRing;
+
+/**
+ * This class implements the binary trace backend. Each task that traces
+ * gets its own single producer ring buffer on its first trace point. A low
+ * priority drain task merges the records of all rings in timestamp order,
+ * formats them the same way as the text mode and writes them to the console
+ * or to a file. The drain task frees the ring of a task that has exited once
+ * it is empty, so the rings are reused by tasks created later.
+ */
+class TraceBuffer
+{
+private:
+    TraceRing       m_rings[TRACEBUF_MAX_RINGS];
+    volatile UINT32 m_numRings;
+    volatile UINT32 m_droppedNoRing;
+    UINT32          m_droppedNoRingReported;
+    FILE           *m_file;
+    Task           *m_drainTask;
+    volatile bool   m_fStopDrain;
+
+    /**
+     * This function finds the ring buffer of the calling task. If the task
+     * does not have one yet, a free one is assigned. The task name is saved
+     * with the ring, so it is still known after the task has exited.
+     *
+     * @return Returns the ring buffer or NULL if all are taken.
+     */
+    TraceRing *
+    GetRing(
+        void
+        )
+    {
+        TraceRing *ring = NULL;
+        INT32 taskId = taskIdSelf();
+        UINT32 numRings = m_numRings;
+
+        for (UINT32 i = 0; i < numRings; i++)
+        {
+            if (m_rings[i].taskId == taskId)
+            {
+                ring = &m_rings[i];
+                break;
+            }
+        }
+
+        if (ring == NULL)
+        {
+            const char *name = taskName(taskId);
+            int lockKey = intLock();
+
+            for (UINT32 i = 0; i < m_numRings; i++)
+            {
+                if (m_rings[i].taskId == 0)
+                {
+                    ring = &m_rings[i];
+                    break;
+                }
+            }
+            if ((ring == NULL) && (m_numRings < TRACEBUF_MAX_RINGS))
+            {
+                ring = &m_rings[m_numRings];
+                m_numRings++;
+            }
+            if (ring != NULL)
+            {
+                strncpy(ring->name, (name != NULL)? name: "?",
+                        TRACEBUF_TASKNAME_LEN - 1);
+                ring->name[TRACEBUF_TASKNAME_LEN - 1] = '\0';
+                ring->taskId = taskId;
+            }
+            intUnlock(lockKey);
+        }
+
+        return ring;
+    }   //GetRing
+
+    /**
+     * This function captures the arguments of a printf style format into
+     * the trace record. The format is scanned to find the type of each
+     * argument.
+     *
+     * @param rec Points to the trace record.
+     * @param args Specifies the argument list.
+     */
+    static
+    void
+    CaptureArgs(
+        __out TraceRecord *rec,
+        __in  va_list      args
+        )
+    {
+        const char *psz = rec->format;
+
+        rec->numArgs = 0;
+        while ((psz != NULL) && (*psz != '\0') &&
+               (rec->numArgs < TRACEREC_MAX_ARGS))
+        {
+            if (*psz++ != '%')
+            {
+                continue;
+            }
+
+            while ((*psz != '\0') &&
+                   (strchr("-+ #0123456789.hlLqjzt", *psz) != NULL))
+            {
+                psz++;
+            }
+
+            switch (*psz)
+            {
+            case '\0':
+                continue;
+
+            case '%':
+                break;
+
+            case 'f':
+            case 'e':
+            case 'E':
+            case 'g':
+            case 'G':
+                rec->args[rec->numArgs++].f = (float)va_arg(args, double);
+                break;
+
+            case 's':
+                rec->args[rec->numArgs++].s = va_arg(args, const char *);
+                break;
+
+            default:
+                rec->args[rec->numArgs++].u = va_arg(args, UINT32);
+                break;
+            }
+            psz++;
+        }
+    }   //CaptureArgs
+
+    /**
+     * This function formats the message of a trace record by walking its
+     * format string and printing each conversion with the captured
+     * argument.
+     *
+     * @param rec Points to the trace record.
+     * @param buff Points to the output buffer.
+     * @param len Specifies the remaining length of the output buffer.
+     *
+     * @return Returns the number of characters written.
+     */
+    static
+    int
+    FormatArgs(
+        __in  TraceRecord *rec,
+        __out char        *buff,
+        __in  int          len
+        )
+    {
+        const char *psz = rec->format;
+        int n = 0;
+        UINT32 argIdx = 0;
+        char spec[16];
+
+        while ((psz != NULL) && (*psz != '\0') && (n < len - 1))
+        {
+            if (*psz != '%')
+            {
+                buff[n++] = *psz++;
+                continue;
+            }
+
+            const char *pszSpec = psz++;
+            while ((*psz != '\0') &&
+                   (strchr("-+ #0123456789.hlLqjzt", *psz) != NULL))
+            {
+                psz++;
+            }
+
+            if (*psz == '\0')
+            {
+                break;
+            }
+            else if (*psz == '%')
+            {
+                buff[n++] = '%';
+                psz++;
+                continue;
+            }
+
+            int specLen = psz - pszSpec + 1;
+            if (specLen >= (int)sizeof(spec))
+            {
+                specLen = sizeof(spec) - 1;
+            }
+            strncpy(spec, pszSpec, specLen);
+            spec[specLen] = '\0';
+
+            int cnt;
+            if (argIdx >= rec->numArgs)
+            {
+                cnt = snprintf(&buff[n], len - n, "?");
+            }
+            else if (strchr("feEgG", *psz) != NULL)
+            {
+                cnt = snprintf(&buff[n], len - n, spec,
+                               (double)rec->args[argIdx++].f);
+            }
+            else if (*psz == 's')
+            {
+                cnt = snprintf(&buff[n], len - n, spec,
+                               rec->args[argIdx++].s);
+            }
+            else
+            {
+                cnt = snprintf(&buff[n], len - n, spec,
+                               rec->args[argIdx++].u);
+            }
+            psz++;
+
+            if (cnt > 0)
+            {
+                n += cnt;
+                if (n > len - 1)
+                {
+                    n = len - 1;
+                }
+            }
+        }
+        buff[n] = '\0';
+
+        return n;
+    }   //FormatArgs
+
+    /**
+     * This function formats a trace record and writes it out.
+     *
+     * @param ring Points to the ring buffer the record came from.
+     * @param rec Points to the trace record.
+     */
+    void
+    WriteRecord(
+        __in TraceRing   *ring,
+        __in TraceRecord *rec
+        )
+    {
+        static const char *msgPrefixes[] =
+        {
+            "_Fatal: ", "_Err: ", "_Warn: ", "_Info: ", "_Verbose: "
+        };
+        char line[TRACEBUF_LINE_LEN];
+        int n;
+
+        n = snprintf(line, sizeof(line), "%10u %-10s ",
+                     rec->timestamp, ring->name);
+
+        if (rec->type == TRACEREC_FUNC_ENTER)
+        {
+            ring->indentLevel++;
+        }
+
+        if (rec->type != TRACEREC_MSG)
+        {
+            for (INT32 i = 0;
+                 (i < ring->indentLevel) && (n < (int)sizeof(line) - 2);
+                 i++)
+            {
+                line[n++] = '|';
+                line[n++] = ' ';
+            }
+        }
+
+        if (n < (int)sizeof(line))
+        {
+            n += snprintf(&line[n], sizeof(line) - n, "%s.%s",
+                          rec->modName, rec->funcName);
+        }
+
+        switch (rec->type)
+        {
+        case TRACEREC_FUNC_ENTER:
+            if (n < (int)sizeof(line))
+            {
+                n += snprintf(&line[n], sizeof(line) - n, "(");
+            }
+            if (n < (int)sizeof(line))
+            {
+                n += FormatArgs(rec, &line[n], sizeof(line) - n);
+            }
+            if (n < (int)sizeof(line))
+            {
+                snprintf(&line[n], sizeof(line) - n, ")");
+            }
+            break;
+
+        case TRACEREC_FUNC_EXIT:
+            if (n < (int)sizeof(line))
+            {
+                n += snprintf(&line[n], sizeof(line) - n, "!");
+            }
+            if (n < (int)sizeof(line))
+            {
+                FormatArgs(rec, &line[n], sizeof(line) - n);
+            }
+            ring->indentLevel--;
+            break;
+
+        default:
+            if (n < (int)sizeof(line))
+            {
+                n += snprintf(&line[n], sizeof(line) - n, "%s",
+                              (rec->level < ARRAYSIZE(msgPrefixes))?
+                                msgPrefixes[rec->level]: "_Unk: ");
+            }
+            if (n < (int)sizeof(line))
+            {
+                FormatArgs(rec, &line[n], sizeof(line) - n);
+            }
+            break;
+        }
+
+        if (m_file != NULL)
+        {
+            fprintf(m_file, "%s\n", line);
+        }
+        else
+        {
+            TPrintf("%s\n", line);
+        }
+    }   //WriteRecord
+
+    /**
+     * This function is the drain task. It periodically writes out all the
+     * records in the ring buffers.
+     *
+     * @param traceBuf Points to the TraceBuffer object.
+     *
+     * @return Returns 0.
+     */
+    static
+    int
+    DrainTask(
+        __in TraceBuffer *traceBuf
+        )
+    {
+        int period = (TRACEBUF_DRAIN_PERIOD*sysClkRateGet() + 999)/1000;
+
+        while (!traceBuf->m_fStopDrain)
+        {
+            traceBuf->Drain();
+            taskDelay(period);
+        }
+        traceBuf->Drain();
+
+        return 0;
+    }   //DrainTask
+
+public:
+    /**
+     * Constructor: Create an instance of the TraceBuffer object and start
+     * the drain task.
+     *
+     * @param fileName Specifies the file to write the trace to. If NULL, the
+     *        trace is written to the console.
+     */
+    TraceBuffer(
+        __in const char *fileName = NULL
+        ): m_numRings(0),
+           m_droppedNoRing(0),
+           m_droppedNoRingReported(0),
+           m_file(NULL),
+           m_fStopDrain(false)
+    {
+        for (UINT32 i = 0; i < TRACEBUF_MAX_RINGS; i++)
+        {
+            m_rings[i].taskId = 0;
+            m_rings[i].name[0] = '\0';
+            m_rings[i].head = 0;
+            m_rings[i].tail = 0;
+            m_rings[i].dropped = 0;
+            m_rings[i].droppedReported = 0;
+            m_rings[i].indentLevel = 0;
+        }
+
+        if (fileName != NULL)
+        {
+            m_file = fopen(fileName, "w");
+        }
+
+        m_drainTask = new Task("TrcTraceDrain",
+                               (FUNCPTR)TraceBuffer::DrainTask,
+                               TRACEBUF_DRAIN_PRIORITY);
+        m_drainTask->Start((UINT32)this);
+    }   //TraceBuffer
+
+    /**
+     * Destructor: Destroy an instance of the TraceBuffer object. The
+     * remaining records are written out first.
+     */
+    ~TraceBuffer(
+        void
+        )
+    {
+        m_fStopDrain = true;
+        while (m_drainTask->Verify())
+        {
+            taskDelay(1);
+        }
+        SAFE_DELETE(m_drainTask);
+        Drain();
+        if (m_file != NULL)
+        {
+            fclose(m_file);
+            m_file = NULL;
+        }
+    }   //~TraceBuffer
+
+    /**
+     * This function adds a trace record to the ring buffer of the calling
+     * task. If the ring buffer is full, the record is dropped and counted.
+     *
+     * @param modName Specifies the module name.
+     * @param funcName Specifies the function name.
+     * @param type Specifies the record type.
+     * @param level Specifies the trace level or message level.
+     * @param format Specifies the printf style format, can be NULL.
+     * @param args Specifies the argument list of the format.
+     */
+    void
+    Record(
+        __in const char *modName,
+        __in const char *funcName,
+        __in UINT32      type,
+        __in UINT32      level,
+        __in const char *format,
+        __in va_list     args
+        )
+    {
+        TraceRing *ring = GetRing();
+
+        if (ring == NULL)
+        {
+            m_droppedNoRing++;
+        }
+        else
+        {
+            UINT32 head = ring->head;
+
+            if (head - ring->tail >= TRACEBUF_NUM_RECS)
+            {
+                ring->dropped++;
+            }
+            else
+            {
+                TraceRecord *rec =
+                    &ring->recs[head & (TRACEBUF_NUM_RECS - 1)];
+
+                rec->timestamp = GetFPGATime();
+                rec->modName = modName;
+                rec->funcName = funcName;
+                rec->format = format;
+                rec->type = (UINT8)type;
+                rec->level = (UINT8)level;
+                CaptureArgs(rec, args);
+                TRACEBUF_BARRIER();
+                ring->head = head + 1;
+            }
+        }
+    }   //Record
+
+    /**
+     * This function writes out all the records in the ring buffers in
+     * timestamp order. It is called by the drain task.
+     */
+    void
+    Drain(
+        void
+        )
+    {
+        UINT32 numRings = m_numRings;
+        bool fWritten = false;
+
+        while (true)
+        {
+            TraceRing *oldest = NULL;
+            TraceRecord *oldestRec = NULL;
+
+            for (UINT32 i = 0; i < numRings; i++)
+            {
+                TraceRing *ring = &m_rings[i];
+                if (ring->tail != ring->head)
+                {
+                    TraceRecord *rec =
+                        &ring->recs[ring->tail & (TRACEBUF_NUM_RECS - 1)];
+                    if ((oldestRec == NULL) ||
+                        ((INT32)(rec->timestamp - oldestRec->timestamp) < 0))
+                    {
+                        oldest = ring;
+                        oldestRec = rec;
+                    }
+                }
+            }
+
+            if (oldest == NULL)
+            {
+                break;
+            }
+
+            TRACEBUF_BARRIER();
+            WriteRecord(oldest, oldestRec);
+            TRACEBUF_BARRIER();
+            oldest->tail++;
+            fWritten = true;
+        }
+
+        for (UINT32 i = 0; i < numRings; i++)
+        {
+            UINT32 dropped = m_rings[i].dropped -
+                             m_rings[i].droppedReported;
+            if (dropped != 0)
+            {
+                m_rings[i].droppedReported += dropped;
+                if (m_file != NULL)
+                {
+                    fprintf(m_file, "%s: %d trace records dropped\n",
+                            m_rings[i].name, dropped);
+                }
+                else
+                {
+                    TPrintf("%s: %d trace records dropped\n",
+                            m_rings[i].name, dropped);
+                }
+                fWritten = true;
+            }
+
+            //
+            // Free the ring of a task that has exited. The check and the
+            // free are done under the same lock GetRing uses, so a new task
+            // reusing the task ID cannot start writing to the ring in
+            // between. If that task already exists, the ring is kept.
+            //
+            if (m_rings[i].taskId != 0)
+            {
+                int lockKey = intLock();
+                INT32 taskId = m_rings[i].taskId;
+                if ((taskId != 0) && (taskIdVerify(taskId) != OK) &&
+                    (m_rings[i].tail == m_rings[i].head))
+                {
+                    m_rings[i].indentLevel = 0;
+                    m_rings[i].taskId = 0;
+                }
+                intUnlock(lockKey);
+            }
+        }
+
+        UINT32 droppedNoRing = m_droppedNoRing - m_droppedNoRingReported;
+        if (droppedNoRing != 0)
+        {
+            m_droppedNoRingReported += droppedNoRing;
+            if (m_file != NULL)
+            {
+                fprintf(m_file, "%d trace records dropped, no free ring\n",
+                        droppedNoRing);
+            }
+            else
+            {
+                TPrintf("%d trace records dropped, no free ring\n",
+                        droppedNoRing);
+            }
+            fWritten = true;
+        }
+
+        if (fWritten && (m_file != NULL))
+        {
+            fflush(m_file);
+        }
+    }   //Drain
+
+    /**
+     * This function returns the number of records dropped because all the
+     * ring buffers were taken by other tasks.
+     *
+     * @return Returns the number of records dropped.
+     */
+    UINT32
+    GetDroppedNoRing(
+        void
+        )
+    {
+        return m_droppedNoRing;
+    }   //GetDroppedNoRing
+};  //class TraceBuffer
+
 /**
  * This class implements the debug tracing object. It provides two facilities.
  * One allows the functions to trace the enter and exit conditions of the call
@@ -195,6 +943,8 @@ public:
     UINT32 m_traceLevel;
     UINT32 m_msgLevel;
     UINT32 m_traceTime;
+    bool   m_fBinaryMode;
+    TraceBuffer *m_traceBuf;
 
 private:
     INT32  m_indentLevel;
@@ -212,6 +962,8 @@ public:
         m_traceLevel = 0;
         m_msgLevel = 0;
         m_traceTime = 0;
+        m_fBinaryMode = false;
+        m_traceBuf = NULL;
         m_indentLevel = 0;
     }   //DbgTrace
 
@@ -223,6 +975,8 @@ public:
         void
         )
     {
+        m_fBinaryMode = false;
+        SAFE_DELETE(m_traceBuf);
     }   //~DbgTrace
 
     /**
@@ -249,6 +1003,33 @@ public:
         m_indentLevel = 0;
     }   //Initialize
 
+    /**
+     * This function switches between text and binary tracing. In text mode,
+     * trace points are printed immediately. In binary mode, trace points
+     * are recorded into per task ring buffers and written out by a low
+     * priority task so that tracing does not disturb the timing of high
+     * frequency code. The ring buffers are created on the first enable and
+     * kept afterwards so that trace points in flight stay valid.
+     *
+     * @param fEnable Specifies true to enable binary mode, false to go back
+     *        to text mode.
+     * @param fileName Specifies the file to write the binary mode trace to.
+     *        If NULL, it is written to the console. It is only used when
+     *        binary mode is enabled the first time.
+     */
+    void
+    SetBinaryMode(
+        __in bool        fEnable,
+        __in const char *fileName = NULL
+        )
+    {
+        if (fEnable && (m_traceBuf == NULL))
+        {
+            m_traceBuf = new TraceBuffer(fileName);
+        }
+        m_fBinaryMode = fEnable;
+    }   //SetBinaryMode
+
     /**
      * This method generates the function trace prefix string. The prefix
      * contains the indentation, the module name and the function name.
@@ -337,6 +1118,61 @@ public:
 
 #ifdef _DBGTRACE_ENABLED
     DbgTrace g_Trace;
+
+/**
+ * This class is used by the trace macros in binary mode. The macros pass
+ * the trace point info to the constructor and the printf style arguments
+ * to the function call operator, e.g.
+ * TraceRecorder(MOD_NAME, __FUNCTION__, TRACEREC_MSG, INFO)("x=%d", x).
+ */
+class TraceRecorder
+{
+private:
+    const char *m_modName;
+    const char *m_funcName;
+    UINT32      m_type;
+    UINT32      m_level;
+
+public:
+    /**
+     * Constructor: Create an instance of the TraceRecorder object.
+     *
+     * @param modName Specifies the module name.
+     * @param funcName Specifies the function name.
+     * @param type Specifies the record type.
+     * @param level Specifies the trace level or message level.
+     */
+    TraceRecorder(
+        __in const char *modName,
+        __in const char *funcName,
+        __in UINT32      type,
+        __in UINT32      level
+        ): m_modName(modName),
+           m_funcName(funcName),
+           m_type(type),
+           m_level(level)
+    {
+    }   //TraceRecorder
+
+    /**
+     * This function records the trace point into the binary trace buffer.
+     *
+     * @param format Specifies the printf style format, can be NULL.
+     */
+    void
+    operator()(
+        __in const char *format,
+        ...
+        )
+    {
+        va_list args;
+
+        va_start(args, format);
+        g_Trace.m_traceBuf->Record(m_modName, m_funcName, m_type, m_level,
+                                   format, args);
+        va_end(args);
+    }   //operator()
+};  //class TraceRecorder
 #endif
 
 #endif  //ifndef _DBGTRACE_H
@@ -30,6 +30,41 @@
 //
 #define MAX_DIGITAL_CHANNEL     14
 #define DInMask(n)              (1 << (16 - (n)))
+//
+// All the valid channel bits, DInMask(1) down to DInMask(14).
+//
+#define DInAllMask              ((DInMask(1) << 1) - \
+                                 DInMask(MAX_DIGITAL_CHANNEL))
+//
+// Converts a mask with a single channel bit back to the channel number.
+//
+#define DInChannel(m)           (16 - __builtin_ctz(m))
+
+#define DIGITALIN_MAX_INTERRUPTS        8
+#define DIGITALIN_EVENT_QUEUE_SIZE      32
+#define DIGITALIN_DISPATCH_PRIORITY     50
+
+/**
+ * This structure holds a DigitalIn interrupt event.
+ */
+typedef struct _DInEvent
+{
+    UINT32 channel;
+    bool   fActive;
+    UINT32 timestamp;
+} DInEvent;
+
+class DigitalIn;
+
+/**
+ * This structure binds an interrupt to its DigitalIn object and channel.
+ */
+typedef struct _DInInterrupt
+{
+    DigitalIn    *dIn;
+    UINT32        channel;
+    DigitalInput *input;
+} DInInterrupt;
 
 /**
  * This abstract class defines the DigitalInNotify object. The object
@@ -56,13 +91,45 @@ public:
         __in UINT32 channel,
         __in bool   fActive
         ) = 0;
+
+    /**
+     * This function is called for an interrupt driven DigitalIn event. The
+     * default calls NotifyDIn, a subclass can override it to get the time
+     * of the edge.
+     *
+     * @param slot Specifies the Digital Module slot.
+     * @param channel Specifies the DigitalIn channel that changed state.
+     * @param fActive If true, specifies the DigitalIn channel is active,
+     *        false otherwise.
+     * @param timestamp Specifies the FPGA time of the edge in usec.
+     */
+    virtual
+    void
+    NotifyDInEvent(
+        __in UINT32 slot,
+        __in UINT32 channel,
+        __in bool   fActive,
+        __in UINT32 timestamp
+        )
+    {
+        TLevel(CALLBK);
+        TEnterMsg(("slot=%d,channel=%d,fActive=%d,timestamp=%u",
+                   slot, channel, fActive, timestamp));
+        NotifyDIn(slot, channel, fActive);
+        TExit();
+    }   //NotifyDInEvent
 };  //class DigitalInNotify
 
 /**
  * This class defines and implements the DigitalIn object. It inherited the
  * DigitalModule object from the WPI library. It also added the capability of
  * detecting the changes of a digital input channel and call the notification
- * object for the change.
+ * object for the change. By default the channels are polled by DigitalInTask
+ * every robot loop. Channels that need a faster reaction (e.g. safety limit
+ * switches) can be made interrupt driven with SetInterruptMask: the FPGA
+ * interrupts on both edges, the edges are queued with their timestamps and
+ * a dedicated high priority task calls the notification object, so the
+ * notification may come from a different task than the robot loop.
  */
 class DigitalIn: public DigitalModule
 {
@@ -71,6 +138,130 @@ private:
     UINT32           m_notifyMask;
     DigitalInNotify *m_notify;
     UINT16           m_prevDIn;
+    UINT32           m_intMask;
+    int              m_numInterrupts;
+    DInInterrupt     m_interrupts[DIGITALIN_MAX_INTERRUPTS];
+    DInEvent         m_events[DIGITALIN_EVENT_QUEUE_SIZE];
+    UINT32           m_eventHead;
+    UINT32           m_eventTail;
+    SEM_ID           m_eventSem;
+    Task            *m_dispatchTask;
+
+    /**
+     * This function is called by the WPI interrupt manager when a channel
+     * changes state. It queues the event for the dispatch task.
+     *
+     * @param assertedMask Specifies the asserted interrupts.
+     * @param context Points to the DInInterrupt of the channel.
+     */
+    static
+    void
+    InterruptHandler(
+        __in tNIRIO_u32 assertedMask,
+        __in void      *context
+        )
+    {
+        DInInterrupt *interrupt = (DInInterrupt *)context;
+        DigitalIn *dIn = interrupt->dIn;
+        DInEvent event;
+
+        TLevel(CALLBK);
+        TEnterMsg(("mask=%x,channel=%d", assertedMask, interrupt->channel));
+
+        event.channel = interrupt->channel;
+        event.timestamp =
+            (UINT32)(interrupt->input->ReadInterruptTimestamp()*1000000.0);
+        event.fActive = interrupt->input->Get() != 0;
+
+        int lockKey = intLock();
+        UINT32 next = (dIn->m_eventTail + 1)%DIGITALIN_EVENT_QUEUE_SIZE;
+        bool fQueued = next != dIn->m_eventHead;
+        if (fQueued)
+        {
+            dIn->m_events[dIn->m_eventTail] = event;
+            dIn->m_eventTail = next;
+        }
+        intUnlock(lockKey);
+
+        if (fQueued)
+        {
+            semGive(dIn->m_eventSem);
+        }
+        else
+        {
+            TWarn(("Event queue full, channel %d event dropped.",
+                   event.channel));
+        }
+
+        TExit();
+    }   //InterruptHandler
+
+    /**
+     * This function is the dispatch task. It waits for interrupt events and
+     * calls the notification object for each channel that changed state.
+     *
+     * @param dIn Points to the DigitalIn object.
+     *
+     * @return Returns 0.
+     */
+    static
+    int
+    DispatchTask(
+        __in DigitalIn *dIn
+        )
+    {
+        TLevel(TASK);
+        TEnterMsg(("dIn=%p", dIn));
+
+        UINT16 prevDIn = dIn->GetDIO();
+        while (semTake(dIn->m_eventSem, WAIT_FOREVER) == OK)
+        {
+            DInEvent event = dIn->m_events[dIn->m_eventHead];
+            UINT16 mask = DInMask(event.channel);
+
+            dIn->m_eventHead = (dIn->m_eventHead + 1)%
+                               DIGITALIN_EVENT_QUEUE_SIZE;
+            //
+            // A bouncing switch may report the same state twice.
+            //
+            if (((prevDIn & mask) != 0) != event.fActive)
+            {
+                prevDIn ^= mask;
+                if (dIn->m_notify != NULL)
+                {
+                    dIn->m_notify->NotifyDInEvent(dIn->m_slot,
+                                                  event.channel,
+                                                  event.fActive,
+                                                  event.timestamp);
+                }
+            }
+        }
+
+        TExit();
+        return 0;
+    }   //DispatchTask
+
+    /**
+     * This function does the common initialization of the DigitalIn object.
+     */
+    void
+    DigitalInInit(
+        void
+        )
+    {
+        TLevel(INIT);
+        TEnter();
+
+        m_prevDIn = GetDIO();
+        m_intMask = 0;
+        m_numInterrupts = 0;
+        m_eventHead = 0;
+        m_eventTail = 0;
+        m_eventSem = NULL;
+        m_dispatchTask = NULL;
+
+        TExit();
+    }   //DigitalInInit
 
 public:
     /**
@@ -91,9 +282,7 @@ public:
     {
         TLevel(INIT);
         TEnterMsg(("Slot=%d,mask=%x,notify=%p", m_slot, notifyMask, notify));
-
-        m_prevDIn = GetDIO();
-
+        DigitalInInit();
         TExit();
     }   //DigitalIn
 
@@ -117,9 +306,7 @@ public:
     {
         TLevel(INIT);
         TEnterMsg(("Slot=%d,mask=%x,notify=%p", slot, notifyMask, notify));
-
-        m_prevDIn = GetDIO();
-
+        DigitalInInit();
         TExit();
     }   //DigitalIn
 
@@ -132,9 +319,93 @@ public:
     {
         TLevel(INIT);
         TEnter();
+
+        for (int i = 0; i < m_numInterrupts; i++)
+        {
+            //
+            // The DigitalInput destructor cancels the interrupt and frees
+            // its interrupt index.
+            //
+            SAFE_DELETE(m_interrupts[i].input);
+        }
+        SAFE_DELETE(m_dispatchTask);
+        if (m_eventSem != NULL)
+        {
+            semDelete(m_eventSem);
+        }
+
         TExit();
     }   //~DigitalIn
 
+    /**
+     * This function makes the given channels interrupt driven. Their events
+     * are no longer reported by DigitalInTask. The FPGA has a limited number
+     * of interrupts shared with other sensors, and the channels must not be
+     * allocated as DigitalInput elsewhere.
+     *
+     * @param intMask Specifies the channel mask (DInMask) to be interrupt
+     *        driven.
+     *
+     * @return Returns true if successful, false if the mask has bits that
+     *         are not valid channels or there are not enough interrupts.
+     */
+    bool
+    SetInterruptMask(
+        __in UINT32 intMask
+        )
+    {
+        bool fSuccess = true;
+
+        TLevel(API);
+        TEnterMsg(("intMask=%x", intMask));
+
+        if (intMask & ~DInAllMask)
+        {
+            TErr(("Invalid channel mask %x.", intMask));
+            fSuccess = false;
+        }
+        else
+        {
+            if (m_dispatchTask == NULL)
+            {
+                m_eventSem = semCCreate(SEM_Q_PRIORITY, 0);
+                m_dispatchTask = new Task("TrcDInDispatch",
+                                          (FUNCPTR)DigitalIn::DispatchTask,
+                                          DIGITALIN_DISPATCH_PRIORITY);
+                m_dispatchTask->Start((UINT32)this);
+            }
+
+            intMask &= ~m_intMask;
+            while (intMask != 0)
+            {
+                UINT32 mask = intMask & -intMask;
+
+                if (m_numInterrupts >= DIGITALIN_MAX_INTERRUPTS)
+                {
+                    TErr(("Too many interrupt channels."));
+                    fSuccess = false;
+                    break;
+                }
+
+                DInInterrupt *interrupt = &m_interrupts[m_numInterrupts];
+                interrupt->dIn = this;
+                interrupt->channel = DInChannel(mask);
+                interrupt->input = new DigitalInput(m_slot,
+                                                    interrupt->channel);
+                interrupt->input->RequestInterrupts(
+                    DigitalIn::InterruptHandler, interrupt);
+                interrupt->input->SetUpSourceEdge(true, true);
+                interrupt->input->EnableInterrupts();
+                m_numInterrupts++;
+                m_intMask |= mask;
+                intMask &= ~mask;
+            }
+        }
+
+        TExitMsg(("=%d", fSuccess));
+        return fSuccess;
+    }   //SetInterruptMask
+
     /**
      * This function returns the state of the a digital input channel.
      *
@@ -175,7 +446,8 @@ public:
         UINT16 currDIn = GetDIO();
         if (m_notify != NULL)
         {
-            UINT16 changedDIn = (m_prevDIn^currDIn) & m_notifyMask;
+            UINT16 changedDIn = (m_prevDIn^currDIn) & m_notifyMask &
+                                ~m_intMask;
             UINT16 maskDIn;
             UINT32 channel;
 
@@ -185,13 +457,7 @@ public:
                 // maskButton contains the least significant set bit.
                 //
                 maskDIn = changedDIn & ~(changedDIn^-changedDIn);
-                for (channel = 1; channel <= MAX_DIGITAL_CHANNEL; channel++)
-                {
-                    if (maskDIn == DInMask(channel))
-                    {
-                        break;
-                    }
-                }
+                channel = DInChannel(maskDIn);
 
                 if ((currDIn & maskDIn) != 0)
                 {
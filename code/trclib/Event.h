@@ -25,6 +25,30 @@
 #endif
 #define MOD_NAME                "Event"
 
+class Event;
+
+/**
+ * This abstract class defines the EventListener object. The object is a
+ * callback interface. It is not meant to be created as an object. Instead,
+ * it should be inherited by a subclass who needs to be called when an event
+ * is signaled instead of polling it.
+ */
+class EventListener
+{
+public:
+    /**
+     * This function is called when a listened event is signaled. It may be
+     * called from any task, so it should only record the fact.
+     *
+     * @param event Points to the signaled event.
+     */
+    virtual
+    void
+    EventSignaled(
+        __in Event *event
+        ) = 0;
+};  //class EventListener
+
 /**
  * This class defines the event object. An event object is used with a
  * state machine. After the state machine has initiated an operation, it
@@ -38,7 +62,8 @@
 class Event
 {
 private:
-    bool    m_fSignaled;
+    volatile bool            m_fSignaled;
+    EventListener * volatile m_listener;
 
 public:
     /**
@@ -46,7 +71,8 @@ public:
      */
     Event(
         void
-        ): m_fSignaled(false)
+        ): m_fSignaled(false),
+           m_listener(NULL)
     {
         TLevel(INIT);
         TEnter();
@@ -75,7 +101,14 @@ public:
     {
         TLevel(API);
         TEnter();
+
         m_fSignaled = true;
+        EventListener *listener = m_listener;
+        if (listener != NULL)
+        {
+            listener->EventSignaled(this);
+        }
+
         TExit();
     }   //SetEvent
 
@@ -109,6 +142,23 @@ public:
         TExitMsg(("=%d", m_fSignaled));
         return m_fSignaled;
     }   //IsSignaled
+
+    /**
+     * This function sets the listener to be called when the event is
+     * signaled. An event has at most one listener.
+     *
+     * @param listener Points to the listener, NULL to remove it.
+     */
+    void
+    SetListener(
+        __in EventListener *listener
+        )
+    {
+        TLevel(API);
+        TEnterMsg(("listener=%p", listener));
+        m_listener = listener;
+        TExit();
+    }   //SetListener
 };  //class Event
 
 #endif  //ifndef _EVENT_H
@@ -0,0 +1,875 @@
+#if 0
+/// Copyright (c) Titan Robotics Club. All rights reserved.
+///
+/// <module name="FlightRecorder.h" />
+///
+/// <summary>
+///     This module contains the definition and implementation of the
+///     FlightRecorder class.
+/// </summary>
+///
+/// <remarks>
+///     Environment: Wind River C++ for National Instrument cRIO based Robot.
+/// </remarks>
+#endif
+
+#ifndef _FLIGHTRECORDER_H
+#define _FLIGHTRECORDER_H
+
+#ifdef MOD_ID
+    #undef MOD_ID
+#endif
+#define MOD_ID                  MOD_FLTREC
+#ifdef MOD_NAME
+    #undef MOD_NAME
+#endif
+#define MOD_NAME                "FlightRecorder"
+
+//
+// Constants.
+//
+#define FLTREC_MAX_CHANNELS     32
+#define FLTREC_NAME_LEN         24
+#define FLTREC_FILENAME_LEN     64
+#define FLTREC_MAX_BUTTONS      12
+#define FLTREC_DUMP_PRIORITY    150
+#define FLTREC_MAX_DUMPS        16
+#define FLTREC_MAX_FATAL_ERRORS 16
+
+//
+// Dump file format. The file starts with a header, followed by the channel
+// names (FLTREC_NAME_LEN characters each, zero padded) and then the
+// snapshots from the oldest to the newest. Each snapshot is the timestamp
+// in usec (UINT32) followed by one float per channel. All values are in
+// the byte order of the robot (big endian).
+//
+#define FLTREC_MAGIC            0x46524543      //"FREC"
+#define FLTREC_VERSION          1
+
+//
+// FlightRecorder options.
+//
+#define FLTRECO_CSV             0x00000001
+
+//
+// Channel types.
+//
+#define FLTREC_CHAN_VALUE       0
+#define FLTREC_CHAN_SENSOR      1
+#define FLTREC_CHAN_MOTOR       2
+#define FLTREC_CHAN_PID_TARGET  3
+#define FLTREC_CHAN_PID_ERROR   4
+#define FLTREC_CHAN_PID_OUTPUT  5
+#define FLTREC_CHAN_HID_X       6
+#define FLTREC_CHAN_HID_Y       7
+#define FLTREC_CHAN_HID_Z       8
+#define FLTREC_CHAN_HID_BUTTONS 9
+
+/**
+ * This structure is the header of the dump file.
+ */
+typedef struct _FltRecHeader
+{
+    UINT32 magic;
+    UINT32 version;
+    UINT32 numChannels;
+    UINT32 numSnapshots;
+} FltRecHeader;
+
+/**
+ * This structure identifies a fatal error reported by WPILib.
+ */
+typedef struct _FltRecError
+{
+    INT32       statusCode;
+    const char *fileName;
+    UINT32      lineNumber;
+} FltRecError;
+
+/**
+ * This class defines and implements the FlightRecorder object. It is a
+ * subsystem that takes a snapshot of all its channels every time its
+ * action tasks are called and keeps the most recent snapshots in a circular
+ * buffer allocated at creation time. Channels can be plain float variables,
+ * sensors (any WPILib PIDSource), motors, TrcPIDCtrl controllers or
+ * joysticks. The buffer is dumped to a new file on flash when the robot is
+ * disabled, when a fatal error is reported by WPILib, when a dump button is
+ * pressed or when RequestDump is called. The dump is written by a low
+ * priority task so it does not hold up the robot loop; recording is paused
+ * while the dump is in progress. A fatal error is only dumped the first time
+ * it is reported, and the dump files are numbered in a ring of
+ * FLTREC_MAX_DUMPS indices so a long run never fills up the flash.
+ */
+class FlightRecorder: public SubSystem
+{
+private:
+    UINT32           m_options;
+    char             m_filePrefix[FLTREC_FILENAME_LEN];
+    UINT32           m_numChannels;
+    char             m_chanNames[FLTREC_MAX_CHANNELS][FLTREC_NAME_LEN];
+    UINT32           m_chanTypes[FLTREC_MAX_CHANNELS];
+    void            *m_chanSources[FLTREC_MAX_CHANNELS];
+    UINT32           m_maxSnapshots;
+    UINT32          *m_timestamps;
+    float           *m_values;
+    UINT32           m_head;
+    UINT32           m_numSnapshots;
+    UINT32           m_dumpIndex;
+    bool             m_fDumpIndexValid;
+    SEM_ID           m_errorSem;
+    UINT32           m_numErrors;
+    FltRecError      m_errors[FLTREC_MAX_FATAL_ERRORS];
+    volatile bool    m_fDumping;
+    SEM_ID           m_dumpSem;
+    Task            *m_dumpTask;
+    GenericHID      *m_dumpHID;
+    UINT32           m_dumpButton;
+    bool             m_fDumpButtonPressed;
+
+    /**
+     * This function adds a channel.
+     *
+     * @param name Specifies the channel name.
+     * @param suffix Specifies the suffix to append to the name, can be NULL.
+     * @param type Specifies the channel type.
+     * @param source Points to the channel source object.
+     *
+     * @return Returns true if the channel is added, false if there are
+     *         too many channels.
+     */
+    bool
+    AddChannel(
+        __in const char *name,
+        __in const char *suffix,
+        __in UINT32      type,
+        __in void       *source
+        )
+    {
+        bool fAdded = false;
+
+        TLevel(FUNC);
+        TEnterMsg(("name=%s,suffix=%s,type=%d,source=%p",
+                   name, suffix != NULL? suffix: "", type, source));
+
+        if (m_numChannels < FLTREC_MAX_CHANNELS)
+        {
+            snprintf(m_chanNames[m_numChannels], FLTREC_NAME_LEN, "%s%s",
+                     name, suffix != NULL? suffix: "");
+            m_chanTypes[m_numChannels] = type;
+            m_chanSources[m_numChannels] = source;
+            m_numChannels++;
+            //
+            // Old snapshots do not have the new channel.
+            //
+            m_head = 0;
+            m_numSnapshots = 0;
+            fAdded = true;
+        }
+        else
+        {
+            TErr(("Too many channels (%s%s).",
+                  name, suffix != NULL? suffix: ""));
+        }
+
+        TExitMsg(("=%d", fAdded));
+        return fAdded;
+    }   //AddChannel
+
+    /**
+     * This function reads the current value of a channel.
+     *
+     * @param chan Specifies the channel index.
+     *
+     * @return Returns the channel value.
+     */
+    float
+    ReadChannel(
+        __in UINT32 chan
+        )
+    {
+        float value = 0.0;
+        void *source = m_chanSources[chan];
+
+        TLevel(HIFREQ);
+        TEnterMsg(("chan=%d", chan));
+
+        switch (m_chanTypes[chan])
+        {
+        case FLTREC_CHAN_VALUE:
+            value = *(float *)source;
+            break;
+
+        case FLTREC_CHAN_SENSOR:
+            value = (float)((PIDSource *)source)->PIDGet();
+            break;
+
+        case FLTREC_CHAN_MOTOR:
+            value = ((SpeedController *)source)->Get();
+            break;
+
+        case FLTREC_CHAN_PID_TARGET:
+            value = ((TrcPIDCtrl *)source)->GetTarget();
+            break;
+
+        case FLTREC_CHAN_PID_ERROR:
+            value = ((TrcPIDCtrl *)source)->GetError();
+            break;
+
+        case FLTREC_CHAN_PID_OUTPUT:
+            value = ((TrcPIDCtrl *)source)->GetOutput();
+            break;
+
+        case FLTREC_CHAN_HID_X:
+            value = ((GenericHID *)source)->GetX();
+            break;
+
+        case FLTREC_CHAN_HID_Y:
+            value = ((GenericHID *)source)->GetY();
+            break;
+
+        case FLTREC_CHAN_HID_Z:
+            value = ((GenericHID *)source)->GetZ();
+            break;
+
+        case FLTREC_CHAN_HID_BUTTONS:
+            {
+                UINT32 buttons = 0;
+                for (UINT32 i = 0; i < FLTREC_MAX_BUTTONS; i++)
+                {
+                    if (((GenericHID *)source)->GetRawButton(i + 1))
+                    {
+                        buttons |= 1 << i;
+                    }
+                }
+                value = (float)buttons;
+            }
+            break;
+        }
+
+        TExitMsg(("=%f", value));
+        return value;
+    }   //ReadChannel
+
+    /**
+     * This function builds the name of a dump file.
+     *
+     * @param fileName Points to the buffer to receive the file name.
+     * @param size Specifies the size of the buffer.
+     * @param index Specifies the dump index.
+     * @param ext Specifies the file extension.
+     */
+    void
+    GetDumpFileName(
+        __out char       *fileName,
+        __in  size_t      size,
+        __in  UINT32      index,
+        __in  const char *ext
+        )
+    {
+        TLevel(UTIL);
+        TEnterMsg(("fileName=%p,size=%d,index=%d,ext=%s",
+                   fileName, size, index, ext));
+        snprintf(fileName, size, "%s%03d.%s", m_filePrefix, index, ext);
+        TExitMsg(("=%s", fileName));
+        return;
+    }   //GetDumpFileName
+
+    /**
+     * This function finds the dump index to use after a reboot, so the dumps
+     * of a previous run are not overwritten. The dump after the newest one
+     * is always deleted, so the ring of dump files has a gap right after the
+     * newest dump and the next index is the first missing one that follows
+     * an existing one.
+     */
+    void
+    FindNextDumpIndex(
+        void
+        )
+    {
+        char dirName[FLTREC_FILENAME_LEN];
+        const char *baseName;
+        const char *slash = strrchr(m_filePrefix, '/');
+        bool fExists[FLTREC_MAX_DUMPS];
+        DIR *dir;
+
+        TLevel(FUNC);
+        TEnter();
+
+        if (slash == NULL)
+        {
+            strcpy(dirName, ".");
+            baseName = m_filePrefix;
+        }
+        else
+        {
+            size_t len = (slash == m_filePrefix)? 1: slash - m_filePrefix;
+            strncpy(dirName, m_filePrefix, len);
+            dirName[len] = '\0';
+            baseName = slash + 1;
+        }
+
+        for (UINT32 i = 0; i < FLTREC_MAX_DUMPS; i++)
+        {
+            fExists[i] = false;
+        }
+
+        dir = opendir(dirName);
+        if (dir != NULL)
+        {
+            size_t baseLen = strlen(baseName);
+            struct dirent *entry;
+            unsigned int index;
+
+            while ((entry = readdir(dir)) != NULL)
+            {
+                if ((strncmp(entry->d_name, baseName, baseLen) == 0) &&
+                    (sscanf(&entry->d_name[baseLen], "%u", &index) == 1) &&
+                    (index < FLTREC_MAX_DUMPS))
+                {
+                    fExists[index] = true;
+                }
+            }
+            closedir(dir);
+        }
+
+        m_dumpIndex = 0;
+        for (UINT32 i = 0; i < FLTREC_MAX_DUMPS; i++)
+        {
+            if (!fExists[i] &&
+                fExists[(i + FLTREC_MAX_DUMPS - 1)%FLTREC_MAX_DUMPS])
+            {
+                m_dumpIndex = i;
+                break;
+            }
+        }
+        m_fDumpIndexValid = true;
+
+        TExitMsg(("=%d", m_dumpIndex));
+        return;
+    }   //FindNextDumpIndex
+
+    /**
+     * This function writes the recorded snapshots to a new file.
+     */
+    void
+    WriteDump(
+        void
+        )
+    {
+        char fileName[FLTREC_FILENAME_LEN + 16];
+        FILE *file;
+        UINT32 numChannels = m_numChannels;
+        UINT32 numSnapshots = m_numSnapshots;
+        UINT32 idx = (m_head + m_maxSnapshots - numSnapshots)%m_maxSnapshots;
+
+        TLevel(FUNC);
+        TEnter();
+
+        if (!m_fDumpIndexValid)
+        {
+            FindNextDumpIndex();
+        }
+        GetDumpFileName(fileName, sizeof(fileName), m_dumpIndex,
+                        (m_options & FLTRECO_CSV)? "csv": "bin");
+        m_dumpIndex = (m_dumpIndex + 1)%FLTREC_MAX_DUMPS;
+
+        file = fopen(fileName, "w");
+        if (file == NULL)
+        {
+            TErr(("Failed to create %s.", fileName));
+        }
+        else if (m_options & FLTRECO_CSV)
+        {
+            fprintf(file, "time");
+            for (UINT32 chan = 0; chan < numChannels; chan++)
+            {
+                fprintf(file, ",%s", m_chanNames[chan]);
+            }
+            fprintf(file, "\n");
+
+            for (UINT32 i = 0; i < numSnapshots; i++)
+            {
+                float *values = &m_values[idx*FLTREC_MAX_CHANNELS];
+                fprintf(file, "%u", m_timestamps[idx]);
+                for (UINT32 chan = 0; chan < numChannels; chan++)
+                {
+                    fprintf(file, ",%f", values[chan]);
+                }
+                fprintf(file, "\n");
+                idx = (idx + 1)%m_maxSnapshots;
+            }
+        }
+        else
+        {
+            FltRecHeader header;
+
+            header.magic = FLTREC_MAGIC;
+            header.version = FLTREC_VERSION;
+            header.numChannels = numChannels;
+            header.numSnapshots = numSnapshots;
+            fwrite(&header, sizeof(header), 1, file);
+            fwrite(m_chanNames, FLTREC_NAME_LEN, numChannels, file);
+
+            for (UINT32 i = 0; i < numSnapshots; i++)
+            {
+                fwrite(&m_timestamps[idx], sizeof(UINT32), 1, file);
+                fwrite(&m_values[idx*FLTREC_MAX_CHANNELS], sizeof(float),
+                       numChannels, file);
+                idx = (idx + 1)%m_maxSnapshots;
+            }
+        }
+
+        if (file != NULL)
+        {
+            fclose(file);
+            //
+            // The next dump only gets the loops recorded after this one.
+            //
+            m_numSnapshots = 0;
+            TInfo(("Dumped %d snapshots to %s.", numSnapshots, fileName));
+        }
+
+        //
+        // Delete the oldest dump to keep the gap after the newest one.
+        //
+        GetDumpFileName(fileName, sizeof(fileName), m_dumpIndex, "csv");
+        remove(fileName);
+        GetDumpFileName(fileName, sizeof(fileName), m_dumpIndex, "bin");
+        remove(fileName);
+
+        TExit();
+    }   //WriteDump
+
+    /**
+     * This function is the dump task. It waits for dump requests and writes
+     * the snapshots to a file.
+     *
+     * @param recorder Points to the FlightRecorder object.
+     *
+     * @return Returns 0.
+     */
+    static
+    int
+    DumpTask(
+        __in FlightRecorder *recorder
+        )
+    {
+        TLevel(TASK);
+        TEnterMsg(("recorder=%p", recorder));
+
+        while (semTake(recorder->m_dumpSem, WAIT_FOREVER) == OK)
+        {
+            if (recorder->m_numSnapshots > 0)
+            {
+                recorder->WriteDump();
+            }
+            recorder->m_fDumping = false;
+        }
+
+        TExit();
+        return 0;
+    }   //DumpTask
+
+    /**
+     * This function records a fatal error and determines if it is reported
+     * for the first time. Some WPILib errors are reported every loop, so
+     * only the first report of each error is dumped. Once the error table
+     * is full, new errors are no longer dumped either.
+     *
+     * @param statusCode Specifies the error status code.
+     * @param fileName Specifies the source file reporting the error.
+     * @param lineNumber Specifies the source line reporting the error.
+     *
+     * @return Returns true if the error is new, false otherwise.
+     */
+    bool
+    AddFatalError(
+        __in INT32       statusCode,
+        __in const char *fileName,
+        __in UINT32      lineNumber
+        )
+    {
+        bool fNew = true;
+
+        TLevel(FUNC);
+        TEnterMsg(("status=%d,file=%s,line=%d",
+                   statusCode, fileName, lineNumber));
+
+        CRITICAL_REGION(m_errorSem)
+        {
+            for (UINT32 i = 0; i < m_numErrors; i++)
+            {
+                if ((m_errors[i].statusCode == statusCode) &&
+                    (m_errors[i].lineNumber == lineNumber) &&
+                    (strcmp(m_errors[i].fileName, fileName) == 0))
+                {
+                    fNew = false;
+                    break;
+                }
+            }
+
+            if (fNew)
+            {
+                if (m_numErrors < FLTREC_MAX_FATAL_ERRORS)
+                {
+                    m_errors[m_numErrors].statusCode = statusCode;
+                    m_errors[m_numErrors].fileName = fileName;
+                    m_errors[m_numErrors].lineNumber = lineNumber;
+                    m_numErrors++;
+                }
+                else
+                {
+                    TWarn(("Too many fatal errors, not dumped."));
+                    fNew = false;
+                }
+            }
+        }
+        END_REGION;
+
+        TExitMsg(("=%d", fNew));
+        return fNew;
+    }   //AddFatalError
+
+    /**
+     * This function is called by WPILib when a fatal error is reported.
+     *
+     * @param recorder Points to the FlightRecorder object.
+     * @param statusCode Specifies the error status code.
+     * @param fileName Specifies the source file reporting the error.
+     * @param lineNumber Specifies the source line reporting the error.
+     */
+    static
+    void
+    FatalHook(
+        __in void       *recorder,
+        __in INT32       statusCode,
+        __in const char *fileName,
+        __in UINT32      lineNumber
+        )
+    {
+        TLevel(CALLBK);
+        TEnterMsg(("recorder=%p,status=%d,file=%s,line=%d",
+                   recorder, statusCode, fileName, lineNumber));
+        if (((FlightRecorder *)recorder)->AddFatalError(statusCode,
+                                                        fileName,
+                                                        lineNumber))
+        {
+            ((FlightRecorder *)recorder)->RequestDump();
+        }
+        TExit();
+    }   //FatalHook
+
+public:
+    /**
+     * Constructor: Create an instance of the FlightRecorder object.
+     *
+     * @param maxSnapshots Specifies the number of snapshots to keep, e.g.
+     *        10 seconds at a 20 msec loop period is 500 snapshots.
+     * @param filePrefix Specifies the path and file name prefix of the dump
+     *        files. A sequence number and extension is appended.
+     * @param options Specifies the option flags.
+     * @param flags Specifies additional subsystem flags, e.g. the rate group
+     *        the recorder should run in.
+     */
+    FlightRecorder(
+        __in UINT32      maxSnapshots,
+        __in const char *filePrefix = "/FltRec",
+        __in UINT32      options = 0,
+        __in UINT32      flags = 0
+        ): m_options(options),
+           m_numChannels(0),
+           m_maxSnapshots(maxSnapshots),
+           m_head(0),
+           m_numSnapshots(0),
+           m_dumpIndex(0),
+           m_fDumpIndexValid(false),
+           m_numErrors(0),
+           m_fDumping(false),
+           m_dumpHID(NULL),
+           m_dumpButton(0),
+           m_fDumpButtonPressed(false)
+    {
+        TLevel(INIT);
+        TEnterMsg(("maxSnapshots=%d,prefix=%s,options=%x,flags=%x",
+                   maxSnapshots, filePrefix, options, flags));
+
+        strncpy(m_filePrefix, filePrefix, sizeof(m_filePrefix) - 1);
+        m_filePrefix[sizeof(m_filePrefix) - 1] = '\0';
+        m_timestamps = new UINT32[maxSnapshots];
+        m_values = new float[maxSnapshots*FLTREC_MAX_CHANNELS];
+        m_dumpSem = semBCreate(SEM_Q_PRIORITY, SEM_EMPTY);
+        m_errorSem = semMCreate(SEM_Q_PRIORITY | SEM_DELETE_SAFE |
+                                SEM_INVERSION_SAFE);
+        m_dumpTask = new Task("TrcFltRecDump",
+                              (FUNCPTR)FlightRecorder::DumpTask,
+                              FLTREC_DUMP_PRIORITY);
+        m_dumpTask->Start((UINT32)this);
+        wpi_setFatalHook(FlightRecorder::FatalHook, this);
+        RegisterSubSystem(SUBSYS_STOP | SUBSYS_ACTION_TASKS | flags);
+
+        TExit();
+    }   //FlightRecorder
+
+    /**
+     * Destructor: Destroy an instance of the FlightRecorder object.
+     */
+    ~FlightRecorder(
+        void
+        )
+    {
+        TLevel(INIT);
+        TEnter();
+
+        wpi_setFatalHook(NULL, NULL);
+        SAFE_DELETE(m_dumpTask);
+        semDelete(m_dumpSem);
+        semDelete(m_errorSem);
+        delete [] m_timestamps;
+        delete [] m_values;
+
+        TExit();
+    }   //~FlightRecorder
+
+    /**
+     * This function adds a float variable channel. The variable must stay
+     * valid for the life of the recorder.
+     *
+     * @param name Specifies the channel name.
+     * @param value Points to the variable.
+     *
+     * @return Returns true if the channel is added.
+     */
+    bool
+    AddValueChannel(
+        __in const char *name,
+        __in float      *value
+        )
+    {
+        TLevel(API);
+        TEnterMsg(("name=%s,value=%p", name, value));
+        bool fAdded = AddChannel(name, NULL, FLTREC_CHAN_VALUE, value);
+        TExitMsg(("=%d", fAdded));
+        return fAdded;
+    }   //AddValueChannel
+
+    /**
+     * This function adds a sensor channel. Any WPILib sensor implementing
+     * PIDSource (e.g. Encoder, Gyro, AnalogChannel) can be recorded.
+     *
+     * @param name Specifies the channel name.
+     * @param sensor Points to the sensor.
+     *
+     * @return Returns true if the channel is added.
+     */
+    bool
+    AddSensorChannel(
+        __in const char *name,
+        __in PIDSource  *sensor
+        )
+    {
+        TLevel(API);
+        TEnterMsg(("name=%s,sensor=%p", name, sensor));
+        bool fAdded = AddChannel(name, NULL, FLTREC_CHAN_SENSOR, sensor);
+        TExitMsg(("=%d", fAdded));
+        return fAdded;
+    }   //AddSensorChannel
+
+    /**
+     * This function adds a motor output channel.
+     *
+     * @param name Specifies the channel name.
+     * @param motor Points to the motor speed controller.
+     *
+     * @return Returns true if the channel is added.
+     */
+    bool
+    AddMotorChannel(
+        __in const char      *name,
+        __in SpeedController *motor
+        )
+    {
+        TLevel(API);
+        TEnterMsg(("name=%s,motor=%p", name, motor));
+        bool fAdded = AddChannel(name, NULL, FLTREC_CHAN_MOTOR, motor);
+        TExitMsg(("=%d", fAdded));
+        return fAdded;
+    }   //AddMotorChannel
+
+    /**
+     * This function adds the setpoint, error and output channels of a PID
+     * controller.
+     *
+     * @param name Specifies the channel name prefix.
+     * @param pidCtrl Points to the PID controller.
+     *
+     * @return Returns true if the channels are added.
+     */
+    bool
+    AddPIDChannels(
+        __in const char *name,
+        __in TrcPIDCtrl *pidCtrl
+        )
+    {
+        TLevel(API);
+        TEnterMsg(("name=%s,pidCtrl=%p", name, pidCtrl));
+
+        bool fAdded =
+            AddChannel(name, ".target", FLTREC_CHAN_PID_TARGET, pidCtrl) &&
+            AddChannel(name, ".error", FLTREC_CHAN_PID_ERROR, pidCtrl) &&
+            AddChannel(name, ".output", FLTREC_CHAN_PID_OUTPUT, pidCtrl);
+
+        TExitMsg(("=%d", fAdded));
+        return fAdded;
+    }   //AddPIDChannels
+
+    /**
+     * This function adds the X, Y, Z axis channels and a button bit mask
+     * channel of a joystick.
+     *
+     * @param name Specifies the channel name prefix.
+     * @param hid Points to the joystick.
+     *
+     * @return Returns true if the channels are added.
+     */
+    bool
+    AddJoystickChannels(
+        __in const char *name,
+        __in GenericHID *hid
+        )
+    {
+        TLevel(API);
+        TEnterMsg(("name=%s,hid=%p", name, hid));
+
+        bool fAdded =
+            AddChannel(name, ".x", FLTREC_CHAN_HID_X, hid) &&
+            AddChannel(name, ".y", FLTREC_CHAN_HID_Y, hid) &&
+            AddChannel(name, ".z", FLTREC_CHAN_HID_Z, hid) &&
+            AddChannel(name, ".buttons", FLTREC_CHAN_HID_BUTTONS, hid);
+
+        TExitMsg(("=%d", fAdded));
+        return fAdded;
+    }   //AddJoystickChannels
+
+    /**
+     * This function sets the joystick button that requests a dump.
+     *
+     * @param hid Points to the joystick, NULL to remove the dump button.
+     * @param button Specifies the button number.
+     */
+    void
+    SetDumpButton(
+        __in GenericHID *hid,
+        __in UINT32      button
+        )
+    {
+        TLevel(API);
+        TEnterMsg(("hid=%p,button=%d", hid, button));
+
+        m_dumpHID = hid;
+        m_dumpButton = button;
+        m_fDumpButtonPressed = false;
+
+        TExit();
+    }   //SetDumpButton
+
+    /**
+     * This function requests the recorded snapshots to be written to a new
+     * file. It can be called from any task. Recording is paused right away,
+     * so the loops that led to the request are not overwritten before the
+     * dump task gets to run. A request made while a dump is pending is
+     * merged into it.
+     */
+    void
+    RequestDump(
+        void
+        )
+    {
+        TLevel(API);
+        TEnter();
+        if (!m_fDumping)
+        {
+            m_fDumping = true;
+            semGive(m_dumpSem);
+        }
+        TExit();
+    }   //RequestDump
+
+    /**
+     * This function takes a snapshot of all the channels.
+     */
+    void
+    Record(
+        void
+        )
+    {
+        TLevel(HIFREQ);
+        TEnter();
+
+        if (!m_fDumping && (m_numChannels > 0))
+        {
+            float *values = &m_values[m_head*FLTREC_MAX_CHANNELS];
+
+            m_timestamps[m_head] = GetFPGATime();
+            for (UINT32 chan = 0; chan < m_numChannels; chan++)
+            {
+                values[chan] = ReadChannel(chan);
+            }
+
+            m_head = (m_head + 1)%m_maxSnapshots;
+            if (m_numSnapshots < m_maxSnapshots)
+            {
+                m_numSnapshots++;
+            }
+        }
+
+        TExit();
+    }   //Record
+
+    /**
+     * This function is called when the subsystem is stopped, i.e. when the
+     * robot is disabled. It dumps the snapshots of the period just ended.
+     *
+     * @param context Specifies the caller context.
+     */
+    void
+    Stop(
+        __in UINT32 context
+        )
+    {
+        TLevel(CALLBK);
+        TEnterMsg(("context=%d", context));
+        RequestDump();
+        TExit();
+    }   //Stop
+
+    /**
+     * This function is called to perform subsystem action tasks. It takes a
+     * snapshot and checks the dump button.
+     *
+     * @param context Specifies the caller context.
+     */
+    void
+    ActionTasks(
+        __in UINT32 context
+        )
+    {
+        TLevel(TASK);
+        TEnterMsg(("context=%d", context));
+
+        Record();
+
+        if (m_dumpHID != NULL)
+        {
+            bool fPressed = m_dumpHID->GetRawButton(m_dumpButton);
+            if (fPressed && !m_fDumpButtonPressed)
+            {
+                RequestDump();
+            }
+            m_fDumpButtonPressed = fPressed;
+        }
+
+        TExit();
+    }   //ActionTasks
+};  //class FlightRecorder
+
+#endif  //ifndef _FLIGHTRECORDER_H
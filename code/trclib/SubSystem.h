@@ -36,6 +36,35 @@
 #define SUBSYS_INPUT_TASKS      0x00000008
 #define SUBSYS_ACTION_TASKS     0x00000010
 
+//
+// Rate groups. A subsystem joins a rate group by or'ing SUBSYS_RATEGROUP()
+// into its registration flags. Subsystems without it belong to the operator
+// rate group which runs with the main robot loop period.
+//
+#define RATEGROUP_OPERATOR      0
+#define RATEGROUP_CONTROL       1
+#define RATEGROUP_TELEMETRY     2
+#define MAX_NUM_RATEGROUPS      3
+
+#define SUBSYS_RATEGROUP_MASK   0x000f0000
+#define SUBSYS_RATEGROUP(g)     (((g) << 16) & SUBSYS_RATEGROUP_MASK)
+#define SubSysRateGroup(f)      (((f) & SUBSYS_RATEGROUP_MASK) >> 16)
+
+//
+// Scheduler modes.
+//
+#define SUBSYSSCHED_FIXED_ORDER 0
+#define SUBSYSSCHED_DEADLINE    1
+
+//
+// Subsystem priorities used by the deadline scheduler. A critical subsystem
+// is never deferred even if the frame budget is exhausted.
+//
+#define SUBSYS_PRIO_CRITICAL    0
+#define SUBSYS_PRIO_HIGH        1
+#define SUBSYS_PRIO_NORMAL      2
+#define SUBSYS_PRIO_LOW         3
+
 #define CONTEXT_NONE            0
 #define CONTEXT_DISABLED        1
 #define CONTEXT_AUTONOMOUS      2
@@ -53,13 +82,34 @@ public:
      * This function registers a subsystem object.
      *
      * @param flags Specifies the subsystem callback types.
+     * @param period Specifies the subsystem period in msec used by the
+     *        deadline scheduler. Zero means every frame.
+     * @param priority Specifies the subsystem priority used by the deadline
+     *        scheduler.
+     * @param budget Specifies the worst case execution time in usec of the
+     *        subsystem input and action tasks combined. Zero means unknown.
      *
      * @return Returns true if the subsystem is successfully registered, false
      *         otherwise.
      */
     bool
     RegisterSubSystem(
-        __in UINT32 flags
+        __in UINT32 flags,
+        __in UINT32 period = 0,
+        __in UINT32 priority = SUBSYS_PRIO_NORMAL,
+        __in UINT32 budget = 0
+        );
+
+    /**
+     * This function unregisters a subsystem object. A subsystem that is
+     * destroyed before the end of the program must call it from its
+     * destructor.
+     *
+     * @return Returns true if the subsystem was registered, false otherwise.
+     */
+    bool
+    UnregisterSubSystem(
+        void
         );
 
     /**
@@ -147,7 +197,13 @@ public:
 };  //class SubSystem
 
 /**
- * This class defines and implements the SubSystemMgr object.
+ * This class defines and implements the SubSystemMgr object. By default, it
+ * calls the registered subsystems in registration order every frame. In
+ * deadline scheduler mode, each subsystem runs at its declared period in
+ * earliest-deadline-first order, and subsystems that do not fit in the
+ * remaining frame budget are deferred to the next frame unless they are
+ * critical. The deadline order applies to the input tasks; the action tasks
+ * of the planned subsystems run in reverse registration order in both modes.
  */
 class SubSystemMgr
 {
@@ -156,6 +212,196 @@ private:
     int                  m_numSubSystems;
     SubSystem           *m_subsystems[MAX_NUM_SUBSYSTEMS];
     UINT32               m_subsysFlags[MAX_NUM_SUBSYSTEMS];
+    //
+    // Deadline scheduler data, all times are in usec.
+    //
+    UINT32               m_schedMode;
+    UINT32               m_frameBudget;
+    UINT32               m_subsysPeriod[MAX_NUM_SUBSYSTEMS];
+    UINT32               m_subsysPriority[MAX_NUM_SUBSYSTEMS];
+    UINT32               m_subsysBudget[MAX_NUM_SUBSYSTEMS];
+    UINT32               m_subsysDeadline[MAX_NUM_SUBSYSTEMS];
+    bool                 m_fDeadlineValid[MAX_NUM_SUBSYSTEMS];
+    UINT32               m_subsysExecTime[MAX_NUM_SUBSYSTEMS];
+    UINT32               m_subsysMaxExecTime[MAX_NUM_SUBSYSTEMS];
+    UINT32               m_subsysOverruns[MAX_NUM_SUBSYSTEMS];
+    UINT32               m_subsysDeferrals[MAX_NUM_SUBSYSTEMS];
+    UINT32               m_subsysMisses[MAX_NUM_SUBSYSTEMS];
+    int                  m_frameOrder[MAX_NUM_SUBSYSTEMS];
+    int                  m_numFrameSubSystems;
+    bool                 m_fFramePlanned[MAX_NUM_SUBSYSTEMS];
+    //
+    // Per-subsystem callback timing statistics in usec.
+    //
+    bool                 m_fTimingEnabled;
+    TrcHistogram         m_inputTasksHist[MAX_NUM_SUBSYSTEMS];
+    TrcHistogram         m_actionTasksHist[MAX_NUM_SUBSYSTEMS];
+
+    /**
+     * This function plans the subsystems to run in the current frame. It
+     * selects the subsystems whose period has come due, sorts them in
+     * earliest-deadline-first order (ties broken by priority) and admits
+     * them until the sum of their budgets exceeds the frame budget. Critical
+     * subsystems are always admitted, and so is the first non-critical one,
+     * even if its budget alone exceeds the frame budget. Subsystems not
+     * admitted keep their deadline so they will sort earlier in the next
+     * frame.
+     *
+     * @param timeCurr Specifies the current time in usec.
+     * @param rateGroup Specifies the rate group of the frame.
+     */
+    void
+    PlanFrame(
+        __in UINT32 timeCurr,
+        __in UINT32 rateGroup
+        )
+    {
+        int numReady = 0;
+        int ready[MAX_NUM_SUBSYSTEMS];
+        UINT32 plannedTime = 0;
+        bool fAdmitted = false;
+
+        TLevel(HIFREQ);
+        TEnterMsg(("time=%d,group=%d", timeCurr, rateGroup));
+
+        for (int idx = 0; idx < m_numSubSystems; idx++)
+        {
+            //
+            // The first release of a mode sets the first deadline one
+            // period out, so the time spent waiting for the mode to start
+            // is not counted as a miss.
+            //
+            if ((SubSysRateGroup(m_subsysFlags[idx]) == rateGroup) &&
+                !m_fDeadlineValid[idx])
+            {
+                m_subsysDeadline[idx] = timeCurr + m_subsysPeriod[idx];
+                m_fDeadlineValid[idx] = true;
+            }
+            //
+            // A subsystem is released one period before its deadline.
+            //
+            if ((SubSysRateGroup(m_subsysFlags[idx]) == rateGroup) &&
+                (m_subsysFlags[idx] &
+                 (SUBSYS_INPUT_TASKS | SUBSYS_ACTION_TASKS)) &&
+                ((INT32)(timeCurr + m_subsysPeriod[idx] -
+                         m_subsysDeadline[idx]) >= 0))
+            {
+                //
+                // Insertion sort by deadline then by priority.
+                //
+                int i = numReady;
+                while (i > 0)
+                {
+                    int prev = ready[i - 1];
+                    INT32 diff = (INT32)(m_subsysDeadline[prev] -
+                                         m_subsysDeadline[idx]);
+                    if ((diff < 0) ||
+                        ((diff == 0) &&
+                         (m_subsysPriority[prev] <= m_subsysPriority[idx])))
+                    {
+                        break;
+                    }
+                    ready[i] = prev;
+                    i--;
+                }
+                ready[i] = idx;
+                numReady++;
+            }
+        }
+
+        m_numFrameSubSystems = 0;
+        for (int idx = 0; idx < m_numSubSystems; idx++)
+        {
+            m_fFramePlanned[idx] = false;
+        }
+
+        for (int i = 0; i < numReady; i++)
+        {
+            int idx = ready[i];
+            bool fCritical = m_subsysPriority[idx] == SUBSYS_PRIO_CRITICAL;
+            if ((m_frameBudget == 0) || fCritical || !fAdmitted ||
+                (plannedTime + m_subsysBudget[idx] <= m_frameBudget))
+            {
+                //
+                // Always admitting the first non-critical subsystem keeps
+                // one with a budget over the frame budget from starving.
+                //
+                if (!fCritical)
+                {
+                    fAdmitted = true;
+                }
+                plannedTime += m_subsysBudget[idx];
+                m_subsysExecTime[idx] = 0;
+                m_frameOrder[m_numFrameSubSystems] = idx;
+                m_numFrameSubSystems++;
+                m_fFramePlanned[idx] = true;
+            }
+            else
+            {
+                m_subsysDeferrals[idx]++;
+                TVerbose(("Deferring subsys %d (budget=%d,planned=%d)",
+                          idx, m_subsysBudget[idx], plannedTime));
+            }
+        }
+
+        TExit();
+        return;
+    }   //PlanFrame
+
+    /**
+     * This function is called after a subsystem has finished its tasks for
+     * the frame. It checks for budget overrun and advances the deadline of
+     * the subsystem to the next period.
+     *
+     * @param idx Specifies the subsystem index.
+     * @param timeCurr Specifies the current time in usec.
+     */
+    void
+    CompleteSubSystem(
+        __in int    idx,
+        __in UINT32 timeCurr
+        )
+    {
+        TLevel(HIFREQ);
+        TEnterMsg(("idx=%d,time=%d", idx, timeCurr));
+
+        if (m_subsysExecTime[idx] > m_subsysMaxExecTime[idx])
+        {
+            m_subsysMaxExecTime[idx] = m_subsysExecTime[idx];
+        }
+
+        if ((m_subsysBudget[idx] != 0) &&
+            (m_subsysExecTime[idx] > m_subsysBudget[idx]))
+        {
+            m_subsysOverruns[idx]++;
+            TWarn(("Subsys %d overran its budget (%d > %d us)",
+                   idx, m_subsysExecTime[idx], m_subsysBudget[idx]));
+        }
+
+        if (m_subsysPeriod[idx] == 0)
+        {
+            //
+            // Subsystem runs every frame, it has no deadline to miss.
+            //
+            m_subsysDeadline[idx] = timeCurr;
+        }
+        else if ((INT32)(timeCurr - m_subsysDeadline[idx]) > 0)
+        {
+            //
+            // We are past the deadline, resync to the current time so we
+            // don't try to catch up with a burst of back-to-back runs.
+            //
+            m_subsysMisses[idx]++;
+            m_subsysDeadline[idx] = timeCurr + m_subsysPeriod[idx];
+        }
+        else
+        {
+            m_subsysDeadline[idx] += m_subsysPeriod[idx];
+        }
+
+        TExit();
+        return;
+    }   //CompleteSubSystem
 
 protected:
     /**
@@ -163,7 +409,11 @@ protected:
      */
     SubSystemMgr(
         void
-        ): m_numSubSystems(0)
+        ): m_numSubSystems(0),
+           m_schedMode(SUBSYSSCHED_FIXED_ORDER),
+           m_frameBudget(0),
+           m_numFrameSubSystems(0),
+           m_fTimingEnabled(false)
     {
         TLevel(INIT);
         TEnter();
@@ -172,6 +422,18 @@ protected:
         {
             m_subsystems[idx] = NULL;
             m_subsysFlags[idx] = 0;
+            m_subsysPeriod[idx] = 0;
+            m_subsysPriority[idx] = SUBSYS_PRIO_NORMAL;
+            m_subsysBudget[idx] = 0;
+            m_subsysDeadline[idx] = 0;
+            m_fDeadlineValid[idx] = false;
+            m_subsysExecTime[idx] = 0;
+            m_subsysMaxExecTime[idx] = 0;
+            m_subsysOverruns[idx] = 0;
+            m_subsysDeferrals[idx] = 0;
+            m_subsysMisses[idx] = 0;
+            m_frameOrder[idx] = 0;
+            m_fFramePlanned[idx] = false;
         }
 
         TExit();
@@ -237,6 +499,12 @@ public:
      * @param subsystem Specifies the subsystem to be registered with
      *        subsystem manager.
      * @param flags Specifies the subsystem callback types.
+     * @param period Specifies the subsystem period in msec used by the
+     *        deadline scheduler. Zero means every frame.
+     * @param priority Specifies the subsystem priority used by the deadline
+     *        scheduler.
+     * @param budget Specifies the worst case execution time in usec of the
+     *        subsystem input and action tasks combined. Zero means unknown.
      *
      * @return Returns true if the subsystem is successfully registered, false
      *         otherwise.
@@ -244,18 +512,27 @@ public:
     bool
     RegisterSubSystem(
         __in SubSystem *subsystem,
-        __in UINT32     flags
+        __in UINT32     flags,
+        __in UINT32     period = 0,
+        __in UINT32     priority = SUBSYS_PRIO_NORMAL,
+        __in UINT32     budget = 0
         )
     {
         bool rc = false;
 
         TLevel(API);
-        TEnterMsg(("subsys=%p,flags=%x", subsystem, flags));
+        TEnterMsg(("subsys=%p,flags=%x,period=%d,priority=%d,budget=%d",
+                   subsystem, flags, period, priority, budget));
 
         if (m_numSubSystems < MAX_NUM_SUBSYSTEMS)
         {
             m_subsystems[m_numSubSystems] = subsystem;
             m_subsysFlags[m_numSubSystems] = flags;
+            m_subsysPeriod[m_numSubSystems] = period*1000;
+            m_subsysPriority[m_numSubSystems] = priority;
+            m_subsysBudget[m_numSubSystems] = budget;
+            m_subsysDeadline[m_numSubSystems] = 0;
+            m_fDeadlineValid[m_numSubSystems] = false;
             m_numSubSystems++;
             rc = true;
         }
@@ -264,6 +541,321 @@ public:
         return rc;
     }   //RegisterSubSystem
 
+    /**
+     * This function unregisters a subsystem object. The subsystems
+     * registered after it move down one slot, so the registration order of
+     * the others is kept. It must not be called from a subsystem callback.
+     *
+     * @param subsystem Specifies the subsystem to be unregistered.
+     *
+     * @return Returns true if the subsystem was registered, false otherwise.
+     */
+    bool
+    UnregisterSubSystem(
+        __in SubSystem *subsystem
+        )
+    {
+        bool rc = false;
+
+        TLevel(API);
+        TEnterMsg(("subsys=%p", subsystem));
+
+        for (int idx = 0; idx < m_numSubSystems; idx++)
+        {
+            if (m_subsystems[idx] != subsystem)
+            {
+                continue;
+            }
+
+            for (int i = idx; i < m_numSubSystems - 1; i++)
+            {
+                m_subsystems[i] = m_subsystems[i + 1];
+                m_subsysFlags[i] = m_subsysFlags[i + 1];
+                m_subsysPeriod[i] = m_subsysPeriod[i + 1];
+                m_subsysPriority[i] = m_subsysPriority[i + 1];
+                m_subsysBudget[i] = m_subsysBudget[i + 1];
+                m_subsysDeadline[i] = m_subsysDeadline[i + 1];
+                m_fDeadlineValid[i] = m_fDeadlineValid[i + 1];
+                m_subsysExecTime[i] = m_subsysExecTime[i + 1];
+                m_subsysMaxExecTime[i] = m_subsysMaxExecTime[i + 1];
+                m_subsysOverruns[i] = m_subsysOverruns[i + 1];
+                m_subsysDeferrals[i] = m_subsysDeferrals[i + 1];
+                m_subsysMisses[i] = m_subsysMisses[i + 1];
+                m_fFramePlanned[i] = m_fFramePlanned[i + 1];
+                m_inputTasksHist[i] = m_inputTasksHist[i + 1];
+                m_actionTasksHist[i] = m_actionTasksHist[i + 1];
+            }
+            m_numSubSystems--;
+            m_subsystems[m_numSubSystems] = NULL;
+            m_subsysFlags[m_numSubSystems] = 0;
+            m_subsysExecTime[m_numSubSystems] = 0;
+            m_subsysMaxExecTime[m_numSubSystems] = 0;
+            m_subsysOverruns[m_numSubSystems] = 0;
+            m_subsysDeferrals[m_numSubSystems] = 0;
+            m_subsysMisses[m_numSubSystems] = 0;
+            m_fFramePlanned[m_numSubSystems] = false;
+            m_inputTasksHist[m_numSubSystems].Reset();
+            m_actionTasksHist[m_numSubSystems].Reset();
+
+            //
+            // It may be called between the input and action tasks of a
+            // frame, so the frame plan is fixed up as well.
+            //
+            int numFrameSubSystems = 0;
+            for (int i = 0; i < m_numFrameSubSystems; i++)
+            {
+                if (m_frameOrder[i] != idx)
+                {
+                    m_frameOrder[numFrameSubSystems] =
+                        (m_frameOrder[i] > idx)? m_frameOrder[i] - 1:
+                                                 m_frameOrder[i];
+                    numFrameSubSystems++;
+                }
+            }
+            m_numFrameSubSystems = numFrameSubSystems;
+            rc = true;
+            break;
+        }
+
+        TExitMsg(("=%x", rc));
+        return rc;
+    }   //UnregisterSubSystem
+
+    /**
+     * This function sets the scheduler mode.
+     *
+     * @param mode Specifies SUBSYSSCHED_FIXED_ORDER to call the subsystems in
+     *        registration order every frame, or SUBSYSSCHED_DEADLINE to call
+     *        them at their declared periods in earliest-deadline-first order.
+     * @param frameBudget Specifies the time budget in usec available to the
+     *        subsystems in each frame. Zero means unlimited.
+     */
+    void
+    SetSchedulerMode(
+        __in UINT32 mode,
+        __in UINT32 frameBudget = 0
+        )
+    {
+        TLevel(API);
+        TEnterMsg(("mode=%d,frameBudget=%d", mode, frameBudget));
+
+        m_schedMode = mode;
+        m_frameBudget = frameBudget;
+        m_numFrameSubSystems = 0;
+        for (int idx = 0; idx < m_numSubSystems; idx++)
+        {
+            m_fFramePlanned[idx] = false;
+        }
+
+        TExit();
+        return;
+    }   //SetSchedulerMode
+
+    /**
+     * This function gets the scheduler statistics of a subsystem.
+     *
+     * @param subsystem Specifies the subsystem.
+     * @param maxExecTime Points to the variable to hold the maximum execution
+     *        time in usec.
+     * @param overruns Points to the variable to hold the number of budget
+     *        overruns.
+     * @param deferrals Points to the variable to hold the number of times
+     *        the subsystem was deferred because the frame budget was
+     *        exhausted.
+     * @param misses Points to the variable to hold the number of missed
+     *        deadlines.
+     *
+     * @return Returns true if the subsystem is found, false otherwise.
+     */
+    bool
+    GetSchedStats(
+        __in  SubSystem *subsystem,
+        __out UINT32    *maxExecTime = NULL,
+        __out UINT32    *overruns = NULL,
+        __out UINT32    *deferrals = NULL,
+        __out UINT32    *misses = NULL
+        )
+    {
+        bool rc = false;
+
+        TLevel(API);
+        TEnterMsg(("subsys=%p", subsystem));
+
+        for (int idx = 0; idx < m_numSubSystems; idx++)
+        {
+            if (m_subsystems[idx] == subsystem)
+            {
+                if (maxExecTime != NULL)
+                {
+                    *maxExecTime = m_subsysMaxExecTime[idx];
+                }
+
+                if (overruns != NULL)
+                {
+                    *overruns = m_subsysOverruns[idx];
+                }
+
+                if (deferrals != NULL)
+                {
+                    *deferrals = m_subsysDeferrals[idx];
+                }
+
+                if (misses != NULL)
+                {
+                    *misses = m_subsysMisses[idx];
+                }
+                rc = true;
+                break;
+            }
+        }
+
+        TExitMsg(("=%x", rc));
+        return rc;
+    }   //GetSchedStats
+
+    /**
+     * This function prints the scheduler statistics of all the registered
+     * subsystems to the console.
+     */
+    void
+    ReportSchedStats(
+        void
+        )
+    {
+        TLevel(API);
+        TEnter();
+
+        printf("Subsys Period Prio Budget MaxExec Overruns Deferrals Misses\n");
+        for (int idx = 0; idx < m_numSubSystems; idx++)
+        {
+            printf("%6d %6d %4d %6d %7d %8d %9d %6d\n",
+                   idx,
+                   m_subsysPeriod[idx]/1000,
+                   m_subsysPriority[idx],
+                   m_subsysBudget[idx],
+                   m_subsysMaxExecTime[idx],
+                   m_subsysOverruns[idx],
+                   m_subsysDeferrals[idx],
+                   m_subsysMisses[idx]);
+        }
+
+        TExit();
+        return;
+    }   //ReportSchedStats
+
+    /**
+     * This function enables or disables the timing statistics of the
+     * subsystem callbacks. The deadline scheduler always collects them.
+     *
+     * @param fEnabled If true, enables the timing statistics.
+     */
+    void
+    EnableTiming(
+        __in bool fEnabled
+        )
+    {
+        TLevel(API);
+        TEnterMsg(("fEnabled=%d", fEnabled));
+        m_fTimingEnabled = fEnabled;
+        TExit();
+        return;
+    }   //EnableTiming
+
+    /**
+     * This function gets the input tasks timing statistics of a subsystem.
+     *
+     * @param subsystem Specifies the subsystem.
+     *
+     * @return Returns the histogram of the InputTasks execution time in
+     *         usec, NULL if the subsystem is not registered.
+     */
+    TrcHistogram *
+    GetInputTasksHist(
+        __in SubSystem *subsystem
+        )
+    {
+        TrcHistogram *hist = NULL;
+
+        TLevel(API);
+        TEnterMsg(("subsys=%p", subsystem));
+
+        for (int idx = 0; idx < m_numSubSystems; idx++)
+        {
+            if (m_subsystems[idx] == subsystem)
+            {
+                hist = &m_inputTasksHist[idx];
+                break;
+            }
+        }
+
+        TExitMsg(("=%p", hist));
+        return hist;
+    }   //GetInputTasksHist
+
+    /**
+     * This function gets the action tasks timing statistics of a subsystem.
+     *
+     * @param subsystem Specifies the subsystem.
+     *
+     * @return Returns the histogram of the ActionTasks execution time in
+     *         usec, NULL if the subsystem is not registered.
+     */
+    TrcHistogram *
+    GetActionTasksHist(
+        __in SubSystem *subsystem
+        )
+    {
+        TrcHistogram *hist = NULL;
+
+        TLevel(API);
+        TEnterMsg(("subsys=%p", subsystem));
+
+        for (int idx = 0; idx < m_numSubSystems; idx++)
+        {
+            if (m_subsystems[idx] == subsystem)
+            {
+                hist = &m_actionTasksHist[idx];
+                break;
+            }
+        }
+
+        TExitMsg(("=%p", hist));
+        return hist;
+    }   //GetActionTasksHist
+
+    /**
+     * This function prints the callback timing statistics of all the
+     * registered subsystems to the console.
+     */
+    void
+    DumpTimingStats(
+        void
+        )
+    {
+        char name[32];
+
+        TLevel(API);
+        TEnter();
+
+        for (int idx = 0; idx < m_numSubSystems; idx++)
+        {
+            if (m_subsysFlags[idx] & SUBSYS_INPUT_TASKS)
+            {
+                sprintf(name, "Subsys%d.Input", idx);
+                m_inputTasksHist[idx].Dump(name);
+            }
+
+            if (m_subsysFlags[idx] & SUBSYS_ACTION_TASKS)
+            {
+                sprintf(name, "Subsys%d.Action", idx);
+                m_actionTasksHist[idx].Dump(name);
+            }
+        }
+
+        TExit();
+        return;
+    }   //DumpTimingStats
+
     /**
      * This function initializes all the registered subsystems.
      */
@@ -303,6 +895,7 @@ public:
         for (int idx = 0; idx < m_numSubSystems; idx++)
         {
             TInfo(("Starting subsys: %d, flags=%x", idx, m_subsysFlags[idx]));
+            m_fDeadlineValid[idx] = false;
             if (m_subsysFlags[idx] & SUBSYS_START)
             {
                 m_subsystems[idx]->Start(context);
@@ -338,25 +931,86 @@ public:
         return;
     }   //StopSubSystems
 
+    /**
+     * This function returns the number of subsystems registered in a rate
+     * group.
+     *
+     * @param rateGroup Specifies the rate group.
+     *
+     * @return Returns the number of subsystems in the rate group.
+     */
+    int
+    GetNumSubSystems(
+        __in UINT32 rateGroup
+        )
+    {
+        int count = 0;
+
+        TLevel(API);
+        TEnterMsg(("group=%d", rateGroup));
+
+        for (int idx = 0; idx < m_numSubSystems; idx++)
+        {
+            if (SubSysRateGroup(m_subsysFlags[idx]) == rateGroup)
+            {
+                count++;
+            }
+        }
+
+        TExitMsg(("=%d", count));
+        return count;
+    }   //GetNumSubSystems
+
     /**
      * This function performs the input tasks of all the registered
-     * subsystems.
+     * subsystems in a rate group.
      *
      * @param context Specifies the caller context.
+     * @param rateGroup Specifies the rate group.
      */
     void
     SubSystemInputTasks(
-        __in UINT32 context
+        __in UINT32 context,
+        __in UINT32 rateGroup = RATEGROUP_OPERATOR
         )
     {
         TLevel(HIFREQ);
-        TEnterMsg(("context=%d", context));
+        TEnterMsg(("context=%d,group=%d", context, rateGroup));
 
-        for (int idx = 0; idx < m_numSubSystems; idx++)
+        if (m_schedMode == SUBSYSSCHED_DEADLINE)
         {
-            if (m_subsysFlags[idx] & SUBSYS_INPUT_TASKS)
+            PlanFrame(GetFPGATime(), rateGroup);
+            for (int i = 0; i < m_numFrameSubSystems; i++)
             {
-                m_subsystems[idx]->InputTasks(context);
+                int idx = m_frameOrder[i];
+                if (m_subsysFlags[idx] & SUBSYS_INPUT_TASKS)
+                {
+                    UINT32 timeStart = GetFPGATime();
+                    m_subsystems[idx]->InputTasks(context);
+                    UINT32 timeUsed = GetFPGATime() - timeStart;
+                    m_subsysExecTime[idx] += timeUsed;
+                    m_inputTasksHist[idx].Add(timeUsed);
+                }
+            }
+        }
+        else
+        {
+            for (int idx = 0; idx < m_numSubSystems; idx++)
+            {
+                if ((SubSysRateGroup(m_subsysFlags[idx]) == rateGroup) &&
+                    (m_subsysFlags[idx] & SUBSYS_INPUT_TASKS))
+                {
+                    if (m_fTimingEnabled)
+                    {
+                        UINT32 timeStart = GetFPGATime();
+                        m_subsystems[idx]->InputTasks(context);
+                        m_inputTasksHist[idx].Add(GetFPGATime() - timeStart);
+                    }
+                    else
+                    {
+                        m_subsystems[idx]->InputTasks(context);
+                    }
+                }
             }
         }
 
@@ -366,23 +1020,68 @@ public:
 
     /**
      * This function performs the action tasks of all the registered
-     * subsystems.
+     * subsystems in a rate group.
      *
      * @param context Specifies the caller context.
+     * @param rateGroup Specifies the rate group.
      */
     void
     SubSystemActionTasks(
-        __in UINT32 context
+        __in UINT32 context,
+        __in UINT32 rateGroup = RATEGROUP_OPERATOR
         )
     {
         TLevel(HIFREQ);
-        TEnterMsg(("context=%d", context));
+        TEnterMsg(("context=%d,group=%d", context, rateGroup));
 
-        for (int idx = m_numSubSystems - 1; idx >= 0; idx--)
+        if (m_schedMode == SUBSYSSCHED_DEADLINE)
         {
-            if (m_subsysFlags[idx] & SUBSYS_ACTION_TASKS)
+            //
+            // Run the action tasks of the subsystems planned by
+            // SubSystemInputTasks in reverse registration order, same as
+            // the fixed order mode, so the subsystem registered first
+            // still has the last say on shared outputs.
+            //
+            for (int idx = m_numSubSystems - 1; idx >= 0; idx--)
+            {
+                if (!m_fFramePlanned[idx])
+                {
+                    continue;
+                }
+                m_fFramePlanned[idx] = false;
+                UINT32 timeStart = GetFPGATime();
+                if (m_subsysFlags[idx] & SUBSYS_ACTION_TASKS)
+                {
+                    m_subsystems[idx]->ActionTasks(context);
+                }
+                UINT32 timeCurr = GetFPGATime();
+                if (m_subsysFlags[idx] & SUBSYS_ACTION_TASKS)
+                {
+                    m_actionTasksHist[idx].Add(timeCurr - timeStart);
+                }
+                m_subsysExecTime[idx] += timeCurr - timeStart;
+                CompleteSubSystem(idx, timeCurr);
+            }
+            m_numFrameSubSystems = 0;
+        }
+        else
+        {
+            for (int idx = m_numSubSystems - 1; idx >= 0; idx--)
             {
-                m_subsystems[idx]->ActionTasks(context);
+                if ((SubSysRateGroup(m_subsysFlags[idx]) == rateGroup) &&
+                    (m_subsysFlags[idx] & SUBSYS_ACTION_TASKS))
+                {
+                    if (m_fTimingEnabled)
+                    {
+                        UINT32 timeStart = GetFPGATime();
+                        m_subsystems[idx]->ActionTasks(context);
+                        m_actionTasksHist[idx].Add(GetFPGATime() - timeStart);
+                    }
+                    else
+                    {
+                        m_subsystems[idx]->ActionTasks(context);
+                    }
+                }
             }
         }
 
@@ -397,28 +1096,65 @@ SubSystemMgr* SubSystemMgr::m_instance = NULL;
  * This function registers a subsystem object.
  *
  * @param flags Specifies the subsystem callback types.
+ * @param period Specifies the subsystem period in msec used by the deadline
+ *        scheduler. Zero means every frame.
+ * @param priority Specifies the subsystem priority used by the deadline
+ *        scheduler.
+ * @param budget Specifies the worst case execution time in usec of the
+ *        subsystem input and action tasks combined. Zero means unknown.
  *
  * @return Returns true if the subsystem is successfully registered, false
  *         otherwise.
  */
 bool
 SubSystem::RegisterSubSystem(
-    __in UINT32 flags
+    __in UINT32 flags,
+    __in UINT32 period,
+    __in UINT32 priority,
+    __in UINT32 budget
     )
 {
     bool rc = false;
     SubSystemMgr *subsysMgr = SubSystemMgr::GetInstance();
 
     TLevel(API);
-    TEnterMsg(("flags=%x", flags));
+    TEnterMsg(("flags=%x,period=%d,priority=%d,budget=%d",
+               flags, period, priority, budget));
 
     if (subsysMgr != NULL)
     {
-        rc = subsysMgr->RegisterSubSystem(this, flags);
+        rc = subsysMgr->RegisterSubSystem(this, flags, period, priority,
+                                          budget);
     }
 
     TExitMsg(("=%x", rc));
     return rc;
 }   //RegisterSubSystem
 
+/**
+ * This function unregisters a subsystem object. A subsystem that is
+ * destroyed before the end of the program must call it from its destructor.
+ *
+ * @return Returns true if the subsystem was registered, false otherwise.
+ */
+bool
+SubSystem::UnregisterSubSystem(
+    void
+    )
+{
+    bool rc = false;
+    SubSystemMgr *subsysMgr = SubSystemMgr::GetInstance();
+
+    TLevel(API);
+    TEnter();
+
+    if (subsysMgr != NULL)
+    {
+        rc = subsysMgr->UnregisterSubSystem(this);
+    }
+
+    TExitMsg(("=%x", rc));
+    return rc;
+}   //UnregisterSubSystem
+
 #endif  //ifndef _SUBSYSTEM_H
@@ -36,18 +36,34 @@
     #define ACCEL_CAL_INTERVAL  0.01    //10ms
 #endif
 
+/**
+ * This structure holds the accelerometer state published by the sampler.
+ * All values are metric.
+ */
+typedef struct _AccelState
+{
+    ADXL345_I2C::AllAxes accel;
+    ADXL345_I2C::AllAxes vel;
+    ADXL345_I2C::AllAxes dist;
+} AccelState;
+
 /**
  * This class defines and implements the TrcAccel object. The TrcAccel object
  * inherits the ADXL345_I2C accelerometer object from the WPI library. This
- * object periodically sample the accelerometer value for the acceleration
+ * object is periodically sampled by the SensorSampler for the acceleration
  * value. It also integrates the acceleration value to calculate the velocity
- * and then integrates the velocity to calculate the distance value.
+ * and then integrates the velocity to calculate the distance value. The
+ * state is published through a TrcSnapshot so the getters never block
+ * behind the sampler. The sampler only queues an asynchronous I2C read, the
+ * integration is done when the read completes, so the sampler never waits
+ * on the I2C bus. The semaphore only serializes the integration with Reset
+ * and Calibrate.
  */
-class TrcAccel: public ADXL345_I2C
+class TrcAccel: public ADXL345_I2C,
+                public SampledSensor
 {
 private:
     SEM_ID      m_semaphore;
-    Notifier   *m_notifier;
     AllAxes     m_accelData;
     AllAxes     m_zeroOffset;
     AllAxes     m_deadBand;
@@ -59,12 +75,39 @@ private:
     double      m_zDist;
     bool        m_fEnabled;
     UINT32      m_timestamp;
-    
+    TrcSnapshot<AccelState> m_snapshot;
+    I2CRequest  m_request;
+
     /**
-     * This function is called periodically by the a timer callback to
-     * process the accelerometer data. It integrates the data with time
-     * to calculate the velocity, integrates it again to calculate
-     * distance.
+     * This function publishes the current state to the readers. It must be
+     * called with the semaphore held.
+     */
+    void
+    PublishState(
+        void
+        )
+    {
+        AccelState state;
+
+        TLevel(HIFREQ);
+        TEnter();
+
+        state.accel = m_accelData;
+        state.vel.XAxis = m_xVel;
+        state.vel.YAxis = m_yVel;
+        state.vel.ZAxis = m_zVel;
+        state.dist.XAxis = m_xDist;
+        state.dist.YAxis = m_yDist;
+        state.dist.ZAxis = m_zDist;
+        m_snapshot.Write(state);
+
+        TExit();
+    }   //PublishState
+
+    /**
+     * This function is called when an accelerometer read completes to
+     * process the accelerometer data. It integrates the data with time to
+     * calculate the velocity, integrates it again to calculate distance.
      */
     void
     Integrator(
@@ -76,12 +119,12 @@ private:
 
         CRITICAL_REGION(m_semaphore)
         {
-            if (m_fEnabled)
+            if (m_fEnabled && !m_request.IsAborted())
             {
-                UINT32 timeCurr = GetMsecTime();
-                float period = (float)(timeCurr - m_timestamp)/1000.0;
+                UINT32 timeCurr = m_request.GetTimestamp();
+                float period = (float)(timeCurr - m_timestamp)/1000000.0;
                 m_timestamp = timeCurr;
-                m_accelData = GetAccelerations();
+                m_accelData = GetAccelerations(&m_request);
                 m_accelData.XAxis -= m_zeroOffset.XAxis;
                 m_accelData.YAxis -= m_zeroOffset.YAxis;
                 m_accelData.ZAxis -= m_zeroOffset.ZAxis;
@@ -100,6 +143,7 @@ private:
                 m_xDist += m_xVel*period;
                 m_yDist += m_yVel*period;
                 m_zDist += m_zVel*period;
+                PublishState();
                 TSampling(("X(%f,%f,%f), Y(%f,%f,%f), Z(%f,%f,%f)",
                            m_accelData.XAxis*FEET_PER_METER,
                            m_xVel*FEET_PER_METER,
@@ -118,23 +162,47 @@ private:
     }   //Integrator
 
     /**
-     * This function is called when the timer expired. It will call the
-     * non-static worker function.
+     * This function is called by the I2C queue task when the read completes.
+     * It will call the non-static worker function.
      *
-     * @param timer Points to the TrcAccel object to call the worker function.
+     * @param request Points to the completed I2C request.
+     * @param accel Points to the TrcAccel object to call the worker function.
      */
     static
     void
     CallIntegrator(
-        __in void *accel
+        __in I2CRequest *request,
+        __in void       *accel
         )
     {
         TLevel(HIFREQ);
-        TEnterMsg(("accel=%p", accel));
+        TEnterMsg(("request=%p,accel=%p", request, accel));
         ((TrcAccel *)accel)->Integrator();
         TExit();
     }   //CallIntegrator
 
+    /**
+     * This function is called periodically by the SensorSampler. It queues
+     * a read of the accelerometer unless the previous one is still pending.
+     *
+     * @param timeCurr Specifies the FPGA time of the sampling pass in usec.
+     */
+    void
+    SampleSensor(
+        __in UINT32 timeCurr
+        )
+    {
+        TLevel(HIFREQ);
+        TEnterMsg(("timeCurr=%u", timeCurr));
+
+        if (m_fEnabled && !m_request.IsPending())
+        {
+            StartGetAccelerations(&m_request, TrcAccel::CallIntegrator, this);
+        }
+
+        TExit();
+    }   //SampleSensor
+
 public:
 
     /**
@@ -234,7 +302,7 @@ public:
 
     /**
      * Constructor: Create an instance of the TrcAccel object. It initializes
-     * the object and starts the periodic timer.
+     * the object and registers it with the SensorSampler.
      *
      * @param slot Specifies the slot of the digital module on which the I2C
      *        port is used for the accelerometer.
@@ -251,7 +319,6 @@ public:
         TEnterMsg(("slot=%d,period=%f", slot, period));
 
         m_semaphore = semBCreate(SEM_Q_PRIORITY, SEM_FULL);
-        m_notifier = new Notifier(TrcAccel::CallIntegrator, this);
         m_accelData.XAxis = 0.0;
         m_accelData.YAxis = 0.0;
         m_accelData.ZAxis = 0.0;
@@ -268,8 +335,9 @@ public:
         m_yDist = 0.0;
         m_zDist = 0.0;
         m_fEnabled = false;
+        m_timestamp = GetFPGATime();
         Calibrate(ACCEL_NUM_CAL_PTS, ACCEL_CAL_INTERVAL);
-        m_notifier->StartPeriodic(period);
+        SensorSampler::GetInstance()->RegisterSensor(this, period);
 
         TExit();
     }   //TrcAccel
@@ -284,8 +352,9 @@ public:
         TLevel(INIT);
         TEnter();
 
+        SensorSampler::GetInstance()->UnregisterSensor(this);
+        m_request.Wait();
         semFlush(m_semaphore);
-        SAFE_DELETE(m_notifier);
 
         TExit();
     }   //~TrcAccel
@@ -301,10 +370,12 @@ public:
         void
         )
     {
+        AccelState state;
         TLevel(HIFREQ);
         TEnter();
-        TExitMsg(("=%f", m_accelData.XAxis));
-        return m_accelData.XAxis;
+        m_snapshot.Read(state);
+        TExitMsg(("=%f", state.accel.XAxis));
+        return state.accel.XAxis;
     }   //GetMetricAccelX
 
     /**
@@ -318,9 +389,11 @@ public:
         void
         )
     {
+        AccelState state;
         TLevel(HIFREQ);
         TEnter();
-        double value = m_accelData.XAxis*FEET_PER_METER;
+        m_snapshot.Read(state);
+        double value = state.accel.XAxis*FEET_PER_METER;
         TExitMsg(("=%f", value));
         return value;
     }   //GetAccelX
@@ -336,10 +409,12 @@ public:
         void
         )
     {
+        AccelState state;
         TLevel(HIFREQ);
         TEnter();
-        TExitMsg(("=%f", m_accelData.YAxis));
-        return m_accelData.YAxis;
+        m_snapshot.Read(state);
+        TExitMsg(("=%f", state.accel.YAxis));
+        return state.accel.YAxis;
     }   //GetMetricAccelY
 
     /**
@@ -353,9 +428,11 @@ public:
         void
         )
     {
+        AccelState state;
         TLevel(HIFREQ);
         TEnter();
-        double value = m_accelData.YAxis*FEET_PER_METER;
+        m_snapshot.Read(state);
+        double value = state.accel.YAxis*FEET_PER_METER;
         TExitMsg(("=%f", value));
         return value;
     }   //GetAccelY
@@ -371,10 +448,12 @@ public:
         void
         )
     {
+        AccelState state;
         TLevel(HIFREQ);
         TEnter();
-        TExitMsg(("=%f", m_accelData.ZAxis));
-        return m_accelData.ZAxis;
+        m_snapshot.Read(state);
+        TExitMsg(("=%f", state.accel.ZAxis));
+        return state.accel.ZAxis;
     }   //GetMetricAccelZ
 
     /**
@@ -388,9 +467,11 @@ public:
         void
         )
     {
+        AccelState state;
         TLevel(HIFREQ);
         TEnter();
-        double value = m_accelData.ZAxis*FEET_PER_METER;
+        m_snapshot.Read(state);
+        double value = state.accel.ZAxis*FEET_PER_METER;
         TExitMsg(("=%f", value));
         return value;
     }   //GetAccelZ
@@ -406,10 +487,12 @@ public:
         void
         )
     {
+        AccelState state;
         TLevel(HIFREQ);
         TEnter();
-        TExitMsg(("=%f", m_xVel));
-        return m_xVel;
+        m_snapshot.Read(state);
+        TExitMsg(("=%f", state.vel.XAxis));
+        return state.vel.XAxis;
     }   //GetMetricVelX
 
     /**
@@ -423,9 +506,11 @@ public:
         void
         )
     {
+        AccelState state;
         TLevel(HIFREQ);
         TEnter();
-        double value = m_xVel*FEET_PER_METER;
+        m_snapshot.Read(state);
+        double value = state.vel.XAxis*FEET_PER_METER;
         TExitMsg(("=%f", value));
         return value;
     }   //GetVelX
@@ -441,10 +526,12 @@ public:
         void
         )
     {
+        AccelState state;
         TLevel(HIFREQ);
         TEnter();
-        TExitMsg(("=%f", m_yVel));
-        return m_yVel;
+        m_snapshot.Read(state);
+        TExitMsg(("=%f", state.vel.YAxis));
+        return state.vel.YAxis;
     }   //GetMetricVelY
 
     /**
@@ -458,9 +545,11 @@ public:
         void
         )
     {
+        AccelState state;
         TLevel(HIFREQ);
         TEnter();
-        double value = m_yVel*FEET_PER_METER;
+        m_snapshot.Read(state);
+        double value = state.vel.YAxis*FEET_PER_METER;
         TExitMsg(("=%f", value));
         return value;
     }   //GetVelY
@@ -476,10 +565,12 @@ public:
         void
         )
     {
+        AccelState state;
         TLevel(HIFREQ);
         TEnter();
-        TExitMsg(("=%f", m_zVel));
-        return m_zVel;
+        m_snapshot.Read(state);
+        TExitMsg(("=%f", state.vel.ZAxis));
+        return state.vel.ZAxis;
     }   //GetMetricVelZ
 
     /**
@@ -493,9 +584,11 @@ public:
         void
         )
     {
+        AccelState state;
         TLevel(HIFREQ);
         TEnter();
-        double value = m_zVel*FEET_PER_METER;
+        m_snapshot.Read(state);
+        double value = state.vel.ZAxis*FEET_PER_METER;
         TExitMsg(("=%f", value));
         return value;
     }   //GetVelZ
@@ -511,10 +604,12 @@ public:
         void
         )
     {
+        AccelState state;
         TLevel(HIFREQ);
         TEnter();
-        TExitMsg(("=%f", m_xDist));
-        return m_xDist;
+        m_snapshot.Read(state);
+        TExitMsg(("=%f", state.dist.XAxis));
+        return state.dist.XAxis;
     }   //GetMetricDistX
 
     /**
@@ -528,9 +623,11 @@ public:
         void
         )
     {
+        AccelState state;
         TLevel(HIFREQ);
         TEnter();
-        double value = m_xDist*FEET_PER_METER;
+        m_snapshot.Read(state);
+        double value = state.dist.XAxis*FEET_PER_METER;
         TExitMsg(("=%f", value));
         return value;
     }   //GetDistX
@@ -546,10 +643,12 @@ public:
         void
         )
     {
+        AccelState state;
         TLevel(HIFREQ);
         TEnter();
-        TExitMsg(("=%f", m_yDist));
-        return m_yDist;
+        m_snapshot.Read(state);
+        TExitMsg(("=%f", state.dist.YAxis));
+        return state.dist.YAxis;
     }   //GetMetricDistY
 
     /**
@@ -563,9 +662,11 @@ public:
         void
         )
     {
+        AccelState state;
         TLevel(HIFREQ);
         TEnter();
-        double value = m_yDist*FEET_PER_METER;
+        m_snapshot.Read(state);
+        double value = state.dist.YAxis*FEET_PER_METER;
         TExitMsg(("=%f", value));
         return value;
     }   //GetDistY
@@ -581,10 +682,12 @@ public:
         void
         )
     {
+        AccelState state;
         TLevel(HIFREQ);
         TEnter();
-        TExitMsg(("=%f", m_zDist));
-        return m_zDist;
+        m_snapshot.Read(state);
+        TExitMsg(("=%f", state.dist.ZAxis));
+        return state.dist.ZAxis;
     }   //GetMetricDistZ
 
     /**
@@ -598,9 +701,11 @@ public:
         void
         )
     {
+        AccelState state;
         TLevel(HIFREQ);
         TEnter();
-        double value = m_zDist*FEET_PER_METER;
+        m_snapshot.Read(state);
+        double value = state.dist.ZAxis*FEET_PER_METER;
         TExitMsg(("=%f", value));
         return value;
     }   //GetDistZ
@@ -627,6 +732,7 @@ public:
             m_xDist = 0.0;
             m_yDist = 0.0;
             m_zDist = 0.0;
+            PublishState();
         }
         END_REGION;
 
@@ -646,12 +752,12 @@ public:
         TLevel(API);
         TEnter();
 
-        m_fEnabled = fEnabled;
         if (fEnabled)
         {
             Reset();
-            m_timestamp = GetMsecTime();
+            m_timestamp = GetFPGATime();
         }
+        m_fEnabled = fEnabled;
 
         TExit();
     }   //SetEnabled
@@ -29,70 +29,73 @@
 #define PIDMODE_VELOCITY        1
 #define PIDMODE_ACCELERATION    2
 
+/**
+ * This structure holds the gyro state published by the sampler.
+ */
+typedef struct _GyroState
+{
+    float angle;
+    float angularVelocity;
+    float angularAcceleration;
+} GyroState;
+
 /**
  * This class defines and implements the TrcGyro object. This object inherits
  * the Gyro object from the WPI library. It added the support of providing
  * angular velocity as well as angular acceleration information which is
- * missing from the Gyro class in the WPI library.
+ * missing from the Gyro class in the WPI library. The gyro is periodically
+ * sampled by the SensorSampler which is the only writer of the state. The
+ * state is published through a TrcSnapshot so the getters never block
+ * behind the sampler.
  */
-class TrcGyro: public Gyro
+class TrcGyro: public Gyro,
+               public SampledSensor
 {
 private:
     float       m_period;
-    SEM_ID      m_semaphore;
-    Notifier   *m_notifier;
-    float       m_angle;
-    float       m_angularVelocity;
-    float       m_angularAcceleration;
-    UINT32      m_modePID;
+    UINT32      m_timestamp;
+    GyroState   m_state;
+    TrcSnapshot<GyroState> m_snapshot;
+    volatile UINT32 m_modePID;
 
     /**
-     * This function is called periodically by the a timer callback to process
+     * This function is called periodically by the SensorSampler to process
      * the gyro data. It differentiate the angle with time to calculate the
      * angular velocity, differentiates it again to calculate angular
      * acceleration.
+     *
+     * @param timeCurr Specifies the FPGA time of the sample in usec.
      */
     void
-    Differentiator(
-        void
+    SampleSensor(
+        __in UINT32 timeCurr
         )
     {
         TLevel(HIFREQ);
-        TEnter();
-
-        CRITICAL_REGION(m_semaphore)
+        TEnterMsg(("timeCurr=%u", timeCurr));
+
+        float period = (float)(timeCurr - m_timestamp)/1000000.0;
+        float prevAngle = m_state.angle;
+        float prevVelocity = m_state.angularVelocity;
+        //
+        // Must call the base class because our own GetAngle returns the
+        // published angle.
+        //
+        m_state.angle = Gyro::GetAngle();
+        m_timestamp = timeCurr;
+        if (period > 0.0)
         {
-            float prevAngle = m_angle;
-            float prevVelocity = m_angularVelocity;
-            m_angle = GetAngle();
-            m_angularVelocity = (m_angle - prevAngle)/m_period;
-            m_angularAcceleration = (m_angularVelocity - prevVelocity)/
-                                    m_period;
-            TSampling(("angle=%f,anglevel=%f,angleaccel=%f",
-                       m_angle, m_angularVelocity, m_angularAcceleration));
+            m_state.angularVelocity = (m_state.angle - prevAngle)/period;
+            m_state.angularAcceleration =
+                (m_state.angularVelocity - prevVelocity)/period;
         }
-        END_REGION;
+        m_snapshot.Write(m_state);
+        TSampling(("angle=%f,anglevel=%f,angleaccel=%f",
+                   m_state.angle, m_state.angularVelocity,
+                   m_state.angularAcceleration));
 
         TExit();
-    }   //Differentiator
-
-    /**
-     * This function is called when the timer expired. It will call the
-     * non-static worker function.
-     *
-     * @param timer Points to the TrcGyro object to call the worker function.
-     */
-    static
-    void
-    CallDifferentiator(
-        __in void *gyro
-        )
-    {
-        TLevel(HIFREQ);
-        TEnterMsg(("gyro=%p", gyro));
-        ((TrcGyro *)gyro)->Differentiator();
-        TExit();
-    }   //CallDifferentiator
+    }   //SampleSensor
 
     /**
      * This function does the common initialization of the TrcGyro object.
@@ -105,13 +108,13 @@ private:
         TLevel(INIT);
         TEnter();
 
-        m_semaphore = semBCreate(SEM_Q_PRIORITY, SEM_FULL);
-        m_notifier = new Notifier(TrcGyro::CallDifferentiator, this);
-        m_angle = GetAngle();
-        m_angularVelocity = 0.0;
-        m_angularAcceleration = 0.0;
+        m_timestamp = GetFPGATime();
+        m_state.angle = Gyro::GetAngle();
+        m_state.angularVelocity = 0.0;
+        m_state.angularAcceleration = 0.0;
+        m_snapshot.Write(m_state);
         m_modePID = PIDMODE_ANGLE;
-        m_notifier->StartPeriodic(m_period);
+        SensorSampler::GetInstance()->RegisterSensor(this, m_period);
 
         TExit();
     }   //GyroInit
@@ -119,7 +122,7 @@ private:
 public:
     /**
      * Constructor: Create an instance of the TrcGyro object. It initializes
-     * the object and starts the periodic timer.
+     * the object and registers it with the SensorSampler.
      *
      * @param slot Specifies the slot of the analog module.
      * @param channel Specifies the analog channel.
@@ -142,7 +145,7 @@ public:
 
     /**
      * Constructor: Create an instance of the TrcGyro object. It initializes
-     * the object and starts the periodic timer.
+     * the object and registers it with the SensorSampler.
      *
      * @param channel Specifies the analog channel.
      * @param period Specifies the sampling time for doing calculations. This
@@ -171,8 +174,7 @@ public:
         TLevel(INIT);
         TEnter();
 
-        semFlush(m_semaphore);
-        SAFE_DELETE(m_notifier);
+        SensorSampler::GetInstance()->UnregisterSensor(this);
 
         TExit();
     }   //~TrcGyro
@@ -185,18 +187,14 @@ public:
         void
         )
     {
-        float value;
+        GyroState state;
         TLevel(API);
         TEnter();
 
-        CRITICAL_REGION(m_semaphore)
-        {
-            value = m_angle;
-        }
-        END_REGION;
+        m_snapshot.Read(state);
 
-        TExitMsg(("=%f", value));
-        return value;
+        TExitMsg(("=%f", state.angle));
+        return state.angle;
     }   //GetAngle
 
     /**
@@ -207,18 +205,14 @@ public:
         void
         )
     {
-        float value;
+        GyroState state;
         TLevel(API);
         TEnter();
 
-        CRITICAL_REGION(m_semaphore)
-        {
-            value = m_angularVelocity;
-        }
-        END_REGION;
+        m_snapshot.Read(state);
 
-        TExitMsg(("=%f", value));
-        return value;
+        TExitMsg(("=%f", state.angularVelocity));
+        return state.angularVelocity;
     }   //GetAngularVelocity
 
     /**
@@ -230,18 +224,14 @@ public:
         void
         )
     {
-        float value;
+        GyroState state;
         TLevel(API);
         TEnter();
 
-        CRITICAL_REGION(m_semaphore)
-        {
-            value = m_angularAcceleration;
-        }
-        END_REGION;
+        m_snapshot.Read(state);
 
-        TExitMsg(("=%f", value));
-        return value;
+        TExitMsg(("=%f", state.angularAcceleration));
+        return state.angularAcceleration;
     }   //GetAngularAcceleration
 
     /**
@@ -256,11 +246,7 @@ public:
         TLevel(API);
         TEnterMsg(("mode=%d", mode));
 
-        CRITICAL_REGION(m_semaphore)
-        {
-            m_modePID = mode;
-        }
-        END_REGION;
+        m_modePID = mode;
 
         TExit();
     }   //SetPIDMode
@@ -275,27 +261,25 @@ public:
         )
     {
         double value = 0.0;
+        GyroState state;
         TLevel(HIFREQ);
         TEnter();
 
-        CRITICAL_REGION(m_semaphore)
+        m_snapshot.Read(state);
+        switch (m_modePID)
         {
-            switch (m_modePID)
-            {
-            case PIDMODE_ANGLE:
-                value = m_angle;
-                break;
-
-            case PIDMODE_VELOCITY:
-                value = m_angularVelocity;
-                break;
-
-            case PIDMODE_ACCELERATION:
-                value = m_angularAcceleration;
-                break;
-            }
+        case PIDMODE_ANGLE:
+            value = state.angle;
+            break;
+
+        case PIDMODE_VELOCITY:
+            value = state.angularVelocity;
+            break;
+
+        case PIDMODE_ACCELERATION:
+            value = state.angularAcceleration;
+            break;
         }
-        END_REGION;
 
         TExitMsg(("=%f", value));
         return value;
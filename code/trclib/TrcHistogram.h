@@ -0,0 +1,350 @@
+#if 0
+/// Copyright (c) Titan Robotics Club. All rights reserved.
+///
+/// <module name="TrcHistogram.h" />
+///
+/// <summary>
+///     This module contains the definition and implementation of the
+///     TrcHistogram class.
+/// </summary>
+///
+/// <remarks>
+///     Environment: Wind River C++ for National Instrument cRIO based Robot.
+/// </remarks>
+#endif
+
+#ifndef _TRCHISTOGRAM_H
+#define _TRCHISTOGRAM_H
+
+#ifdef MOD_ID
+    #undef MOD_ID
+#endif
+#define MOD_ID                  MOD_HISTOGRAM
+#ifdef MOD_NAME
+    #undef MOD_NAME
+#endif
+#define MOD_NAME                "TrcHistogram"
+
+//
+// Each power of 2 is split into 4 sub-buckets, so the bucket resolution is
+// within 25% of the value. Values below 4 get a bucket of their own.
+//
+#define HIST_SUB_BUCKET_BITS    2
+#define HIST_SUB_BUCKETS        (1 << HIST_SUB_BUCKET_BITS)
+#define HIST_NUM_BUCKETS        ((32 - HIST_SUB_BUCKET_BITS + 1)*HIST_SUB_BUCKETS)
+
+/**
+ * This class defines and implements the TrcHistogram object. It records
+ * timing samples (typically in usec) into fixed log-linear buckets so that
+ * percentiles can be calculated without storing the samples. Samples are
+ * added by a single writer (e.g. the robot loop) without any locking. Other
+ * tasks may read the statistics at any time; a reader may see a sample that
+ * is only partially accounted for, which is acceptable for statistics. To
+ * keep the writer lock-free, a reader requests a reset and the writer
+ * performs it on the next sample.
+ */
+class TrcHistogram
+{
+private:
+    UINT32          m_buckets[HIST_NUM_BUCKETS];
+    UINT32          m_count;
+    UINT32          m_min;
+    UINT32          m_max;
+    double          m_total;
+    volatile bool   m_fResetRequested;
+
+    /**
+     * This function determines the bucket index of a value.
+     *
+     * @param value Specifies the value.
+     *
+     * @return Returns the bucket index.
+     */
+    static
+    UINT32
+    BucketIndex(
+        __in UINT32 value
+        )
+    {
+        UINT32 idx;
+
+        if (value < HIST_SUB_BUCKETS)
+        {
+            idx = value;
+        }
+        else
+        {
+            UINT32 msb = 31 - __builtin_clz(value);
+            idx = (msb - HIST_SUB_BUCKET_BITS + 1)*HIST_SUB_BUCKETS +
+                  ((value >> (msb - HIST_SUB_BUCKET_BITS)) &
+                   (HIST_SUB_BUCKETS - 1));
+        }
+
+        return idx;
+    }   //BucketIndex
+
+    /**
+     * This function determines the largest value that falls in a bucket.
+     *
+     * @param idx Specifies the bucket index.
+     *
+     * @return Returns the upper bound of the bucket.
+     */
+    static
+    UINT32
+    BucketUpperBound(
+        __in UINT32 idx
+        )
+    {
+        UINT32 value;
+
+        if (idx < HIST_SUB_BUCKETS)
+        {
+            value = idx;
+        }
+        else
+        {
+            UINT32 shift = idx/HIST_SUB_BUCKETS - 1;
+            UINT32 lower = (HIST_SUB_BUCKETS + idx%HIST_SUB_BUCKETS) << shift;
+            value = lower + ((1 << shift) - 1);
+        }
+
+        return value;
+    }   //BucketUpperBound
+
+    /**
+     * This function clears all the statistics.
+     */
+    void
+    Clear(
+        void
+        )
+    {
+        for (int i = 0; i < HIST_NUM_BUCKETS; i++)
+        {
+            m_buckets[i] = 0;
+        }
+        m_count = 0;
+        m_min = 0xffffffff;
+        m_max = 0;
+        m_total = 0.0;
+        m_fResetRequested = false;
+    }   //Clear
+
+public:
+    /**
+     * Constructor: Create an instance of the TrcHistogram object.
+     */
+    TrcHistogram(
+        void
+        )
+    {
+        TLevel(INIT);
+        TEnter();
+        Clear();
+        TExit();
+    }   //TrcHistogram
+
+    /**
+     * Destructor: Destroy an instance of the TrcHistogram object.
+     */
+    ~TrcHistogram(
+        void
+        )
+    {
+        TLevel(INIT);
+        TEnter();
+        TExit();
+    }   //~TrcHistogram
+
+    /**
+     * This function requests the statistics to be cleared. The statistics
+     * are cleared by the writer when the next sample is added.
+     */
+    void
+    Reset(
+        void
+        )
+    {
+        TLevel(API);
+        TEnter();
+        m_fResetRequested = true;
+        TExit();
+    }   //Reset
+
+    /**
+     * This function adds a sample to the histogram. It must only be called
+     * by one task.
+     *
+     * @param value Specifies the sample value.
+     */
+    void
+    Add(
+        __in UINT32 value
+        )
+    {
+        TLevel(HIFREQ);
+        TEnterMsg(("value=%d", value));
+
+        if (m_fResetRequested)
+        {
+            Clear();
+        }
+
+        m_buckets[BucketIndex(value)]++;
+        m_total += value;
+        if (value < m_min)
+        {
+            m_min = value;
+        }
+
+        if (value > m_max)
+        {
+            m_max = value;
+        }
+        m_count++;
+
+        TExit();
+    }   //Add
+
+    /**
+     * This function gets the number of samples.
+     *
+     * @return Returns the number of samples.
+     */
+    UINT32
+    GetCount(
+        void
+        )
+    {
+        TLevel(API);
+        TEnter();
+        TExitMsg(("=%d", m_count));
+        return m_count;
+    }   //GetCount
+
+    /**
+     * This function gets the minimum sample value.
+     *
+     * @return Returns the minimum sample value, zero if there is no sample.
+     */
+    UINT32
+    GetMin(
+        void
+        )
+    {
+        TLevel(API);
+        TEnter();
+        UINT32 value = (m_count > 0)? m_min: 0;
+        TExitMsg(("=%d", value));
+        return value;
+    }   //GetMin
+
+    /**
+     * This function gets the maximum sample value.
+     *
+     * @return Returns the maximum sample value.
+     */
+    UINT32
+    GetMax(
+        void
+        )
+    {
+        TLevel(API);
+        TEnter();
+        TExitMsg(("=%d", m_max));
+        return m_max;
+    }   //GetMax
+
+    /**
+     * This function gets the mean of the sample values.
+     *
+     * @return Returns the mean value.
+     */
+    UINT32
+    GetMean(
+        void
+        )
+    {
+        TLevel(API);
+        TEnter();
+        UINT32 count = m_count;
+        UINT32 value = (count > 0)? (UINT32)(m_total/count): 0;
+        TExitMsg(("=%d", value));
+        return value;
+    }   //GetMean
+
+    /**
+     * This function gets the given percentile of the sample values. The
+     * returned value is the upper bound of the bucket containing the
+     * percentile, limited to the maximum sample value.
+     *
+     * @param percent Specifies the percentile (0-100).
+     *
+     * @return Returns the percentile value.
+     */
+    UINT32
+    GetPercentile(
+        __in UINT32 percent
+        )
+    {
+        UINT32 value = 0;
+
+        TLevel(API);
+        TEnterMsg(("percent=%d", percent));
+
+        UINT32 count = m_count;
+        if (count > 0)
+        {
+            UINT32 target = (count*percent + 99)/100;
+            UINT32 cumulative = 0;
+
+            if (target == 0)
+            {
+                target = 1;
+            }
+
+            for (UINT32 i = 0; i < HIST_NUM_BUCKETS; i++)
+            {
+                cumulative += m_buckets[i];
+                if (cumulative >= target)
+                {
+                    value = BucketUpperBound(i);
+                    break;
+                }
+            }
+
+            if (value > m_max)
+            {
+                value = m_max;
+            }
+        }
+
+        TExitMsg(("=%d", value));
+        return value;
+    }   //GetPercentile
+
+    /**
+     * This function prints a one line summary of the statistics to the
+     * console.
+     *
+     * @param name Specifies the name of the histogram.
+     */
+    void
+    Dump(
+        __in const char *name
+        )
+    {
+        TLevel(API);
+        TEnterMsg(("name=%s", name));
+
+        printf("%-16s n=%-8d min=%-6d mean=%-6d p50=%-6d p95=%-6d p99=%-6d max=%d\n",
+               name, GetCount(), GetMin(), GetMean(),
+               GetPercentile(50), GetPercentile(95), GetPercentile(99),
+               GetMax());
+
+        TExit();
+    }   //Dump
+};  //class TrcHistogram
+
+#endif  //ifndef _TRCHISTOGRAM_H
@@ -110,6 +110,8 @@ public:
  * inherits the Joystick object from the WPI library. It added the support
  * of detecting joystick button events and calling the notification object.
  * It also added the deadband support for reading the analog joystick axes.
+ * The axes and buttons are read from the DriverStation joystick snapshot,
+ * which is converted once per packet.
  */
 class TrcJoystick: public Joystick
 {
@@ -118,6 +120,41 @@ private:
     ButtonNotify   *m_notify;
     DriverStation  *m_ds;
     UINT16          m_prevBtn;
+    UINT32          m_prevSequence;
+
+    /**
+     * This function gets an axis value from the joystick state with
+     * deadband.
+     *
+     * @param state Specifies the joystick state of the latest snapshot.
+     * @param axis Specifies the axis type.
+     * @param threshold Specifies the deadband threshold.
+     */
+    float
+    GetAxisWithDeadband(
+        __in const DriverStation::StickState &state,
+        __in AxisType                         axis,
+        __in float                            threshold
+        )
+    {
+        float value = 0.0;
+        UINT32 channel = GetAxisChannel(axis);
+
+        TLevel(FUNC);
+        TEnterMsg(("axis=%d,threshold=%f", axis, threshold));
+
+        if ((channel >= 1) && (channel <= DriverStation::kJoystickAxes))
+        {
+            value = DEADBAND(state.axes[channel - 1], threshold);
+        }
+        else
+        {
+            TErr(("Invalid axis channel %d.", channel));
+        }
+
+        TExitMsg(("=%f", value));
+        return value;
+    }   //GetAxisWithDeadband
 
 public:
     /**
@@ -138,7 +175,8 @@ public:
         TEnterMsg(("Joystick=%d,notify=%p", port, notify));
 
         m_ds = DriverStation::GetInstance();
-        m_prevBtn = m_ds->GetStickButtons(port);
+        m_prevSequence = m_ds->GetJoystickSnapshot().sequence;
+        m_prevBtn = m_ds->GetStickState(port).buttons;
 
         TExit();
     }   //TrcJoystick
@@ -173,7 +211,8 @@ public:
         TLevel(HIFREQ);
         TEnterMsg(("threshold=%f,hand=%d", threshold, hand));
 
-        value = DEADBAND(GetX(hand), threshold);
+        value = GetAxisWithDeadband(m_ds->GetStickState(m_port), kXAxis,
+                                    threshold);
 
         TExitMsg(("=%f", value));
         return value;
@@ -197,7 +236,8 @@ public:
         TLevel(HIFREQ);
         TEnterMsg(("threshold=%f,hand=%d", threshold, hand));
 
-        value = DEADBAND(GetY(hand), threshold);
+        value = GetAxisWithDeadband(m_ds->GetStickState(m_port), kYAxis,
+                                    threshold);
 
         TExitMsg(("=%f", value));
         return value;
@@ -218,7 +258,8 @@ public:
         TLevel(HIFREQ);
         TEnterMsg(("threshold=%f", threshold));
 
-        value = DEADBAND(GetZ(), threshold);
+        value = GetAxisWithDeadband(m_ds->GetStickState(m_port), kZAxis,
+                                    threshold);
 
         TExitMsg(("=%f", value));
         return value;
@@ -239,7 +280,8 @@ public:
         TLevel(API);
         TEnterMsg(("threshold=%f", threshold));
 
-        value = DEADBAND(GetTwist(), threshold);
+        value = GetAxisWithDeadband(m_ds->GetStickState(m_port), kTwistAxis,
+                                    threshold);
 
         TExitMsg(("=%f", value));
         return value;
@@ -261,8 +303,9 @@ public:
         TLevel(API);
         TEnterMsg(("threshold=%f", threshold));
 
-        value = MAGNITUDE(GetXWithDeadband(threshold),
-                          GetYWithDeadband(threshold));
+        const DriverStation::StickState &state = m_ds->GetStickState(m_port);
+        value = MAGNITUDE(GetAxisWithDeadband(state, kXAxis, threshold),
+                          GetAxisWithDeadband(state, kYAxis, threshold));
 
         TExitMsg(("=%f", value));
         return value;
@@ -284,8 +327,9 @@ public:
         TLevel(API);
         TEnterMsg(("threshold=%f", threshold));
 
-        value = DIR_RADIANS(GetXWithDeadband(threshold),
-                            -GetYWithDeadband(threshold));
+        const DriverStation::StickState &state = m_ds->GetStickState(m_port);
+        value = DIR_RADIANS(GetAxisWithDeadband(state, kXAxis, threshold),
+                            -GetAxisWithDeadband(state, kYAxis, threshold));
 
         TExitMsg(("=%f", value));
         return value;
@@ -315,7 +359,9 @@ public:
 
     /**
      * This function is called periodically by the robot loop to check and
-     * process joystick button events.
+     * process joystick button events. Nothing is done until a new packet
+     * has arrived. If no packet was missed, the button edges computed by
+     * the DriverStation are used.
      */
     void
     ButtonTask(
@@ -325,38 +371,49 @@ public:
         TLevel(HIFREQ);
         TEnter();
 
-        UINT16 currBtn = m_ds->GetStickButtons(m_port);
-        if (m_notify != NULL)
+        const DriverStation::JoystickSnapshot &snapshot =
+            m_ds->GetJoystickSnapshot();
+        if ((snapshot.sequence != m_prevSequence) &&
+            (m_port >= 1) && (m_port <= DriverStation::kJoystickPorts))
         {
-            UINT16 changedBtn = m_prevBtn^currBtn;
-            UINT16 btnMask;
-            while (changedBtn != 0)
+            const DriverStation::StickState &state =
+                snapshot.sticks[m_port - 1];
+            UINT16 currBtn = state.buttons;
+            if (m_notify != NULL)
             {
-                //
-                // maskButton contains the least significant set bit.
-                //
-                btnMask = changedBtn & ~(changedBtn^-changedBtn);
-                if ((currBtn & btnMask) != 0)
+                UINT16 changedBtn =
+                    (snapshot.sequence == m_prevSequence + 1)?
+                        state.pressed | state.released: m_prevBtn^currBtn;
+                UINT16 btnMask;
+                while (changedBtn != 0)
                 {
                     //
-                    // Button is pressed.
+                    // maskButton contains the least significant set bit.
                     //
-                    m_notify->NotifyButton(m_port, btnMask, true);
-                }
-                else
-                {
+                    btnMask = changedBtn & ~(changedBtn^-changedBtn);
+                    if ((currBtn & btnMask) != 0)
+                    {
+                        //
+                        // Button is pressed.
+                        //
+                        m_notify->NotifyButton(m_port, btnMask, true);
+                    }
+                    else
+                    {
+                        //
+                        // Button is released.
+                        //
+                        m_notify->NotifyButton(m_port, btnMask, false);
+                    }
                     //
-                    // Button is released.
+                    // Clear the least significant set bit.
                     //
-                    m_notify->NotifyButton(m_port, btnMask, false);
+                    changedBtn &= ~btnMask;
                 }
-                //
-                // Clear the least significant set bit.
-                //
-                changedBtn &= ~btnMask;
             }
+            m_prevBtn = currBtn;
+            m_prevSequence = snapshot.sequence;
         }
-        m_prevBtn = currBtn;
 
         TExit();
     }   //ButtonTask
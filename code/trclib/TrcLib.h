@@ -17,6 +17,8 @@
 #define _TRCLIB_H
 
 #include <math.h>
+#include <stdarg.h>
+#include <dirent.h>
 #include "../trclib/common.h"
 #include "../trclib/DbgTrace.h"
 #include "../trclib/Event.h"
@@ -25,13 +27,20 @@
 #include "../trclib/TrcJoystick.h"
 #include "../trclib/DigitalIn.h"
 #include "../trclib/AnalogIn.h"
+#include "../trclib/TrcHistogram.h"
+#include "../trclib/TrcSensorSampler.h"
 #include "../trclib/TrcAccel.h"
-//#include "../trclib/TrcGyro.h"
+#include "../trclib/TrcGyro.h"
 #include "../trclib/TrcPIDCtrl.h"
+#include "../trclib/TrcPIDBank.h"
+#include "../trclib/TrcMotionProfile.h"
 #include "../trclib/TrcPIDMotor.h"
 #include "../trclib/TrcPIDDrive.h"
+#include "../trclib/TrcOdometry.h"
 #include "../trclib/LineFollower.h"
 #include "../trclib/SubSystem.h"
+#include "../trclib/TrcStateMachine.h"
+#include "../trclib/FlightRecorder.h"
 #include "../trclib/CoopMTRobot.h"
 
 #endif  //#ifndef _TRCLIB_H
@@ -0,0 +1,449 @@
+#if 0
+/// Copyright (c) Titan Robotics Club. All rights reserved.
+///
+/// <module name="TrcMotionProfile.h" />
+///
+/// <summary>
+///     This module contains the definition and implementation of the
+///     TrcMotionProfile class.
+/// </summary>
+///
+/// <remarks>
+///     Environment: Wind River C++ for National Instrument cRIO based Robot.
+/// </remarks>
+#endif
+
+#ifndef _TRCMOTIONPROFILE_H
+#define _TRCMOTIONPROFILE_H
+
+#ifdef MOD_ID
+    #undef MOD_ID
+#endif
+#define MOD_ID                  MOD_MOTIONPROFILE
+#ifdef MOD_NAME
+    #undef MOD_NAME
+#endif
+#define MOD_NAME                "TrcMotionProfile"
+
+//
+// A jerk limited profile has 7 segments: jerk up, constant acceleration,
+// jerk down, cruise, jerk down, constant deceleration and jerk up. A
+// trapezoidal profile is the same with zero length jerk segments.
+//
+#define MOTIONPROFILE_NUM_SEGS  7
+
+/**
+ * This class defines and implements the TrcMotionProfile object. It
+ * generates a time parameterized rest-to-rest trajectory over a given
+ * distance that respects the maximum velocity, acceleration and optionally
+ * jerk. Without a jerk limit the profile is trapezoidal, otherwise it is an
+ * S-curve. If the distance is too short to reach the maximum velocity (or
+ * acceleration), the peak is lowered accordingly. The segment boundaries
+ * are calculated once in Start, so evaluating the profile every loop is
+ * constant time.
+ */
+class TrcMotionProfile
+{
+private:
+    float     m_maxVel;
+    float     m_maxAccel;
+    float     m_maxJerk;
+    float     m_sign;
+    UINT32    m_startTime;
+    float     m_segStart[MOTIONPROFILE_NUM_SEGS + 1];
+    float     m_segJerk[MOTIONPROFILE_NUM_SEGS];
+    float     m_segPos[MOTIONPROFILE_NUM_SEGS + 1];
+    float     m_segVel[MOTIONPROFILE_NUM_SEGS + 1];
+    float     m_segAccel[MOTIONPROFILE_NUM_SEGS + 1];
+
+    /**
+     * This function calculates the peak velocity, the duration of each
+     * jerk segment and of the constant acceleration segment for a given
+     * distance.
+     *
+     * @param distance Specifies the distance (positive).
+     * @param peakVel Receives the peak velocity.
+     * @param jerkTime Receives the duration of each jerk segment.
+     * @param accelTime Receives the duration of the constant acceleration
+     *        segment.
+     */
+    void
+    CalcPeak(
+        __in  float  distance,
+        __out float &peakVel,
+        __out float &jerkTime,
+        __out float &accelTime
+        )
+    {
+        float rampTime;
+
+        TLevel(FUNC);
+        TEnterMsg(("distance=%f", distance));
+
+        peakVel = m_maxVel;
+        CalcRamp(peakVel, jerkTime, accelTime);
+        rampTime = 2.0*jerkTime + accelTime;
+        if (peakVel*rampTime > distance)
+        {
+            //
+            // Cannot reach the maximum velocity. The ramp distance is
+            // peakVel*rampTime/2 for both ramps, solve for peakVel.
+            //
+            if ((m_maxJerk > 0.0) &&
+                (distance < 2.0*m_maxAccel*m_maxAccel*m_maxAccel/
+                            (m_maxJerk*m_maxJerk)))
+            {
+                //
+                // No constant acceleration segment:
+                // distance = 2*peakVel*sqrt(peakVel/maxJerk).
+                //
+                peakVel = pow(distance*distance*m_maxJerk/4.0, 1.0/3.0);
+            }
+            else
+            {
+                //
+                // distance = peakVel*(peakVel/maxAccel + maxAccel/maxJerk).
+                //
+                float b = (m_maxJerk > 0.0)? m_maxAccel/m_maxJerk: 0.0;
+                peakVel = m_maxAccel*(sqrt(b*b + 4.0*distance/m_maxAccel) -
+                                      b)/2.0;
+            }
+            CalcRamp(peakVel, jerkTime, accelTime);
+        }
+
+        TExitMsg(("peakVel=%f,jerkTime=%f,accelTime=%f",
+                  peakVel, jerkTime, accelTime));
+        return;
+    }   //CalcPeak
+
+    /**
+     * This function calculates the segment durations of a ramp from rest to
+     * the given velocity.
+     *
+     * @param velocity Specifies the velocity to reach.
+     * @param jerkTime Receives the duration of each jerk segment.
+     * @param accelTime Receives the duration of the constant acceleration
+     *        segment.
+     */
+    void
+    CalcRamp(
+        __in  float  velocity,
+        __out float &jerkTime,
+        __out float &accelTime
+        )
+    {
+        TLevel(FUNC);
+        TEnterMsg(("velocity=%f", velocity));
+
+        if (m_maxJerk <= 0.0)
+        {
+            jerkTime = 0.0;
+            accelTime = velocity/m_maxAccel;
+        }
+        else if (velocity < m_maxAccel*m_maxAccel/m_maxJerk)
+        {
+            //
+            // Maximum acceleration is not reached.
+            //
+            jerkTime = sqrt(velocity/m_maxJerk);
+            accelTime = 0.0;
+        }
+        else
+        {
+            jerkTime = m_maxAccel/m_maxJerk;
+            accelTime = velocity/m_maxAccel - jerkTime;
+        }
+
+        TExitMsg(("jerkTime=%f,accelTime=%f", jerkTime, accelTime));
+        return;
+    }   //CalcRamp
+
+public:
+    /**
+     * Constructor: Create an instance of the TrcMotionProfile object.
+     *
+     * @param maxVel Specifies the maximum velocity in units per second.
+     * @param maxAccel Specifies the maximum acceleration in units per
+     *        second squared.
+     * @param maxJerk Specifies the maximum jerk in units per second cubed.
+     *        Zero means no jerk limit (trapezoidal profile).
+     */
+    TrcMotionProfile(
+        __in float maxVel,
+        __in float maxAccel,
+        __in float maxJerk = 0.0
+        ): m_maxVel(maxVel),
+           m_maxAccel(maxAccel),
+           m_maxJerk(maxJerk),
+           m_sign(1.0),
+           m_startTime(0)
+    {
+        TLevel(INIT);
+        TEnterMsg(("maxVel=%f,maxAccel=%f,maxJerk=%f",
+                   maxVel, maxAccel, maxJerk));
+
+        for (int i = 0; i <= MOTIONPROFILE_NUM_SEGS; i++)
+        {
+            m_segStart[i] = 0.0;
+            m_segPos[i] = 0.0;
+            m_segVel[i] = 0.0;
+            m_segAccel[i] = 0.0;
+        }
+
+        for (int i = 0; i < MOTIONPROFILE_NUM_SEGS; i++)
+        {
+            m_segJerk[i] = 0.0;
+        }
+
+        TExit();
+    }   //TrcMotionProfile
+
+    /**
+     * Destructor: Destroy an instance of the TrcMotionProfile object.
+     */
+    ~TrcMotionProfile(
+        void
+        )
+    {
+        TLevel(INIT);
+        TEnter();
+        TExit();
+    }   //~TrcMotionProfile
+
+    /**
+     * This function sets the profile limits. It applies to the next Start.
+     *
+     * @param maxVel Specifies the maximum velocity in units per second.
+     * @param maxAccel Specifies the maximum acceleration in units per
+     *        second squared.
+     * @param maxJerk Specifies the maximum jerk in units per second cubed.
+     *        Zero means no jerk limit (trapezoidal profile).
+     */
+    void
+    SetLimits(
+        __in float maxVel,
+        __in float maxAccel,
+        __in float maxJerk = 0.0
+        )
+    {
+        TLevel(API);
+        TEnterMsg(("maxVel=%f,maxAccel=%f,maxJerk=%f",
+                   maxVel, maxAccel, maxJerk));
+
+        m_maxVel = maxVel;
+        m_maxAccel = maxAccel;
+        m_maxJerk = maxJerk;
+
+        TExit();
+        return;
+    }   //SetLimits
+
+    /**
+     * This function calculates the profile for the given distance and
+     * starts the profile clock.
+     *
+     * @param distance Specifies the distance to travel, can be negative.
+     */
+    void
+    Start(
+        __in float distance
+        )
+    {
+        float peakVel, jerkTime, accelTime, cruiseTime;
+        float segTime[MOTIONPROFILE_NUM_SEGS];
+        float jerk;
+
+        TLevel(API);
+        TEnterMsg(("distance=%f", distance));
+
+        m_sign = (distance < 0.0)? -1.0: 1.0;
+        distance = fabs(distance);
+
+        CalcPeak(distance, peakVel, jerkTime, accelTime);
+        cruiseTime = (peakVel > 0.0)?
+                     (distance - peakVel*(2.0*jerkTime + accelTime))/peakVel:
+                     0.0;
+        if (cruiseTime < 0.0)
+        {
+            cruiseTime = 0.0;
+        }
+        jerk = (jerkTime > 0.0)? m_maxJerk: 0.0;
+
+        segTime[0] = jerkTime;
+        segTime[1] = accelTime;
+        segTime[2] = jerkTime;
+        segTime[3] = cruiseTime;
+        segTime[4] = jerkTime;
+        segTime[5] = accelTime;
+        segTime[6] = jerkTime;
+        m_segJerk[0] = jerk;
+        m_segJerk[1] = 0.0;
+        m_segJerk[2] = -jerk;
+        m_segJerk[3] = 0.0;
+        m_segJerk[4] = -jerk;
+        m_segJerk[5] = 0.0;
+        m_segJerk[6] = jerk;
+
+        //
+        // Without a jerk limit, the acceleration steps at the start of the
+        // constant acceleration segments.
+        //
+        m_segStart[0] = 0.0;
+        m_segPos[0] = 0.0;
+        m_segVel[0] = 0.0;
+        m_segAccel[0] = 0.0;
+        for (int i = 0; i < MOTIONPROFILE_NUM_SEGS; i++)
+        {
+            float t = segTime[i];
+            float a0 = m_segAccel[i];
+
+            if (jerk == 0.0)
+            {
+                a0 = (i == 1)? m_maxAccel: (i == 5)? -m_maxAccel: 0.0;
+                if (t == 0.0)
+                {
+                    a0 = 0.0;
+                }
+            }
+
+            m_segStart[i + 1] = m_segStart[i] + t;
+            m_segPos[i + 1] = m_segPos[i] + m_segVel[i]*t + a0*t*t/2.0 +
+                              m_segJerk[i]*t*t*t/6.0;
+            m_segVel[i + 1] = m_segVel[i] + a0*t + m_segJerk[i]*t*t/2.0;
+            m_segAccel[i + 1] = a0 + m_segJerk[i]*t;
+            m_segAccel[i] = a0;
+        }
+        //
+        // Make sure the profile ends exactly at the target.
+        //
+        m_segPos[MOTIONPROFILE_NUM_SEGS] = distance;
+        m_segVel[MOTIONPROFILE_NUM_SEGS] = 0.0;
+        m_segAccel[MOTIONPROFILE_NUM_SEGS] = 0.0;
+        m_startTime = GetFPGATime();
+
+        TExitMsg(("duration=%f,peakVel=%f",
+                  m_segStart[MOTIONPROFILE_NUM_SEGS], peakVel));
+        return;
+    }   //Start
+
+    /**
+     * This function gets the total duration of the profile.
+     *
+     * @return Returns the duration in seconds.
+     */
+    float
+    GetDuration(
+        void
+        )
+    {
+        TLevel(API);
+        TEnter();
+        TExitMsg(("=%f", m_segStart[MOTIONPROFILE_NUM_SEGS]));
+        return m_segStart[MOTIONPROFILE_NUM_SEGS];
+    }   //GetDuration
+
+    /**
+     * This function gets the maximum acceleration of the profile.
+     *
+     * @return Returns the maximum acceleration in units per second squared.
+     */
+    float
+    GetMaxAccel(
+        void
+        )
+    {
+        TLevel(API);
+        TEnter();
+        TExitMsg(("=%f", m_maxAccel));
+        return m_maxAccel;
+    }   //GetMaxAccel
+
+    /**
+     * This function gets the profile state at the given time.
+     *
+     * @param time Specifies the time in seconds since the start.
+     * @param pos Receives the position relative to the start.
+     * @param vel Receives the velocity.
+     * @param accel Receives the acceleration.
+     *
+     * @return Returns true if the profile is done at the given time.
+     */
+    bool
+    GetState(
+        __in  float  time,
+        __out float &pos,
+        __out float &vel,
+        __out float &accel
+        )
+    {
+        bool fDone = false;
+
+        TLevel(HIFREQ);
+        TEnterMsg(("time=%f", time));
+
+        if (time >= m_segStart[MOTIONPROFILE_NUM_SEGS])
+        {
+            pos = m_segPos[MOTIONPROFILE_NUM_SEGS];
+            vel = 0.0;
+            accel = 0.0;
+            fDone = true;
+        }
+        else
+        {
+            int seg = 0;
+            float t;
+
+            if (time < 0.0)
+            {
+                time = 0.0;
+            }
+
+            while (time >= m_segStart[seg + 1])
+            {
+                seg++;
+            }
+
+            t = time - m_segStart[seg];
+            pos = m_segPos[seg] + m_segVel[seg]*t + m_segAccel[seg]*t*t/2.0 +
+                  m_segJerk[seg]*t*t*t/6.0;
+            vel = m_segVel[seg] + m_segAccel[seg]*t +
+                  m_segJerk[seg]*t*t/2.0;
+            accel = m_segAccel[seg] + m_segJerk[seg]*t;
+        }
+
+        pos *= m_sign;
+        vel *= m_sign;
+        accel *= m_sign;
+
+        TExitMsg(("=%d,pos=%f,vel=%f,accel=%f", fDone, pos, vel, accel));
+        return fDone;
+    }   //GetState
+
+    /**
+     * This function gets the current profile state since Start.
+     *
+     * @param pos Receives the position relative to the start.
+     * @param vel Receives the velocity.
+     * @param accel Receives the acceleration.
+     *
+     * @return Returns true if the profile is done.
+     */
+    bool
+    GetSetPoint(
+        __out float &pos,
+        __out float &vel,
+        __out float &accel
+        )
+    {
+        TLevel(HIFREQ);
+        TEnter();
+
+        bool fDone = GetState((float)(GetFPGATime() - m_startTime)/1000000.0,
+                              pos, vel, accel);
+
+        TExitMsg(("=%d", fDone));
+        return fDone;
+    }   //GetSetPoint
+};  //class TrcMotionProfile
+
+#endif  //ifndef _TRCMOTIONPROFILE_H
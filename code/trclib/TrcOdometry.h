@@ -0,0 +1,511 @@
+#if 0
+/// Copyright (c) Titan Robotics Club. All rights reserved.
+///
+/// <module name="TrcOdometry.h" />
+///
+/// <summary>
+///     This module contains the definition and implementation of the
+///     TrcOdometry class.
+/// </summary>
+///
+/// <remarks>
+///     Environment: Wind River C++ for National Instrument cRIO based Robot.
+/// </remarks>
+#endif
+
+#ifndef _TRCODOMETRY_H
+#define _TRCODOMETRY_H
+
+#ifdef MOD_ID
+    #undef MOD_ID
+#endif
+#define MOD_ID                  MOD_ODOMETRY
+#ifdef MOD_NAME
+    #undef MOD_NAME
+#endif
+#define MOD_NAME                "TrcOdometry"
+
+//
+// Odometry options.
+//
+// ODOMETRYO_TRACKING_WHEELS: The two encoders are X (strafe) and Y (forward)
+//      tracking wheels instead of the left and right drive wheels. The
+//      tracking wheels cannot measure turning, so a gyro is required.
+//
+#define ODOMETRYO_TRACKING_WHEELS   0x00000001
+
+//
+// Pose axes that can be used as PID input.
+//
+#define ODOMETRY_AXIS_X         0
+#define ODOMETRY_AXIS_Y         1
+#define ODOMETRY_AXIS_HEADING   2
+#define ODOMETRY_AXIS_DISTANCE  3
+
+#define ODOMETRY_MAX_PIDCTRLS   4
+
+#ifndef ODOMETRY_PERIOD
+    #define ODOMETRY_PERIOD     0.01    //10ms
+#endif
+
+/**
+ * This structure holds the pose published by the update.
+ */
+typedef struct _OdometryPose
+{
+    float x;
+    float y;
+    float heading;
+    float distance;
+} OdometryPose;
+
+/**
+ * This class defines and implements the TrcOdometry object. It estimates
+ * the field relative pose (x, y and heading) of the robot at a fixed rate
+ * by fusing the drive or tracking wheel encoders, the gyro and the
+ * accelerometer. The heading comes from the gyro, or from the difference
+ * of the left and right wheels if there is no gyro. The robot relative
+ * motion comes from the encoders, blended with the accelerometer through a
+ * complementary filter on the velocity: the accelerometer follows quick
+ * changes such as wheel slip, the encoders correct its drift. The motion is
+ * then rotated into the field frame with the heading at the middle of the
+ * period. The field frame has Y forward and X to the right of the starting
+ * pose, heading is in degrees clockwise. All sensors are optional except
+ * the encoders and distances are in the units of the encoders, which must
+ * be feet to blend with the accelerometer. It is also a PIDInput, so it can
+ * be the input of TrcPIDDrive. The pose is updated by the SensorSampler
+ * and published through a TrcSnapshot so the getters never block behind
+ * the update.
+ */
+class TrcOdometry: public PIDInput,
+                   public SampledSensor
+{
+private:
+    SEM_ID      m_semaphore;
+    Encoder    *m_encoder1;
+    Encoder    *m_encoder2;
+    Gyro       *m_gyro;
+    TrcAccel   *m_accel;
+    UINT32      m_options;
+    float       m_trackWidth;
+    float       m_accelTimeConst;
+    UINT32      m_timestamp;
+    double      m_prevEnc1;
+    double      m_prevEnc2;
+    float       m_prevGyro;
+    //
+    // Pose.
+    //
+    double      m_x;
+    double      m_y;
+    double      m_heading;
+    double      m_distance;
+    double      m_xVel;
+    double      m_yVel;
+    TrcSnapshot<OdometryPose> m_snapshot;
+    //
+    // PID input bindings.
+    //
+    int         m_numPIDCtrls;
+    TrcPIDCtrl *m_pidCtrls[ODOMETRY_MAX_PIDCTRLS];
+    UINT32      m_pidAxes[ODOMETRY_MAX_PIDCTRLS];
+
+    /**
+     * This function publishes the current pose to the readers. It must be
+     * called with the semaphore held.
+     */
+    void
+    PublishPose(
+        void
+        )
+    {
+        OdometryPose pose;
+
+        TLevel(HIFREQ);
+        TEnter();
+
+        pose.x = m_x;
+        pose.y = m_y;
+        pose.heading = m_heading;
+        pose.distance = m_distance;
+        m_snapshot.Write(pose);
+
+        TExit();
+    }   //PublishPose
+
+    /**
+     * This function is called periodically by the SensorSampler to update
+     * the pose.
+     *
+     * @param timeCurr Specifies the FPGA time of the sample in usec.
+     */
+    void
+    SampleSensor(
+        __in UINT32 timeCurr
+        )
+    {
+        TLevel(HIFREQ);
+        TEnterMsg(("timeCurr=%u", timeCurr));
+
+        CRITICAL_REGION(m_semaphore)
+        {
+            //
+            // Reset may have moved the timestamp past the start of the
+            // sampling pass.
+            //
+            INT32 elapsed = (INT32)(timeCurr - m_timestamp);
+            double period = (elapsed > 0)? (double)elapsed/1000000.0: 0.0;
+            double enc1 = m_encoder1->GetDistance();
+            double enc2 = m_encoder2->GetDistance();
+            double delta1 = enc1 - m_prevEnc1;
+            double delta2 = enc2 - m_prevEnc2;
+            double dxRobot, dyRobot, dHeading;
+
+            m_timestamp = timeCurr;
+            m_prevEnc1 = enc1;
+            m_prevEnc2 = enc2;
+
+            if (m_options & ODOMETRYO_TRACKING_WHEELS)
+            {
+                dxRobot = delta1;
+                dyRobot = delta2;
+                dHeading = 0.0;
+            }
+            else
+            {
+                dxRobot = 0.0;
+                dyRobot = (delta1 + delta2)/2.0;
+                dHeading = (m_trackWidth > 0.0)?
+                           RADIANS_TO_DEGREES((delta1 - delta2)/m_trackWidth):
+                           0.0;
+            }
+
+            if (m_gyro != NULL)
+            {
+                float gyroAngle = m_gyro->GetAngle();
+                dHeading = gyroAngle - m_prevGyro;
+                m_prevGyro = gyroAngle;
+            }
+
+            if ((m_accel != NULL) && (m_accelTimeConst > 0.0) &&
+                (period > 0.0))
+            {
+                //
+                // Complementary filter: integrate the acceleration for the
+                // short term and pull towards the encoder velocity for the
+                // long term.
+                //
+                double alpha = m_accelTimeConst/(m_accelTimeConst + period);
+                m_xVel = alpha*(m_xVel + m_accel->GetAccelX()*period) +
+                         (1.0 - alpha)*dxRobot/period;
+                m_yVel = alpha*(m_yVel + m_accel->GetAccelY()*period) +
+                         (1.0 - alpha)*dyRobot/period;
+                dxRobot = m_xVel*period;
+                dyRobot = m_yVel*period;
+            }
+
+            double heading = (m_heading + dHeading/2.0)*PI/180.0;
+            double cosHeading = cos(heading);
+            double sinHeading = sin(heading);
+            m_x += dxRobot*cosHeading + dyRobot*sinHeading;
+            m_y += -dxRobot*sinHeading + dyRobot*cosHeading;
+            m_heading += dHeading;
+            m_distance += dyRobot;
+            PublishPose();
+
+            TSampling(("x=%f,y=%f,heading=%f,dist=%f",
+                       m_x, m_y, m_heading, m_distance));
+        }
+        END_REGION;
+
+        TExit();
+    }   //SampleSensor
+
+public:
+    /**
+     * Constructor: Create an instance of the TrcOdometry object and register
+     * it with the SensorSampler for the periodic update.
+     *
+     * @param encoder1 Points to the left drive wheel encoder, or the X
+     *        tracking wheel encoder with ODOMETRYO_TRACKING_WHEELS.
+     * @param encoder2 Points to the right drive wheel encoder, or the Y
+     *        tracking wheel encoder with ODOMETRYO_TRACKING_WHEELS.
+     * @param gyro Points to the gyro, can be NULL unless
+     *        ODOMETRYO_TRACKING_WHEELS is specified.
+     * @param accel Points to the accelerometer, can be NULL.
+     * @param options Specifies the option flags.
+     * @param period Specifies the update period in seconds.
+     */
+    TrcOdometry(
+        __in Encoder  *encoder1,
+        __in Encoder  *encoder2,
+        __in Gyro     *gyro = NULL,
+        __in TrcAccel *accel = NULL,
+        __in UINT32    options = 0,
+        __in float     period = ODOMETRY_PERIOD
+        ): m_encoder1(encoder1),
+           m_encoder2(encoder2),
+           m_gyro(gyro),
+           m_accel(accel),
+           m_options(options),
+           m_trackWidth(0.0),
+           m_accelTimeConst(0.0),
+           m_numPIDCtrls(0)
+    {
+        TLevel(INIT);
+        TEnterMsg(("enc1=%p,enc2=%p,gyro=%p,accel=%p,options=%x,period=%f",
+                   encoder1, encoder2, gyro, accel, options, period));
+
+        m_semaphore = semBCreate(SEM_Q_PRIORITY, SEM_FULL);
+        Reset();
+        if ((options & ODOMETRYO_TRACKING_WHEELS) && (gyro == NULL))
+        {
+            //
+            // Without a gyro the heading would never change and the pose
+            // would silently go wrong after the first turn.
+            //
+            TErr(("Tracking wheels require a gyro, odometry disabled."));
+        }
+        else
+        {
+            SensorSampler::GetInstance()->RegisterSensor(this, period);
+        }
+
+        TExit();
+    }   //TrcOdometry
+
+    /**
+     * Destructor: Destroy an instance of the TrcOdometry object.
+     */
+    ~TrcOdometry(
+        void
+        )
+    {
+        TLevel(INIT);
+        TEnter();
+
+        SensorSampler::GetInstance()->UnregisterSensor(this);
+        semDelete(m_semaphore);
+
+        TExit();
+    }   //~TrcOdometry
+
+    /**
+     * This function sets the distance between the left and right drive
+     * wheels. It is used to calculate the heading when there is no gyro.
+     *
+     * @param trackWidth Specifies the track width in encoder units.
+     */
+    void
+    SetTrackWidth(
+        __in float trackWidth
+        )
+    {
+        TLevel(API);
+        TEnterMsg(("trackWidth=%f", trackWidth));
+        m_trackWidth = trackWidth;
+        TExit();
+    }   //SetTrackWidth
+
+    /**
+     * This function sets how much the accelerometer is trusted relative to
+     * the encoders. The time constant is roughly how long the integrated
+     * acceleration is followed before the encoders take over.
+     *
+     * @param timeConst Specifies the time constant in seconds. Zero means
+     *        encoders only.
+     */
+    void
+    SetAccelTimeConst(
+        __in float timeConst
+        )
+    {
+        TLevel(API);
+        TEnterMsg(("timeConst=%f", timeConst));
+        m_accelTimeConst = timeConst;
+        TExit();
+    }   //SetAccelTimeConst
+
+    /**
+     * This function resets the pose to the given values.
+     *
+     * @param x Specifies the X position.
+     * @param y Specifies the Y position.
+     * @param heading Specifies the heading in degrees.
+     */
+    void
+    Reset(
+        __in float x = 0.0,
+        __in float y = 0.0,
+        __in float heading = 0.0
+        )
+    {
+        TLevel(API);
+        TEnterMsg(("x=%f,y=%f,heading=%f", x, y, heading));
+
+        CRITICAL_REGION(m_semaphore)
+        {
+            m_timestamp = GetFPGATime();
+            m_prevEnc1 = m_encoder1->GetDistance();
+            m_prevEnc2 = m_encoder2->GetDistance();
+            m_prevGyro = (m_gyro != NULL)? m_gyro->GetAngle(): 0.0;
+            m_x = x;
+            m_y = y;
+            m_heading = heading;
+            m_distance = 0.0;
+            m_xVel = 0.0;
+            m_yVel = 0.0;
+            PublishPose();
+        }
+        END_REGION;
+
+        TExit();
+    }   //Reset
+
+    /**
+     * This function gets the current pose.
+     *
+     * @param x Receives the X position.
+     * @param y Receives the Y position.
+     * @param heading Receives the heading in degrees.
+     */
+    void
+    GetPose(
+        __out float &x,
+        __out float &y,
+        __out float &heading
+        )
+    {
+        OdometryPose pose;
+
+        TLevel(API);
+        TEnter();
+
+        m_snapshot.Read(pose);
+        x = pose.x;
+        y = pose.y;
+        heading = pose.heading;
+
+        TExitMsg(("x=%f,y=%f,heading=%f", x, y, heading));
+    }   //GetPose
+
+    /**
+     * This function gets one axis of the pose.
+     *
+     * @param axis Specifies the axis (ODOMETRY_AXIS_*).
+     *
+     * @return Returns the value of the axis. The distance axis is the
+     *         distance travelled forward since the last reset.
+     */
+    float
+    GetAxis(
+        __in UINT32 axis
+        )
+    {
+        float value = 0.0;
+        OdometryPose pose;
+
+        TLevel(API);
+        TEnterMsg(("axis=%d", axis));
+
+        m_snapshot.Read(pose);
+        switch (axis)
+        {
+        case ODOMETRY_AXIS_X:
+            value = pose.x;
+            break;
+
+        case ODOMETRY_AXIS_Y:
+            value = pose.y;
+            break;
+
+        case ODOMETRY_AXIS_HEADING:
+            value = pose.heading;
+            break;
+
+        case ODOMETRY_AXIS_DISTANCE:
+            value = pose.distance;
+            break;
+        }
+
+        TExitMsg(("=%f", value));
+        return value;
+    }   //GetAxis
+
+    /**
+     * This function binds a PID controller to a pose axis, so GetInput
+     * returns that axis for the controller. For TrcPIDDrive, bind the drive
+     * controller to ODOMETRY_AXIS_DISTANCE and the turn controller to
+     * ODOMETRY_AXIS_HEADING.
+     *
+     * @param pidCtrl Points to the PID controller.
+     * @param axis Specifies the axis (ODOMETRY_AXIS_*).
+     *
+     * @return Returns true if successful, false if there are too many
+     *         controllers.
+     */
+    bool
+    SetPIDInput(
+        __in TrcPIDCtrl *pidCtrl,
+        __in UINT32      axis
+        )
+    {
+        bool fSuccess = false;
+
+        TLevel(API);
+        TEnterMsg(("pidCtrl=%p,axis=%d", pidCtrl, axis));
+
+        for (int i = 0; i < m_numPIDCtrls; i++)
+        {
+            if (m_pidCtrls[i] == pidCtrl)
+            {
+                m_pidAxes[i] = axis;
+                fSuccess = true;
+                break;
+            }
+        }
+
+        if (!fSuccess && (m_numPIDCtrls < ODOMETRY_MAX_PIDCTRLS))
+        {
+            m_pidCtrls[m_numPIDCtrls] = pidCtrl;
+            m_pidAxes[m_numPIDCtrls] = axis;
+            m_numPIDCtrls++;
+            fSuccess = true;
+        }
+
+        TExitMsg(("=%d", fSuccess));
+        return fSuccess;
+    }   //SetPIDInput
+
+    /**
+     * This function is called by the PID controllers to get the input.
+     *
+     * @param pidCtrl Points to the PID controller that requires input.
+     *
+     * @return Returns the pose axis bound to the controller.
+     */
+    float
+    GetInput(
+        __in TrcPIDCtrl *pidCtrl
+        )
+    {
+        float input = 0.0;
+
+        TLevel(CALLBK);
+        TEnterMsg(("pidCtrl=%p", pidCtrl));
+
+        for (int i = 0; i < m_numPIDCtrls; i++)
+        {
+            if (m_pidCtrls[i] == pidCtrl)
+            {
+                input = GetAxis(m_pidAxes[i]);
+                break;
+            }
+        }
+
+        TExitMsg(("=%f", input));
+        return input;
+    }   //GetInput
+};  //class TrcOdometry
+
+#endif  //ifndef _TRCODOMETRY_H
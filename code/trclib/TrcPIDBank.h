@@ -0,0 +1,573 @@
+#if 0
+/// Copyright (c) Titan Robotics Club. All rights reserved.
+///
+/// <module name="TrcPIDBank.h" />
+///
+/// <summary>
+///     This module contains the definition and implementation of the
+///     TrcPIDBank class.
+/// </summary>
+///
+/// <remarks>
+///     Environment: Wind River C++ for National Instrument cRIO based Robot.
+/// </remarks>
+#endif
+
+#ifndef _TRCPIDBANK_H
+#define _TRCPIDBANK_H
+
+#ifdef MOD_ID
+    #undef MOD_ID
+#endif
+#define MOD_ID                  MOD_PIDBANK
+#ifdef MOD_NAME
+    #undef MOD_NAME
+#endif
+#define MOD_NAME                "TrcPIDBank"
+
+//
+// Constants.
+//
+#define PIDBANK_MAX_CTRLS       16
+#define PIDBANK_INVALID_CTRL    -1
+
+/**
+ * This class defines and implements the TrcPIDBank object. It is a bank of
+ * PID controllers that behave like TrcPIDCtrl in its default fixed step
+ * mode (same input and output ranges, anti-windup and settling logic, and
+ * the PIDCTRLO_INVERSE and PIDCTRLO_ABS_SETPT options) but keeps the state
+ * of all the controllers in parallel arrays. All the outputs are calculated
+ * in one pass over the arrays from an array of inputs, so there are no
+ * per-controller objects and no virtual PIDInput callbacks; the step of
+ * each controller is a small helper without trace calls that the compiler
+ * inlines. A controller is identified by the index returned by
+ * AddController. The time aware mode (PIDCTRLO_TIME_AWARE) is not
+ * supported.
+ */
+class TrcPIDBank
+{
+private:
+    int       m_numCtrls;
+    //
+    // Parameters.
+    //
+    float     m_Kp[PIDBANK_MAX_CTRLS];
+    float     m_Ki[PIDBANK_MAX_CTRLS];
+    float     m_Kd[PIDBANK_MAX_CTRLS];
+    float     m_sign[PIDBANK_MAX_CTRLS];
+    float     m_tolerance[PIDBANK_MAX_CTRLS];
+    UINT32    m_settlingTime[PIDBANK_MAX_CTRLS];
+    UINT32    m_pidCtrlOptions[PIDBANK_MAX_CTRLS];
+    float     m_minInput[PIDBANK_MAX_CTRLS];
+    float     m_maxInput[PIDBANK_MAX_CTRLS];
+    float     m_minOutput[PIDBANK_MAX_CTRLS];
+    float     m_maxOutput[PIDBANK_MAX_CTRLS];
+    //
+    // State.
+    //
+    float     m_setPoint[PIDBANK_MAX_CTRLS];
+    float     m_prevError[PIDBANK_MAX_CTRLS];
+    double    m_totalError[PIDBANK_MAX_CTRLS];
+    float     m_output[PIDBANK_MAX_CTRLS];
+    UINT32    m_startSettling[PIDBANK_MAX_CTRLS];
+
+    /**
+     * This function calculates the output of one controller. It is shared
+     * by the single controller and the whole bank calculations.
+     *
+     * @param idx Specifies the controller index.
+     * @param currInput Specifies the current input value.
+     */
+    void
+    CalcOutput(
+        __in int   idx,
+        __in float currInput
+        )
+    {
+        float error = m_sign[idx]*(m_setPoint[idx] - currInput);
+        double totalError = m_totalError[idx] + error;
+        float adjTotalError = m_Ki[idx]*totalError;
+
+        if ((adjTotalError > m_minOutput[idx]) &&
+            (adjTotalError < m_maxOutput[idx]))
+        {
+            m_totalError[idx] = totalError;
+        }
+
+        float output = m_Kp[idx]*error +
+                       m_Ki[idx]*m_totalError[idx] +
+                       m_Kd[idx]*(error - m_prevError[idx]);
+        m_prevError[idx] = error;
+        m_output[idx] = BOUND(output, m_minOutput[idx], m_maxOutput[idx]);
+    }   //CalcOutput
+
+public:
+    /**
+     * Constructor: Create an instance of the TrcPIDBank object.
+     */
+    TrcPIDBank(
+        void
+        ): m_numCtrls(0)
+    {
+        TLevel(INIT);
+        TEnter();
+        TExit();
+    }   //TrcPIDBank
+
+    /**
+     * Destructor: Destroy an instance of the TrcPIDBank object.
+     */
+    ~TrcPIDBank(
+        void
+        )
+    {
+        TLevel(INIT);
+        TEnter();
+        TExit();
+    }   //~TrcPIDBank
+
+    /**
+     * This function adds a PID controller to the bank.
+     *
+     * @param Kp Specifies the proportional coefficient.
+     * @param Ki Specifies the integral coefficient.
+     * @param Kd Specifies the derivative coefficient.
+     * @param tolerance Specifies the on-target tolerance.
+     * @param settlingTime Specifes the on-target settling time in msec.
+     * @param pidCtrlOptions Specifies the option flags (PIDCTRLO_*).
+     *
+     * @return Returns the controller index, PIDBANK_INVALID_CTRL if the
+     *         bank is full or the options include PIDCTRLO_TIME_AWARE.
+     */
+    int
+    AddController(
+        __in float  Kp,
+        __in float  Ki,
+        __in float  Kd,
+        __in float  tolerance = 0.0,
+        __in UINT32 settlingTime = 0,
+        __in UINT32 pidCtrlOptions = 0
+        )
+    {
+        int idx = PIDBANK_INVALID_CTRL;
+
+        TLevel(API);
+        TEnterMsg(("Kp=%f,Ki=%f,Kd=%f,tolerance=%f,settlingTime=%d,options=%x",
+                   Kp, Ki, Kd, tolerance, settlingTime, pidCtrlOptions));
+
+        if (pidCtrlOptions & PIDCTRLO_TIME_AWARE)
+        {
+            TErr(("Time aware mode is not supported by PID bank."));
+        }
+        else if (m_numCtrls < PIDBANK_MAX_CTRLS)
+        {
+            idx = m_numCtrls;
+            m_numCtrls++;
+
+            m_Kp[idx] = Kp;
+            m_Ki[idx] = Ki;
+            m_Kd[idx] = Kd;
+            m_sign[idx] = (pidCtrlOptions & PIDCTRLO_INVERSE)? -1.0: 1.0;
+            m_tolerance[idx] = tolerance;
+            m_settlingTime[idx] = settlingTime;
+            m_pidCtrlOptions[idx] = pidCtrlOptions;
+            m_minInput[idx] = 0.0;
+            m_maxInput[idx] = 0.0;
+            m_minOutput[idx] = -1.0;
+            m_maxOutput[idx] = 1.0;
+
+            m_setPoint[idx] = 0.0;
+            m_prevError[idx] = 0.0;
+            m_totalError[idx] = 0.0;
+            m_output[idx] = 0.0;
+            m_startSettling[idx] = 0;
+        }
+        else
+        {
+            TErr(("PID bank is full."));
+        }
+
+        TExitMsg(("=%d", idx));
+        return idx;
+    }   //AddController
+
+    /**
+     * This function gets the number of controllers in the bank.
+     *
+     * @return Returns the number of controllers.
+     */
+    int
+    GetNumControllers(
+        void
+        )
+    {
+        TLevel(API);
+        TEnter();
+        TExitMsg(("=%d", m_numCtrls));
+        return m_numCtrls;
+    }   //GetNumControllers
+
+    /**
+     * This function resets a PID controller.
+     *
+     * @param idx Specifies the controller index.
+     */
+    void
+    Reset(
+        __in int idx
+        )
+    {
+        TLevel(API);
+        TEnterMsg(("idx=%d", idx));
+
+        if ((idx >= 0) && (idx < m_numCtrls))
+        {
+            m_prevError[idx] = 0.0;
+            m_totalError[idx] = 0.0;
+            m_output[idx] = 0.0;
+        }
+        else
+        {
+            TErr(("Invalid controller index %d.", idx));
+        }
+
+        TExit();
+        return;
+    }   //Reset
+
+    /**
+     * This function sets the PID controller constants.
+     *
+     * @param idx Specifies the controller index.
+     * @param Kp Specifies the proportional constant.
+     * @param Ki Specifies the integral constant.
+     * @param Kd Specifies the differential constant.
+     */
+    void
+    SetPID(
+        __in int   idx,
+        __in float Kp,
+        __in float Ki,
+        __in float Kd
+        )
+    {
+        TLevel(API);
+        TEnterMsg(("idx=%d,Kp=%f,Ki=%f,Kd=%f", idx, Kp, Ki, Kd));
+
+        if ((idx >= 0) && (idx < m_numCtrls))
+        {
+            m_Kp[idx] = Kp;
+            m_Ki[idx] = Ki;
+            m_Kd[idx] = Kd;
+        }
+        else
+        {
+            TErr(("Invalid controller index %d.", idx));
+        }
+
+        TExit();
+        return;
+    }   //SetPID
+
+    /**
+     * This function sets the minimum and maximum values expected from the
+     * input.
+     *
+     * @param idx Specifies the controller index.
+     * @param minInput Specifies the minimum value.
+     * @param maxInput Specifies the maximum value.
+     */
+    void
+    SetInputRange(
+        __in int   idx,
+        __in float minInput,
+        __in float maxInput
+        )
+    {
+        TLevel(API);
+        TEnterMsg(("idx=%d,min=%f,max=%f", idx, minInput, maxInput));
+
+        if ((idx >= 0) && (idx < m_numCtrls))
+        {
+            m_minInput[idx] = minInput;
+            m_maxInput[idx] = maxInput;
+        }
+        else
+        {
+            TErr(("Invalid controller index %d.", idx));
+        }
+
+        TExit();
+        return;
+    }   //SetInputRange
+
+    /**
+     * This function limits the minimum and maximum values of the output.
+     *
+     * @param idx Specifies the controller index.
+     * @param minOutput Specifies the minimum value.
+     * @param maxOutput Specifies the maximum value.
+     */
+    void
+    SetOutputRange(
+        __in int   idx,
+        __in float minOutput,
+        __in float maxOutput
+        )
+    {
+        TLevel(API);
+        TEnterMsg(("idx=%d,min=%f,max=%f", idx, minOutput, maxOutput));
+
+        if ((idx >= 0) && (idx < m_numCtrls))
+        {
+            m_minOutput[idx] = minOutput;
+            m_maxOutput[idx] = maxOutput;
+        }
+        else
+        {
+            TErr(("Invalid controller index %d.", idx));
+        }
+
+        TExit();
+        return;
+    }   //SetOutputRange
+
+    /**
+     * This function sets the PID controller setpoint.
+     *
+     * @param idx Specifies the controller index.
+     * @param setPoint Specifies the target setpoint.
+     * @param currInput Specifies the current input value.
+     */
+    void
+    SetTarget(
+        __in int   idx,
+        __in float setPoint,
+        __in float currInput
+        )
+    {
+        TLevel(API);
+        TEnterMsg(("idx=%d,setpt=%f,currInput=%f", idx, setPoint, currInput));
+
+        if ((idx >= 0) && (idx < m_numCtrls))
+        {
+            if (!(m_pidCtrlOptions[idx] & PIDCTRLO_ABS_SETPT))
+            {
+                setPoint += currInput;
+            }
+
+            if (m_maxInput[idx] > m_minInput[idx])
+            {
+                setPoint = BOUND(setPoint, m_minInput[idx], m_maxInput[idx]);
+            }
+            m_setPoint[idx] = setPoint;
+            m_prevError[idx] = setPoint - currInput;
+            m_totalError[idx] = 0.0;
+            m_startSettling[idx] = GetMsecTime();
+        }
+        else
+        {
+            TErr(("Invalid controller index %d.", idx));
+        }
+
+        TExit();
+        return;
+    }   //SetTarget
+
+    /**
+     * This function gets the PID controller setpoint.
+     *
+     * @param idx Specifies the controller index.
+     *
+     * @return the current setpoint.
+     */
+    float
+    GetTarget(
+        __in int idx
+        )
+    {
+        float value = 0.0;
+
+        TLevel(API);
+        TEnterMsg(("idx=%d", idx));
+
+        if ((idx >= 0) && (idx < m_numCtrls))
+        {
+            value = m_setPoint[idx];
+        }
+        else
+        {
+            TErr(("Invalid controller index %d.", idx));
+        }
+
+        TExitMsg(("=%f", value));
+        return value;
+    }   //GetTarget
+
+    /**
+     * This function gets the last error.
+     *
+     * @param idx Specifies the controller index.
+     *
+     * @return the last error.
+     */
+    float
+    GetError(
+        __in int idx
+        )
+    {
+        float value = 0.0;
+
+        TLevel(API);
+        TEnterMsg(("idx=%d", idx));
+
+        if ((idx >= 0) && (idx < m_numCtrls))
+        {
+            value = m_prevError[idx];
+        }
+        else
+        {
+            TErr(("Invalid controller index %d.", idx));
+        }
+
+        TExitMsg(("=%f", value));
+        return value;
+    }   //GetError
+
+    /**
+     * This function gets the last calculated output.
+     *
+     * @param idx Specifies the controller index.
+     *
+     * @return the last output.
+     */
+    float
+    GetOutput(
+        __in int idx
+        )
+    {
+        float value = 0.0;
+
+        TLevel(API);
+        TEnterMsg(("idx=%d", idx));
+
+        if ((idx >= 0) && (idx < m_numCtrls))
+        {
+            value = m_output[idx];
+        }
+        else
+        {
+            TErr(("Invalid controller index %d.", idx));
+        }
+
+        TExitMsg(("=%f", value));
+        return value;
+    }   //GetOutput
+
+    /**
+     * This function determines if a controller is on target by checking if
+     * the previous error is within target tolerance.
+     *
+     * @param idx Specifies the controller index.
+     *
+     * @return True if we are on target, false otherwise.
+     */
+    bool
+    OnTarget(
+        __in int idx
+        )
+    {
+        bool fOnTarget = false;
+
+        TLevel(API);
+        TEnterMsg(("idx=%d", idx));
+
+        if ((idx < 0) || (idx >= m_numCtrls))
+        {
+            TErr(("Invalid controller index %d.", idx));
+        }
+        else if (fabs(m_prevError[idx]) > m_tolerance[idx])
+        {
+            m_startSettling[idx] = GetMsecTime();
+        }
+        else if (GetMsecTime() - m_startSettling[idx] >= m_settlingTime[idx])
+        {
+            fOnTarget = true;
+        }
+
+        TExitMsg(("=%x", fOnTarget));
+        return fOnTarget;
+    }   //OnTarget
+
+    /**
+     * This function calculates the outputs of all the controllers in the
+     * bank in one pass.
+     *
+     * @param inputs Specifies the current input of each controller, indexed
+     *        by controller index.
+     * @param outputs Points to the array to receive the output of each
+     *        controller. It can be NULL if the outputs are read with
+     *        GetOutput.
+     */
+    void
+    CalcPIDOutputs(
+        __in  const float *inputs,
+        __out float       *outputs = NULL
+        )
+    {
+        TLevel(HIFREQ);
+        TEnterMsg(("inputs=%p,outputs=%p", inputs, outputs));
+
+        for (int i = 0; i < m_numCtrls; i++)
+        {
+            CalcOutput(i, inputs[i]);
+        }
+
+        if (outputs != NULL)
+        {
+            for (int i = 0; i < m_numCtrls; i++)
+            {
+                outputs[i] = m_output[i];
+            }
+        }
+
+        TExit();
+        return;
+    }   //CalcPIDOutputs
+
+    /**
+     * This function calculates the output of a single controller in the
+     * bank.
+     *
+     * @param idx Specifies the controller index.
+     * @param currInput Specifies the current input value.
+     *
+     * @return Returns the PID output.
+     */
+    float
+    CalcPIDOutput(
+        __in int   idx,
+        __in float currInput
+        )
+    {
+        float output = 0.0;
+
+        TLevel(API);
+        TEnterMsg(("idx=%d,currInput=%f", idx, currInput));
+
+        if ((idx >= 0) && (idx < m_numCtrls))
+        {
+            CalcOutput(idx, currInput);
+            output = m_output[idx];
+        }
+        else
+        {
+            TErr(("Invalid controller index %d.", idx));
+        }
+
+        TExitMsg(("=%f", output));
+        return output;
+    }   //CalcPIDOutput
+};  //class TrcPIDBank
+
+#endif  //ifndef _TRCPIDBANK_H
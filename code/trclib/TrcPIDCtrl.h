@@ -30,6 +30,13 @@
 //
 #define PIDCTRLO_INVERSE        0x00000001
 #define PIDCTRLO_ABS_SETPT      0x00000002
+#define PIDCTRLO_TIME_AWARE     0x00000004
+
+//
+// In time aware mode, a period longer than this (e.g. the first call after
+// being disabled) is not used for the integral and derivative terms.
+//
+#define PIDCTRL_MAX_PERIOD      0.5     //in seconds
 
 class TrcPIDCtrl;
 
@@ -87,6 +94,92 @@ private:
     double    m_totalError;
     UINT32    m_startSettling;
     float     m_setPoint;
+    float     m_output;
+    //
+    // Time aware mode.
+    //
+    float     m_Kv;
+    float     m_Ka;
+    float     m_derivTimeConst;
+    float     m_rampRate;
+    float     m_currSetPoint;
+    float     m_refVelocity;
+    float     m_refAccel;
+    float     m_prevInput;
+    float     m_filteredDeriv;
+    UINT32    m_prevTime;
+
+    /**
+     * This function calculates the PID output in time aware mode. The
+     * integral and derivative terms use the measured period, the derivative
+     * is taken on the filtered input rather than the error so setpoint
+     * changes do not kick the output, the setpoint can be ramped and the
+     * reference velocity and acceleration are fed forward.
+     *
+     * @param currInput Specifies the current input value.
+     *
+     * @return Returns the PID output before limiting.
+     */
+    float
+    CalcTimeAwareOutput(
+        __in float currInput
+        )
+    {
+        float output;
+        float error;
+        float sign = (m_pidCtrlOptions & PIDCTRLO_INVERSE)? -1.0: 1.0;
+        UINT32 timeCurr = GetFPGATime();
+        float period = (float)(timeCurr - m_prevTime)/1000000.0;
+
+        TLevel(FUNC);
+        TEnterMsg(("currInput=%f", currInput));
+
+        if ((m_prevTime == 0) || (period > PIDCTRL_MAX_PERIOD))
+        {
+            period = 0.0;
+        }
+        m_prevTime = timeCurr;
+
+        if ((m_rampRate > 0.0) && (period > 0.0))
+        {
+            float prevSetPoint = m_currSetPoint;
+            float prevVelocity = m_refVelocity;
+            float step = m_rampRate*period;
+
+            m_currSetPoint = BOUND(m_setPoint,
+                                   m_currSetPoint - step,
+                                   m_currSetPoint + step);
+            m_refVelocity = (m_currSetPoint - prevSetPoint)/period;
+            m_refAccel = (m_refVelocity - prevVelocity)/period;
+        }
+        else if (m_rampRate > 0.0)
+        {
+            m_refVelocity = 0.0;
+            m_refAccel = 0.0;
+        }
+
+        error = sign*(m_currSetPoint - currInput);
+        if (period > 0.0)
+        {
+            float adjTotalError = m_Ki*(m_totalError + error*period);
+            if ((adjTotalError > m_minOutput) && (adjTotalError < m_maxOutput))
+            {
+                m_totalError += error*period;
+            }
+
+            float rawDeriv = -sign*(currInput - m_prevInput)/period;
+            m_filteredDeriv += (rawDeriv - m_filteredDeriv)*
+                               period/(m_derivTimeConst + period);
+        }
+        m_prevInput = currInput;
+
+        output = m_Kp*error + m_Ki*m_totalError + m_Kd*m_filteredDeriv +
+                 sign*(m_Kv*m_refVelocity + m_Ka*m_refAccel);
+        m_prevError = error;
+
+        TExitMsg(("=%f", output));
+        return output;
+    }   //CalcTimeAwareOutput
 
 public:
     /**
@@ -126,6 +219,18 @@ public:
         m_totalError = 0.0;
         m_startSettling = 0;
         m_setPoint = 0.0;
+        m_output = 0.0;
+
+        m_Kv = 0.0;
+        m_Ka = 0.0;
+        m_derivTimeConst = 0.0;
+        m_rampRate = 0.0;
+        m_currSetPoint = 0.0;
+        m_refVelocity = 0.0;
+        m_refAccel = 0.0;
+        m_prevInput = 0.0;
+        m_filteredDeriv = 0.0;
+        m_prevTime = 0;
 
         TExit();
     }   //TrcPIDCtrl
@@ -155,6 +260,9 @@ public:
 
         m_prevError = 0.0;
         m_totalError = 0.0;
+        m_output = 0.0;
+        m_filteredDeriv = 0.0;
+        m_prevTime = 0;
 
         TExit();
         return;
@@ -269,6 +377,99 @@ public:
         return;
     }   //SetPID
 
+    /**
+     * This function sets the feed-forward constants used in time aware
+     * mode. The feed-forward terms are Kv times the reference velocity plus
+     * Ka times the reference acceleration. The reference comes from the
+     * setpoint ramp, or from SetReference if there is no ramp.
+     *
+     * @param Kv Specifies the velocity feed-forward constant.
+     * @param Ka Specifies the acceleration feed-forward constant.
+     */
+    void
+    SetFeedForward(
+        __in float Kv,
+        __in float Ka
+        )
+    {
+        TLevel(API);
+        TEnterMsg(("Kv=%f,Ka=%f", Kv, Ka));
+
+        m_Kv = Kv;
+        m_Ka = Ka;
+
+        TExit();
+        return;
+    }   //SetFeedForward
+
+    /**
+     * This function sets the time constant of the low pass filter applied
+     * to the derivative term in time aware mode. The derivative is
+     * calculated on the input, so noisy sensors may need a time constant
+     * of a few loop periods.
+     *
+     * @param timeConst Specifies the filter time constant in seconds. Zero
+     *        disables the filter.
+     */
+    void
+    SetDerivativeFilter(
+        __in float timeConst
+        )
+    {
+        TLevel(API);
+        TEnterMsg(("timeConst=%f", timeConst));
+
+        m_derivTimeConst = timeConst;
+
+        TExit();
+        return;
+    }   //SetDerivativeFilter
+
+    /**
+     * This function sets the maximum rate the setpoint is moved towards a
+     * new target in time aware mode.
+     *
+     * @param rampRate Specifies the ramp rate in input units per second.
+     *        Zero means the setpoint changes immediately.
+     */
+    void
+    SetSetPointRamp(
+        __in float rampRate
+        )
+    {
+        TLevel(API);
+        TEnterMsg(("rampRate=%f", rampRate));
+
+        m_rampRate = rampRate;
+
+        TExit();
+        return;
+    }   //SetSetPointRamp
+
+    /**
+     * This function sets the reference velocity and acceleration used for
+     * feed-forward in time aware mode when there is no setpoint ramp, e.g.
+     * from a motion profile that updates the target every period.
+     *
+     * @param velocity Specifies the reference velocity.
+     * @param accel Specifies the reference acceleration.
+     */
+    void
+    SetReference(
+        __in float velocity,
+        __in float accel = 0.0
+        )
+    {
+        TLevel(API);
+        TEnterMsg(("velocity=%f,accel=%f", velocity, accel));
+
+        m_refVelocity = velocity;
+        m_refAccel = accel;
+
+        TExit();
+        return;
+    }   //SetReference
+
     /**
      * This function gets the last error.
      *
@@ -285,6 +486,22 @@ public:
         return m_prevError;
     }   //GetError
 
+    /**
+     * This function gets the last calculated output.
+     *
+     * @return the last output.
+     */
+    float
+    GetOutput(
+        void
+        )
+    {
+        TLevel(API);
+        TEnter();
+        TExitMsg(("=%f", m_output));
+        return m_output;
+    }   //GetOutput
+
     /**
      * This function gets the PID controller setpoint.
      *
@@ -343,11 +560,59 @@ public:
         m_prevError = m_setPoint - currInput;
         m_totalError = 0.0;
         m_startSettling = GetMsecTime();
+        if ((m_pidCtrlOptions & PIDCTRLO_TIME_AWARE) && (m_rampRate > 0.0))
+        {
+            m_currSetPoint = currInput;
+            m_refVelocity = 0.0;
+            m_refAccel = 0.0;
+        }
+        else
+        {
+            m_currSetPoint = m_setPoint;
+        }
+        m_prevInput = currInput;
+
+        if (m_prevTime == 0)
+        {
+            m_filteredDeriv = 0.0;
+        }
 
         TExit();
         return;
     }   //SetTarget
 
+    /**
+     * This function moves the setpoint without resetting the controller.
+     * It is used to follow a trajectory such as a motion profile, where the
+     * setpoint changes every period.
+     *
+     * @param setPoint Specifies the new absolute setpoint.
+     * @param velocity Specifies the reference velocity for feed-forward.
+     * @param accel Specifies the reference acceleration for feed-forward.
+     */
+    void
+    UpdateTarget(
+        __in float setPoint,
+        __in float velocity = 0.0,
+        __in float accel = 0.0
+        )
+    {
+        TLevel(API);
+        TEnterMsg(("setpt=%f,velocity=%f,accel=%f", setPoint, velocity, accel));
+
+        if (m_maxInput > m_minInput)
+        {
+            setPoint = BOUND(setPoint, m_minInput, m_maxInput);
+        }
+        m_setPoint = setPoint;
+        m_currSetPoint = setPoint;
+        m_refVelocity = velocity;
+        m_refAccel = accel;
+
+        TExit();
+        return;
+    }   //UpdateTarget
+
     /**
      * This function determines if we are on target by checking if the
      * previous error is within target tolerance.
@@ -364,7 +629,8 @@ public:
         TLevel(API);
         TEnter();
 
-        if (fabs(m_prevError) > m_tolerance)
+        if ((fabs(m_prevError) > m_tolerance) ||
+            (m_currSetPoint != m_setPoint))
         {
             m_startSettling = GetMsecTime();
         }
@@ -424,7 +690,9 @@ public:
 
     /**
      * This function returns the calculated PID output according to the input
-     * value from the input source.
+     * value from the input source. In time aware mode (PIDCTRLO_TIME_AWARE),
+     * Ki is per second and Kd is per 1/second since the terms are scaled by
+     * the measured period.
      *
      * @param currInput Specifies the current input value.
      *
@@ -442,20 +710,29 @@ public:
         TLevel(API);
         TEnterMsg(("currInput=%f", currInput));
 
-        error = m_setPoint - currInput;
-        if (m_pidCtrlOptions & PIDCTRLO_INVERSE)
+        if (m_pidCtrlOptions & PIDCTRLO_TIME_AWARE)
         {
-            error = -error;
+            output = CalcTimeAwareOutput(currInput);
         }
-
-        adjTotalError = m_Ki*(m_totalError + error);
-        if ((adjTotalError > m_minOutput) && (adjTotalError < m_maxOutput))
+        else
         {
-            m_totalError += error;
-        }
+            error = m_setPoint - currInput;
+            if (m_pidCtrlOptions & PIDCTRLO_INVERSE)
+            {
+                error = -error;
+            }
 
-        output = m_Kp*error + m_Ki*m_totalError + m_Kd*(error - m_prevError);
-        m_prevError = error;
+            adjTotalError = m_Ki*(m_totalError + error);
+            if ((adjTotalError > m_minOutput) &&
+                (adjTotalError < m_maxOutput))
+            {
+                m_totalError += error;
+            }
+
+            output = m_Kp*error + m_Ki*m_totalError +
+                     m_Kd*(error - m_prevError);
+            m_prevError = error;
+        }
 
         if (output < m_minOutput)
         {
@@ -465,6 +742,7 @@ public:
         {
             output = m_maxOutput;
         }
+        m_output = output;
 
         TExitMsg(("=%f", output));
         return output;
@@ -46,6 +46,8 @@ private:
     #define PIDDRIVEF_PIDDRIVE_ON       0x00000001
     #define PIDDRIVEF_STOP_ONTARGET     0x00000002
     #define PIDDRIVEF_TURN_ONLY         0x00000004
+    #define PIDDRIVEF_DRIVE_PROFILE     0x00000008
+    #define PIDDRIVEF_TURN_PROFILE      0x00000010
 
     RobotDrive *m_drive;
     TrcPIDCtrl *m_pidCtrlDrive;
@@ -55,6 +57,46 @@ private:
     UINT32      m_pidDriveFlags;
     Event      *m_notifyEvent;
     UINT32      m_expiredTime;
+    TrcMotionProfile *m_driveProfile;
+    TrcMotionProfile *m_turnProfile;
+    float       m_driveStart;
+    float       m_turnStart;
+
+    /**
+     * This function advances the active motion profiles and moves the PID
+     * controller setpoints along them.
+     */
+    void
+    FollowProfiles(
+        void
+        )
+    {
+        float pos, vel, accel;
+
+        TLevel(FUNC);
+        TEnter();
+
+        if (m_pidDriveFlags & PIDDRIVEF_DRIVE_PROFILE)
+        {
+            if (m_driveProfile->GetSetPoint(pos, vel, accel))
+            {
+                m_pidDriveFlags &= ~PIDDRIVEF_DRIVE_PROFILE;
+            }
+            m_pidCtrlDrive->UpdateTarget(m_driveStart + pos, vel, accel);
+        }
+
+        if (m_pidDriveFlags & PIDDRIVEF_TURN_PROFILE)
+        {
+            if (m_turnProfile->GetSetPoint(pos, vel, accel))
+            {
+                m_pidDriveFlags &= ~PIDDRIVEF_TURN_PROFILE;
+            }
+            m_pidCtrlTurn->UpdateTarget(m_turnStart + pos, vel, accel);
+        }
+
+        TExit();
+        return;
+    }   //FollowProfiles
 
 public:
     /**
@@ -81,7 +123,11 @@ public:
            m_pidDriveOptions(pidDriveOptions),
            m_pidDriveFlags(0),
            m_notifyEvent(NULL),
-           m_expiredTime(0)
+           m_expiredTime(0),
+           m_driveProfile(NULL),
+           m_turnProfile(NULL),
+           m_driveStart(0.0),
+           m_turnStart(0.0)
     {
         TLevel(INIT);
         TEnterMsg(("drive=%p,pidCtrlDrive=%p,pidCtrlTurn=%p,pidInput=%p,options=%x",
@@ -129,6 +175,45 @@ public:
         return;
     }   //Reset
 
+    /**
+     * This function sets the motion profiles used to reach the drive and
+     * turn targets. With a profile, the setpoint follows the profile from
+     * the current position to the target instead of jumping to the target,
+     * so the drive does not saturate and overshoot. The PID controllers
+     * should be in time aware mode to make use of the profile velocity and
+     * acceleration as feed-forward. A profile without a positive maximum
+     * acceleration is rejected.
+     *
+     * @param driveProfile Points to the drive profile, NULL for none.
+     * @param turnProfile Points to the turn profile, NULL for none.
+     */
+    void
+    SetMotionProfiles(
+        __in TrcMotionProfile *driveProfile,
+        __in TrcMotionProfile *turnProfile
+        )
+    {
+        TLevel(API);
+        TEnterMsg(("driveProfile=%p,turnProfile=%p",
+                   driveProfile, turnProfile));
+
+        if ((driveProfile != NULL) && (driveProfile->GetMaxAccel() <= 0.0))
+        {
+            TErr(("Drive profile has no acceleration limit."));
+            driveProfile = NULL;
+        }
+        if ((turnProfile != NULL) && (turnProfile->GetMaxAccel() <= 0.0))
+        {
+            TErr(("Turn profile has no acceleration limit."));
+            turnProfile = NULL;
+        }
+        m_driveProfile = driveProfile;
+        m_turnProfile = turnProfile;
+
+        TExit();
+        return;
+    }   //SetMotionProfiles
+
     /**
      * This function sets PID drive target with the given drive distance and
      * turn angle setpoints.
@@ -156,14 +241,33 @@ public:
         TEnterMsg(("distSetPt=%f,angleSetPt=%f,fStopOnTarget=%x,event=%p,timeout=%d",
                    distSetPoint, angleSetPoint, fStopOnTarget, notifyEvent, timeout));
 
-        m_pidCtrlDrive->SetTarget(distSetPoint,
-                                  m_pidInput->GetInput(m_pidCtrlDrive));
-        m_pidCtrlTurn->SetTarget(angleSetPoint,
-                                 m_pidInput->GetInput(m_pidCtrlTurn));
+        m_driveStart = m_pidInput->GetInput(m_pidCtrlDrive);
+        m_turnStart = m_pidInput->GetInput(m_pidCtrlTurn);
+        m_pidCtrlDrive->SetTarget(distSetPoint, m_driveStart);
+        m_pidCtrlTurn->SetTarget(angleSetPoint, m_turnStart);
         m_notifyEvent = notifyEvent;
         m_expiredTime = (timeout != 0)? GetMsecTime() + timeout: 0;
 
         m_pidDriveFlags = PIDDRIVEF_PIDDRIVE_ON;
+        //
+        // Gate on the actual travel, with an absolute setpoint zero is a
+        // real target.
+        //
+        if ((m_driveProfile != NULL) &&
+            (m_pidCtrlDrive->GetTarget() - m_driveStart != 0.0))
+        {
+            m_driveProfile->Start(m_pidCtrlDrive->GetTarget() - m_driveStart);
+            m_pidCtrlDrive->UpdateTarget(m_driveStart);
+            m_pidDriveFlags |= PIDDRIVEF_DRIVE_PROFILE;
+        }
+
+        if ((m_turnProfile != NULL) &&
+            (m_pidCtrlTurn->GetTarget() - m_turnStart != 0.0))
+        {
+            m_turnProfile->Start(m_pidCtrlTurn->GetTarget() - m_turnStart);
+            m_pidCtrlTurn->UpdateTarget(m_turnStart);
+            m_pidDriveFlags |= PIDDRIVEF_TURN_PROFILE;
+        }
         if (fStopOnTarget)
         {
             m_pidDriveFlags |= PIDDRIVEF_STOP_ONTARGET;
@@ -196,7 +300,10 @@ public:
 
         if (m_pidDriveFlags & PIDDRIVEF_PIDDRIVE_ON)
         {
-            if (m_pidCtrlTurn->OnTarget() &&
+            FollowProfiles();
+            if (!(m_pidDriveFlags &
+                  (PIDDRIVEF_DRIVE_PROFILE | PIDDRIVEF_TURN_PROFILE)) &&
+                m_pidCtrlTurn->OnTarget() &&
                 ((m_pidDriveFlags & PIDDRIVEF_TURN_ONLY) ||
                  m_pidCtrlDrive->OnTarget()) ||
                 (m_expiredTime != 0) && (GetMsecTime() >= m_expiredTime))
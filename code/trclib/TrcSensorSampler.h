@@ -0,0 +1,451 @@
+#if 0
+/// Copyright (c) Titan Robotics Club. All rights reserved.
+///
+/// <module name="TrcSensorSampler.h" />
+///
+/// <summary>
+///     This module contains the definition and implementation of the
+///     SampledSensor, TrcSnapshot and SensorSampler classes.
+/// </summary>
+///
+/// <remarks>
+///     Environment: Wind River C++ for National Instrument cRIO based Robot.
+/// </remarks>
+#endif
+
+#ifndef _TRCSENSORSAMPLER_H
+#define _TRCSENSORSAMPLER_H
+
+#ifdef MOD_ID
+    #undef MOD_ID
+#endif
+#define MOD_ID                  MOD_SAMPLER
+#ifdef MOD_NAME
+    #undef MOD_NAME
+#endif
+#define MOD_NAME                "SensorSampler"
+
+//
+// Constants.
+//
+#define SAMPLER_MAX_SENSORS     16
+
+#ifndef SAMPLER_BASE_PERIOD
+    #define SAMPLER_BASE_PERIOD 0.005   //5ms
+#endif
+
+/**
+ * This abstract class defines the SampledSensor object. The object is a
+ * callback interface. It is not meant to be created as an object. Instead,
+ * it should be inherited by a subclass who needs to be sampled periodically
+ * by the SensorSampler.
+ */
+class SampledSensor
+{
+public:
+    /**
+     * This function is called by the SensorSampler to sample the sensor.
+     *
+     * @param timeCurr Specifies the FPGA time of the sampling pass in usec.
+     */
+    virtual
+    void
+    SampleSensor(
+        __in UINT32 timeCurr
+        ) = 0;
+};  //class SampledSensor
+
+/**
+ * This class defines and implements the TrcSnapshot object. It holds a
+ * value of type T that is written by a single task and read by any number
+ * of tasks without locking. The writer fills the buffer not being read and
+ * then publishes it by bumping the sequence number. A reader copies the
+ * published buffer and checks that the writer has not started to overwrite
+ * it in the meantime, otherwise it retries with the newly published
+ * buffer. A reader never waits for the writer to finish, so a high
+ * priority reader cannot get stuck behind a preempted writer.
+ */
+template<class T>
+class TrcSnapshot
+{
+private:
+    T               m_buffers[2];
+    volatile UINT32 m_seqPublished;
+    volatile UINT32 m_seqPending;
+
+public:
+    /**
+     * Constructor: Create an instance of the TrcSnapshot object.
+     */
+    TrcSnapshot(
+        void
+        ): m_seqPublished(0),
+           m_seqPending(0)
+    {
+    }   //TrcSnapshot
+
+    /**
+     * This function publishes a new value. It must only be called by one
+     * task.
+     *
+     * @param value Specifies the new value.
+     */
+    void
+    Write(
+        __in const T &value
+        )
+    {
+        UINT32 seq = m_seqPublished + 1;
+
+        m_seqPending = seq;
+        MEMORY_BARRIER();
+        m_buffers[seq & 1] = value;
+        MEMORY_BARRIER();
+        m_seqPublished = seq;
+    }   //Write
+
+    /**
+     * This function gets a consistent copy of the latest published value.
+     *
+     * @param value Receives the value.
+     */
+    void
+    Read(
+        __out T &value
+        ) const
+    {
+        UINT32 seq;
+
+        do
+        {
+            seq = m_seqPublished;
+            MEMORY_BARRIER();
+            value = m_buffers[seq & 1];
+            MEMORY_BARRIER();
+            //
+            // The buffer we copied is only overwritten by the write after
+            // the next one.
+            //
+        } while (m_seqPending - seq >= 2);
+    }   //Read
+
+    /**
+     * This function gets the number of values published so far.
+     *
+     * @return Returns the sequence number.
+     */
+    UINT32
+    GetSequence(
+        void
+        ) const
+    {
+        return m_seqPublished;
+    }   //GetSequence
+};  //class TrcSnapshot
+
+/**
+ * This class defines and implements the SensorSampler object. It is a
+ * singleton that owns one Notifier running at the base period and calls
+ * every registered sensor in one pass. Each sensor is sampled at a
+ * multiple of the base period. Registering and unregistering sensors is
+ * serialized by a semaphore, but the sampling pass does not take it: slots
+ * are published with memory barriers, so the pass itself is lock-free.
+ */
+class SensorSampler
+{
+private:
+    static SensorSampler   *m_instance;
+    Notifier               *m_notifier;
+    SEM_ID                  m_semaphore;
+    float                   m_basePeriod;
+    volatile int            m_numSensors;
+    SampledSensor * volatile m_sensors[SAMPLER_MAX_SENSORS];
+    UINT32                  m_dividers[SAMPLER_MAX_SENSORS];
+    UINT32                  m_tickCount;
+    volatile bool           m_fInPass;
+    bool                    m_fStarted;
+    TrcHistogram            m_passTimeHist;
+
+    /**
+     * Constructor: Create an instance of the SensorSampler object.
+     */
+    SensorSampler(
+        void
+        ): m_basePeriod(SAMPLER_BASE_PERIOD),
+           m_numSensors(0),
+           m_tickCount(0),
+           m_fInPass(false),
+           m_fStarted(false)
+    {
+        TLevel(INIT);
+        TEnter();
+
+        m_semaphore = semMCreate(SEM_Q_PRIORITY | SEM_DELETE_SAFE |
+                                 SEM_INVERSION_SAFE);
+        m_notifier = new Notifier(SensorSampler::CallSamplePass, this);
+        m_notifier->SetName(MOD_NAME);
+        for (int i = 0; i < SAMPLER_MAX_SENSORS; i++)
+        {
+            m_sensors[i] = NULL;
+            m_dividers[i] = 1;
+        }
+
+        TExit();
+    }   //SensorSampler
+
+    /**
+     * Destructor: Destroy an instance of the SensorSampler object.
+     */
+    ~SensorSampler(
+        void
+        )
+    {
+        TLevel(INIT);
+        TEnter();
+        SAFE_DELETE(m_notifier);
+        semDelete(m_semaphore);
+        TExit();
+    }   //~SensorSampler
+
+    /**
+     * This function samples all the sensors that are due in this tick.
+     */
+    void
+    SamplePass(
+        void
+        )
+    {
+        TLevel(HIFREQ);
+        TEnter();
+
+        UINT32 timeCurr = GetFPGATime();
+        int numSensors = m_numSensors;
+
+        m_fInPass = true;
+        MEMORY_BARRIER();
+        for (int i = 0; i < numSensors; i++)
+        {
+            SampledSensor *sensor = m_sensors[i];
+            if ((sensor != NULL) && (m_tickCount%m_dividers[i] == 0))
+            {
+                sensor->SampleSensor(timeCurr);
+            }
+        }
+        MEMORY_BARRIER();
+        m_fInPass = false;
+        m_tickCount++;
+        m_passTimeHist.Add(GetFPGATime() - timeCurr);
+
+        TExit();
+    }   //SamplePass
+
+    /**
+     * This function is called when the timer expired. It will call the
+     * non-static worker function.
+     *
+     * @param sampler Points to the SensorSampler object.
+     */
+    static
+    void
+    CallSamplePass(
+        __in void *sampler
+        )
+    {
+        TLevel(HIFREQ);
+        TEnterMsg(("sampler=%p", sampler));
+        ((SensorSampler *)sampler)->SamplePass();
+        TExit();
+    }   //CallSamplePass
+
+public:
+    /**
+     * This function returns the global instance of the sensor sampler.
+     * If there isn't one, it will create it.
+     *
+     * @return Returns the global instance of the sensor sampler.
+     */
+    static
+    SensorSampler *
+    GetInstance(
+        void
+        )
+    {
+        TLevel(API);
+        TEnter();
+
+        if (m_instance == NULL)
+        {
+            m_instance = new SensorSampler();
+        }
+
+        TExitMsg(("=%p", m_instance));
+        return m_instance;
+    }   //GetInstance
+
+    /**
+     * This function deletes the global instance of the sensor sampler.
+     */
+    static
+    void
+    DeleteInstance(
+        void
+        )
+    {
+        TLevel(API);
+        TEnter();
+        SAFE_DELETE(m_instance);
+        TExit();
+    }   //DeleteInstance
+
+    /**
+     * This function sets the base period. Sensor periods are rounded to a
+     * multiple of it. It must be called before any sensor is registered.
+     *
+     * @param period Specifies the base period in seconds.
+     */
+    void
+    SetBasePeriod(
+        __in float period
+        )
+    {
+        TLevel(API);
+        TEnterMsg(("period=%f", period));
+
+        CRITICAL_REGION(m_semaphore)
+        {
+            if (m_fStarted)
+            {
+                TWarn(("Base period cannot be changed after sampling "
+                       "started."));
+            }
+            else
+            {
+                m_basePeriod = period;
+            }
+        }
+        END_REGION;
+
+        TExit();
+    }   //SetBasePeriod
+
+    /**
+     * This function registers a sensor to be sampled. The sampling starts
+     * with the first registered sensor. The slot of an unregistered sensor
+     * is reused.
+     *
+     * @param sensor Points to the sensor.
+     * @param period Specifies the sampling period in seconds.
+     *
+     * @return Returns true if the sensor is registered, false if there are
+     *         too many sensors.
+     */
+    bool
+    RegisterSensor(
+        __in SampledSensor *sensor,
+        __in float          period
+        )
+    {
+        bool fSuccess = false;
+
+        TLevel(API);
+        TEnterMsg(("sensor=%p,period=%f", sensor, period));
+
+        CRITICAL_REGION(m_semaphore)
+        {
+            //
+            // Reuse the slot of an unregistered sensor before appending.
+            //
+            int idx = 0;
+            while ((idx < m_numSensors) && (m_sensors[idx] != NULL))
+            {
+                idx++;
+            }
+
+            if (idx < SAMPLER_MAX_SENSORS)
+            {
+                UINT32 divider = (UINT32)(period/m_basePeriod + 0.5);
+
+                m_dividers[idx] = (divider > 0)? divider: 1;
+                MEMORY_BARRIER();
+                m_sensors[idx] = sensor;
+                MEMORY_BARRIER();
+                if (idx == m_numSensors)
+                {
+                    m_numSensors = idx + 1;
+                }
+                fSuccess = true;
+
+                if (!m_fStarted)
+                {
+                    m_fStarted = true;
+                    m_notifier->StartPeriodic(m_basePeriod);
+                }
+            }
+            else
+            {
+                TErr(("Too many sensors."));
+            }
+        }
+        END_REGION;
+
+        TExitMsg(("=%d", fSuccess));
+        return fSuccess;
+    }   //RegisterSensor
+
+    /**
+     * This function unregisters a sensor. When it returns, the sensor is no
+     * longer being sampled and can be destroyed.
+     *
+     * @param sensor Points to the sensor.
+     */
+    void
+    UnregisterSensor(
+        __in SampledSensor *sensor
+        )
+    {
+        TLevel(API);
+        TEnterMsg(("sensor=%p", sensor));
+
+        CRITICAL_REGION(m_semaphore)
+        {
+            for (int i = 0; i < m_numSensors; i++)
+            {
+                if (m_sensors[i] == sensor)
+                {
+                    m_sensors[i] = NULL;
+                    break;
+                }
+            }
+        }
+        END_REGION;
+
+        MEMORY_BARRIER();
+        while (m_fInPass)
+        {
+            taskDelay(1);
+        }
+
+        TExit();
+    }   //UnregisterSensor
+
+    /**
+     * This function returns the histogram of the sampling pass execution
+     * time in usec.
+     *
+     * @return Returns the pass time histogram.
+     */
+    TrcHistogram *
+    GetPassTimeHist(
+        void
+        )
+    {
+        TLevel(API);
+        TEnter();
+        TExitMsg(("=%p", &m_passTimeHist));
+        return &m_passTimeHist;
+    }   //GetPassTimeHist
+};  //class SensorSampler
+
+SensorSampler *SensorSampler::m_instance = NULL;
+
+#endif  //ifndef _TRCSENSORSAMPLER_H
@@ -0,0 +1,613 @@
+#if 0
+/// Copyright (c) Titan Robotics Club. All rights reserved.
+///
+/// <module name="TrcStateMachine.h" />
+///
+/// <summary>
+///     This module contains the definition and implementation of the
+///     TrcStateMachine class.
+/// </summary>
+///
+/// <remarks>
+///     Environment: Wind River C++ for National Instrument cRIO based Robot.
+/// </remarks>
+#endif
+
+#ifndef _TRCSTATEMACHINE_H
+#define _TRCSTATEMACHINE_H
+
+#ifdef MOD_ID
+    #undef MOD_ID
+#endif
+#define MOD_ID                  MOD_TRCSM
+#ifdef MOD_NAME
+    #undef MOD_NAME
+#endif
+#define MOD_NAME                "TrcStateMachine"
+
+//
+// Constants.
+//
+#define SM_MAX_STATES           16
+#define SM_MAX_EVENTS           4
+#define SM_STATE_DONE           0xffffffff
+
+/**
+ * This is the entry action of a state. It is called with the context given
+ * to the state machine and the state being entered.
+ */
+typedef void (*SMEntryAction)(void *context, UINT32 state);
+
+/**
+ * This structure holds a state in the state table.
+ */
+typedef struct _SMState
+{
+    const char     *name;
+    SMEntryAction   entryAction;
+    Event          *events[SM_MAX_EVENTS];
+    UINT32          numEvents;
+    UINT32          flags;
+    UINT32          nextState;
+    double          timeout;
+    UINT32          timeoutState;
+    bool            fDefined;
+} SMState;
+
+/**
+ * This class defines and implements the TrcStateMachine object. The states
+ * are described in a table: each state has an entry action, the events it
+ * waits for, the state to go to when they are signaled and an optional
+ * timeout with its own next state. The awaited events wake the state machine
+ * through the EventListener interface, so the events are only looked at
+ * after one of them was signaled. The state machine is a subsystem, so any
+ * number of them run side by side under CoopMTRobot in the rate group they
+ * are registered in. The time spent in each state is recorded in a
+ * histogram.
+ */
+class TrcStateMachine: public SubSystem, public EventListener
+{
+private:
+    const char     *m_name;
+    void           *m_context;
+    SMState         m_states[SM_MAX_STATES];
+    TrcHistogram    m_dwellHist[SM_MAX_STATES];
+    TrcTimer        m_timer;
+    Event           m_timeoutEvent;
+    UINT32          m_currState;
+    UINT32          m_timeEntered;
+    volatile bool   m_fWake;
+    bool            m_fRunning;
+    bool            m_fEntered;
+
+    /**
+     * This function stops listening to the events of the current state and
+     * cancels its timeout.
+     */
+    void
+    DisarmState(
+        void
+        )
+    {
+        TLevel(FUNC);
+        TEnterMsg(("state=%d", m_currState));
+
+        SMState *state = &m_states[m_currState];
+
+        for (UINT32 i = 0; i < state->numEvents; i++)
+        {
+            state->events[i]->SetListener(NULL);
+        }
+        m_timer.CancelTimer();
+        m_timeoutEvent.SetListener(NULL);
+
+        TExit();
+    }   //DisarmState
+
+    /**
+     * This function enters a state. It listens to the events of the state,
+     * starts its timeout and then calls the entry action, so an operation
+     * started by the entry action cannot complete unnoticed.
+     *
+     * @param stateID Specifies the state to enter.
+     */
+    void
+    EnterState(
+        __in UINT32 stateID
+        )
+    {
+        TLevel(FUNC);
+        TEnterMsg(("state=%d", stateID));
+
+        SMState *state = &m_states[stateID];
+
+        m_currState = stateID;
+        m_timeEntered = GetFPGATime();
+        m_fEntered = true;
+        //
+        // Listen before clearing so a signal in between is not lost.
+        //
+        for (UINT32 i = 0; i < state->numEvents; i++)
+        {
+            state->events[i]->SetListener(this);
+            state->events[i]->ClearEvent();
+        }
+        if (state->timeout > 0.0)
+        {
+            m_timeoutEvent.SetListener(this);
+            m_timer.SetTimer(state->timeout, &m_timeoutEvent);
+        }
+        if (state->entryAction != NULL)
+        {
+            state->entryAction(m_context, stateID);
+        }
+        m_fWake = true;
+
+        TExit();
+    }   //EnterState
+
+    /**
+     * This function leaves the current state and enters the next one.
+     *
+     * @param nextState Specifies the next state, SM_STATE_DONE to stop.
+     */
+    void
+    Transition(
+        __in UINT32 nextState
+        )
+    {
+        TLevel(FUNC);
+        TEnterMsg(("state=%d,next=%d", m_currState, nextState));
+
+        DisarmState();
+        m_dwellHist[m_currState].Add(GetFPGATime() - m_timeEntered);
+        TInfo(("%s: %s -> %s",
+               m_name, m_states[m_currState].name,
+               (nextState == SM_STATE_DONE)? "Done":
+                                             m_states[nextState].name));
+        if ((nextState >= SM_MAX_STATES) || !m_states[nextState].fDefined)
+        {
+            if (nextState != SM_STATE_DONE)
+            {
+                TErr(("%s: undefined state %d.", m_name, nextState));
+            }
+            m_currState = SM_STATE_DONE;
+            m_fRunning = false;
+            m_fEntered = false;
+        }
+        else
+        {
+            EnterState(nextState);
+        }
+
+        TExit();
+    }   //Transition
+
+    /**
+     * This function checks if the current state is done waiting.
+     *
+     * @param nextState Receives the state to go to.
+     *
+     * @return Returns true if the state is done, false if it is still
+     *         waiting.
+     */
+    bool
+    CheckState(
+        __out UINT32 *nextState
+        )
+    {
+        TLevel(FUNC);
+        TEnterMsg(("state=%d", m_currState));
+
+        SMState *state = &m_states[m_currState];
+        bool fDone = true;
+        UINT32 cSignaledEvents = 0;
+
+        *nextState = m_currState;
+
+        for (UINT32 i = 0; i < state->numEvents; i++)
+        {
+            if (state->events[i]->IsSignaled())
+            {
+                cSignaledEvents++;
+            }
+        }
+
+        if ((state->numEvents == 0) && (state->timeout <= 0.0))
+        {
+            //
+            // An action only state moves on right away.
+            //
+            *nextState = state->nextState;
+        }
+        else if ((state->numEvents > 0) &&
+                 ((state->flags & SMF_WAIT_ALL)?
+                    cSignaledEvents == state->numEvents:
+                    cSignaledEvents > 0))
+        {
+            *nextState = state->nextState;
+        }
+        else if ((state->timeout > 0.0) && m_timeoutEvent.IsSignaled())
+        {
+            TWarn(("%s: %s timed out.", m_name, state->name));
+            *nextState = state->timeoutState;
+        }
+        else
+        {
+            fDone = false;
+        }
+
+        TExitMsg(("=%d,next=%d", fDone, *nextState));
+        return fDone;
+    }   //CheckState
+
+public:
+    /**
+     * Constructor: Create an instance of the TrcStateMachine object and
+     * register it as a subsystem.
+     *
+     * @param name Specifies the name of the state machine.
+     * @param context Specifies the context passed to the entry actions.
+     * @param subsysFlags Specifies the subsystem registration flags, e.g.
+     *        to run the state machine in a faster rate group.
+     */
+    TrcStateMachine(
+        __in const char *name,
+        __in void       *context,
+        __in UINT32      subsysFlags = SUBSYS_INPUT_TASKS
+        ): m_name(name),
+           m_context(context),
+           m_currState(SM_STATE_DONE),
+           m_timeEntered(0),
+           m_fWake(false),
+           m_fRunning(false),
+           m_fEntered(false)
+    {
+        TLevel(INIT);
+        TEnterMsg(("name=%s,context=%p,flags=%x",
+                   name, context, subsysFlags));
+
+        for (int i = 0; i < SM_MAX_STATES; i++)
+        {
+            m_states[i].name = NULL;
+            m_states[i].entryAction = NULL;
+            m_states[i].numEvents = 0;
+            m_states[i].flags = 0;
+            m_states[i].nextState = SM_STATE_DONE;
+            m_states[i].timeout = 0.0;
+            m_states[i].timeoutState = SM_STATE_DONE;
+            m_states[i].fDefined = false;
+        }
+        RegisterSubSystem(subsysFlags | SUBSYS_INPUT_TASKS);
+
+        TExit();
+    }   //TrcStateMachine
+
+    /**
+     * Destructor: Destroy an instance of the TrcStateMachine object.
+     */
+    ~TrcStateMachine(
+        void
+        )
+    {
+        TLevel(INIT);
+        TEnter();
+        StopSM();
+        UnregisterSubSystem();
+        TExit();
+    }   //~TrcStateMachine
+
+    /**
+     * This function adds a state to the state table.
+     *
+     * @param stateID Specifies the state, [0..SM_MAX_STATES).
+     * @param name Specifies the name of the state.
+     * @param entryAction Specifies the function to call when entering the
+     *        state, can be NULL.
+     * @param nextState Specifies the state to go to when the events of the
+     *        state are signaled, SM_STATE_DONE to stop.
+     * @param flags Specifies SMF_WAIT_ALL to wait for all the events instead
+     *        of any one of them.
+     *
+     * @return Returns true if successful, false otherwise.
+     */
+    bool
+    AddState(
+        __in UINT32         stateID,
+        __in const char    *name,
+        __in SMEntryAction  entryAction,
+        __in UINT32         nextState,
+        __in UINT32         flags = SMF_WAIT_ALL
+        )
+    {
+        bool rc = false;
+
+        TLevel(API);
+        TEnterMsg(("state=%d,name=%s,action=%p,next=%d,flags=%x",
+                   stateID, name, entryAction, nextState, flags));
+
+        if (stateID >= SM_MAX_STATES)
+        {
+            TErr(("Invalid state %d.", stateID));
+        }
+        else
+        {
+            SMState *state = &m_states[stateID];
+            state->name = name;
+            state->entryAction = entryAction;
+            state->numEvents = 0;
+            state->flags = flags;
+            state->nextState = nextState;
+            state->timeout = 0.0;
+            state->timeoutState = SM_STATE_DONE;
+            state->fDefined = true;
+            rc = true;
+        }
+
+        TExitMsg(("=%d", rc));
+        return rc;
+    }   //AddState
+
+    /**
+     * This function adds an event for a state to wait for. An event can only
+     * wake one state machine at a time.
+     *
+     * @param stateID Specifies the state.
+     * @param event Points to the event.
+     *
+     * @return Returns true if successful, false otherwise.
+     */
+    bool
+    AddStateEvent(
+        __in UINT32  stateID,
+        __in Event  *event
+        )
+    {
+        bool rc = false;
+
+        TLevel(API);
+        TEnterMsg(("state=%d,event=%p", stateID, event));
+
+        if ((stateID >= SM_MAX_STATES) || !m_states[stateID].fDefined)
+        {
+            TErr(("Invalid state %d.", stateID));
+        }
+        else if (m_states[stateID].numEvents >= SM_MAX_EVENTS)
+        {
+            TErr(("Too many events for state %d.", stateID));
+        }
+        else
+        {
+            SMState *state = &m_states[stateID];
+            state->events[state->numEvents] = event;
+            state->numEvents++;
+            rc = true;
+        }
+
+        TExitMsg(("=%d", rc));
+        return rc;
+    }   //AddStateEvent
+
+    /**
+     * This function sets the timeout of a state.
+     *
+     * @param stateID Specifies the state.
+     * @param timeout Specifies the timeout in seconds.
+     * @param timeoutState Specifies the state to go to on timeout,
+     *        SM_STATE_DONE to stop.
+     *
+     * @return Returns true if successful, false otherwise.
+     */
+    bool
+    SetStateTimeout(
+        __in UINT32 stateID,
+        __in double timeout,
+        __in UINT32 timeoutState
+        )
+    {
+        bool rc = false;
+
+        TLevel(API);
+        TEnterMsg(("state=%d,timeout=%f,timeoutState=%d",
+                   stateID, timeout, timeoutState));
+
+        if ((stateID >= SM_MAX_STATES) || !m_states[stateID].fDefined)
+        {
+            TErr(("Invalid state %d.", stateID));
+        }
+        else
+        {
+            m_states[stateID].timeout = timeout;
+            m_states[stateID].timeoutState = timeoutState;
+            rc = true;
+        }
+
+        TExitMsg(("=%d", rc));
+        return rc;
+    }   //SetStateTimeout
+
+    /**
+     * This function starts the state machine. The entry action of the
+     * initial state is called on the next pass.
+     *
+     * @param stateID Specifies the initial state.
+     */
+    void
+    StartSM(
+        __in UINT32 stateID = 0
+        )
+    {
+        TLevel(API);
+        TEnterMsg(("state=%d", stateID));
+
+        StopSM();
+        if ((stateID >= SM_MAX_STATES) || !m_states[stateID].fDefined)
+        {
+            TErr(("Invalid state %d.", stateID));
+        }
+        else
+        {
+            m_currState = stateID;
+            m_fRunning = true;
+            m_fWake = true;
+        }
+
+        TExit();
+    }   //StartSM
+
+    /**
+     * This function stops the state machine.
+     */
+    void
+    StopSM(
+        void
+        )
+    {
+        TLevel(API);
+        TEnter();
+
+        if (m_fRunning && m_fEntered)
+        {
+            DisarmState();
+        }
+        m_fRunning = false;
+        m_fEntered = false;
+        m_currState = SM_STATE_DONE;
+
+        TExit();
+    }   //StopSM
+
+    /**
+     * This function checks if the state machine is running.
+     *
+     * @return Returns true if the state machine is running, false otherwise.
+     */
+    bool
+    IsRunning(
+        void
+        )
+    {
+        TLevel(API);
+        TEnter();
+        TExitMsg(("=%d", m_fRunning));
+        return m_fRunning;
+    }   //IsRunning
+
+    /**
+     * This function gets the current state.
+     *
+     * @return Returns the current state, SM_STATE_DONE if stopped.
+     */
+    UINT32
+    GetCurrentState(
+        void
+        )
+    {
+        TLevel(API);
+        TEnter();
+        TExitMsg(("=%d", m_currState));
+        return m_currState;
+    }   //GetCurrentState
+
+    /**
+     * This function returns the histogram of the time spent in a state in
+     * usec.
+     *
+     * @param stateID Specifies the state.
+     *
+     * @return Returns the dwell time histogram, NULL if the state is
+     *         invalid.
+     */
+    TrcHistogram *
+    GetDwellTimeHist(
+        __in UINT32 stateID
+        )
+    {
+        TLevel(API);
+        TEnterMsg(("state=%d", stateID));
+        TrcHistogram *hist = (stateID < SM_MAX_STATES)? &m_dwellHist[stateID]:
+                                                        NULL;
+        TExitMsg(("=%p", hist));
+        return hist;
+    }   //GetDwellTimeHist
+
+    /**
+     * This function prints the dwell time statistics of all the states that
+     * have been visited.
+     */
+    void
+    DumpDwellStats(
+        void
+        )
+    {
+        TLevel(API);
+        TEnter();
+
+        printf("%s dwell times:\n", m_name);
+        for (int i = 0; i < SM_MAX_STATES; i++)
+        {
+            if (m_states[i].fDefined && (m_dwellHist[i].GetCount() > 0))
+            {
+                m_dwellHist[i].Dump(m_states[i].name);
+            }
+        }
+
+        TExit();
+    }   //DumpDwellStats
+
+    /**
+     * This function is called by an awaited event when it is signaled. It
+     * may be called from any task, so it only wakes the state machine.
+     *
+     * @param event Points to the signaled event.
+     */
+    void
+    EventSignaled(
+        __in Event *event
+        )
+    {
+        TLevel(CALLBK);
+        TEnterMsg(("event=%p", event));
+        m_fWake = true;
+        TExit();
+    }   //EventSignaled
+
+    /**
+     * This function is called by the subsystem manager. It runs the state
+     * machine if it has been woken up, following as many transitions as
+     * are ready.
+     *
+     * @param context Specifies the caller context.
+     */
+    void
+    InputTasks(
+        __in UINT32 context
+        )
+    {
+        TLevel(TASK);
+        TEnterMsg(("context=%d", context));
+
+        if (m_fRunning && !m_fEntered)
+        {
+            EnterState(m_currState);
+        }
+        //
+        // Bound the transitions per pass in case the table has a loop of
+        // action only states.
+        //
+        for (int i = 0; (i < SM_MAX_STATES) && m_fRunning && m_fWake; i++)
+        {
+            UINT32 nextState;
+
+            m_fWake = false;
+            if (CheckState(&nextState))
+            {
+                Transition(nextState);
+            }
+        }
+
+        TExit();
+    }   //InputTasks
+};  //class TrcStateMachine
+
+#endif  //ifndef _TRCSTATEMACHINE_H
@@ -4,8 +4,8 @@
 /// <module name="TrcTimer.h" />
 ///
 /// <summary>
-///     This module contains the definition and implementation of the TrcTimer
-///     class.
+///     This module contains the definition and implementation of the
+///     TrcTimerService and TrcTimer classes.
 /// </summary>
 ///
 /// <remarks>
@@ -25,59 +25,457 @@
 #endif
 #define MOD_NAME                "TrcTimer"
 
+//
+// Constants.
+//
+#ifndef TIMER_POOL_SIZE
+    #define TIMER_POOL_SIZE     1024
+#endif
+
+#ifndef TIMER_TICK_PERIOD
+    #define TIMER_TICK_PERIOD   0.005   //5ms
+#endif
+
+#define TIMER_WHEEL_SIZE        256     //must be a power of 2
+#define TIMER_INVALID           (-1)
+
 /**
- * This class defines the timer object. It allows the caller to set a timer
- * and notifies the caller when the timer expires.
+ * This structure holds a timer in the timer pool.
  */
-class TrcTimer
+typedef struct _TimerEntry
+{
+    Event  *notifyEvent;
+    UINT32  expireTick;
+    UINT32  periodTicks;
+    int     prev;
+    int     next;
+    bool    fAllocated;
+    bool    fActive;
+} TimerEntry;
+
+/**
+ * This class defines and implements the TrcTimerService object. It is a
+ * singleton that owns a preallocated pool of timers and one Notifier that
+ * ticks every TIMER_TICK_PERIOD. The active timers are kept in a hashed
+ * timing wheel: each timer is linked into the wheel slot of its expiration
+ * tick, so starting and canceling a timer is O(1) and each tick only looks
+ * at the timers in one slot. Nothing is allocated after the service is
+ * created.
+ */
+class TrcTimerService
 {
 private:
-    Event    *m_notifyEvent;
-    SEM_ID    m_semaphore;
-    Notifier *m_notifier;
+    static TrcTimerService *m_instance;
+    Notifier               *m_notifier;
+    SEM_ID                  m_semaphore;
+    TimerEntry              m_entries[TIMER_POOL_SIZE];
+    int                     m_wheel[TIMER_WHEEL_SIZE];
+    int                     m_freeHead;
+    UINT32                  m_currTick;
+    bool                    m_fStarted;
+
+    /**
+     * Constructor: Create an instance of the TrcTimerService object.
+     */
+    TrcTimerService(
+        void
+        ): m_freeHead(0),
+           m_currTick(0),
+           m_fStarted(false)
+    {
+        TLevel(INIT);
+        TEnter();
+
+        m_semaphore = semMCreate(SEM_Q_PRIORITY | SEM_DELETE_SAFE |
+                                 SEM_INVERSION_SAFE);
+        m_notifier = new Notifier(TrcTimerService::CallTick, this);
+        m_notifier->SetName(MOD_NAME);
+        for (int i = 0; i < TIMER_POOL_SIZE; i++)
+        {
+            m_entries[i].notifyEvent = NULL;
+            m_entries[i].fAllocated = false;
+            m_entries[i].fActive = false;
+            m_entries[i].prev = TIMER_INVALID;
+            m_entries[i].next = (i + 1 < TIMER_POOL_SIZE)? i + 1:
+                                                           TIMER_INVALID;
+        }
+        for (int i = 0; i < TIMER_WHEEL_SIZE; i++)
+        {
+            m_wheel[i] = TIMER_INVALID;
+        }
+
+        TExit();
+    }   //TrcTimerService
+
+    /**
+     * Destructor: Destroy an instance of the TrcTimerService object.
+     */
+    ~TrcTimerService(
+        void
+        )
+    {
+        TLevel(INIT);
+        TEnter();
+
+        SAFE_DELETE(m_notifier);
+        semDelete(m_semaphore);
+
+        TExit();
+    }   //~TrcTimerService
+
+    /**
+     * This function links a timer into the wheel slot of its expiration
+     * tick. The caller must hold the semaphore.
+     *
+     * @param handle Specifies the timer.
+     */
+    void
+    LinkTimer(
+        __in int handle
+        )
+    {
+        TLevel(FUNC);
+        TEnterMsg(("handle=%d", handle));
+
+        TimerEntry *entry = &m_entries[handle];
+        int slot = entry->expireTick & (TIMER_WHEEL_SIZE - 1);
+
+        entry->prev = TIMER_INVALID;
+        entry->next = m_wheel[slot];
+        if (entry->next != TIMER_INVALID)
+        {
+            m_entries[entry->next].prev = handle;
+        }
+        m_wheel[slot] = handle;
+        entry->fActive = true;
+
+        TExit();
+    }   //LinkTimer
+
+    /**
+     * This function unlinks a timer from its wheel slot. The caller must
+     * hold the semaphore.
+     *
+     * @param handle Specifies the timer.
+     */
+    void
+    UnlinkTimer(
+        __in int handle
+        )
+    {
+        TLevel(FUNC);
+        TEnterMsg(("handle=%d", handle));
+
+        TimerEntry *entry = &m_entries[handle];
+
+        if (entry->prev != TIMER_INVALID)
+        {
+            m_entries[entry->prev].next = entry->next;
+        }
+        else
+        {
+            m_wheel[entry->expireTick & (TIMER_WHEEL_SIZE - 1)] = entry->next;
+        }
+        if (entry->next != TIMER_INVALID)
+        {
+            m_entries[entry->next].prev = entry->prev;
+        }
+        entry->prev = TIMER_INVALID;
+        entry->next = TIMER_INVALID;
+        entry->fActive = false;
+
+        TExit();
+    }   //UnlinkTimer
 
     /**
-     * This function processes the expired timer and notfies the caller.
+     * This function advances the wheel by one tick and signals the timers
+     * that expired.
      */
     void
-    TimerExpired(
+    Tick(
         void
         )
     {
-        TLevel(EVENT);
+        TLevel(HIFREQ);
         TEnter();
 
         CRITICAL_REGION(m_semaphore)
         {
-            if (m_notifyEvent != NULL)
+            m_currTick++;
+            int handle = m_wheel[m_currTick & (TIMER_WHEEL_SIZE - 1)];
+            while (handle != TIMER_INVALID)
             {
-                m_notifyEvent->SetEvent();
-                m_notifyEvent = NULL;
+                TimerEntry *entry = &m_entries[handle];
+                int next = entry->next;
+                //
+                // Timers more than one revolution away share the slot.
+                //
+                if (entry->expireTick == m_currTick)
+                {
+                    UnlinkTimer(handle);
+                    if (entry->notifyEvent != NULL)
+                    {
+                        entry->notifyEvent->SetEvent();
+                    }
+                    if (entry->periodTicks > 0)
+                    {
+                        entry->expireTick += entry->periodTicks;
+                        LinkTimer(handle);
+                    }
+                }
+                handle = next;
             }
         }
         END_REGION;
 
         TExit();
-    }   //TimerExpired
+    }   //Tick
 
     /**
      * This function is called when the timer expired. It will call the
      * non-static worker function.
      *
-     * @param timer Points to the TrcTimer object to call the expiration
-     *        handler.
+     * @param service Points to the TrcTimerService object.
      */
     static
     void
-    CallTimerExpired(
-        __in void *timer
+    CallTick(
+        __in void *service
+        )
+    {
+        TLevel(HIFREQ);
+        TEnterMsg(("service=%p", service));
+        ((TrcTimerService *)service)->Tick();
+        TExit();
+    }   //CallTick
+
+public:
+    /**
+     * This function returns the global instance of the timer service.
+     * If there isn't one, it will create it.
+     *
+     * @return Returns the global instance of the timer service.
+     */
+    static
+    TrcTimerService *
+    GetInstance(
+        void
+        )
+    {
+        TLevel(API);
+        TEnter();
+
+        if (m_instance == NULL)
+        {
+            m_instance = new TrcTimerService();
+        }
+
+        TExitMsg(("=%p", m_instance));
+        return m_instance;
+    }   //GetInstance
+
+    /**
+     * This function deletes the global instance of the timer service.
+     */
+    static
+    void
+    DeleteInstance(
+        void
+        )
+    {
+        TLevel(API);
+        TEnter();
+        SAFE_DELETE(m_instance);
+        TExit();
+    }   //DeleteInstance
+
+    /**
+     * This function allocates a timer from the pool.
+     *
+     * @return Returns the timer handle, TIMER_INVALID if the pool is empty.
+     */
+    int
+    AllocTimer(
+        void
+        )
+    {
+        int handle = TIMER_INVALID;
+
+        TLevel(API);
+        TEnter();
+
+        CRITICAL_REGION(m_semaphore)
+        {
+            handle = m_freeHead;
+            if (handle != TIMER_INVALID)
+            {
+                m_freeHead = m_entries[handle].next;
+                m_entries[handle].next = TIMER_INVALID;
+                m_entries[handle].fAllocated = true;
+            }
+        }
+        END_REGION;
+
+        if (handle == TIMER_INVALID)
+        {
+            TErr(("Timer pool is empty."));
+        }
+
+        TExitMsg(("=%d", handle));
+        return handle;
+    }   //AllocTimer
+
+    /**
+     * This function cancels a timer and returns it to the pool.
+     *
+     * @param handle Specifies the timer.
+     */
+    void
+    FreeTimer(
+        __in int handle
         )
     {
-        TLevel(EVENT);
-        TEnterMsg(("timer=%p", timer));
-        ((TrcTimer *)timer)->TimerExpired();
+        TLevel(API);
+        TEnterMsg(("handle=%d", handle));
+
+        CRITICAL_REGION(m_semaphore)
+        {
+            TimerEntry *entry = &m_entries[handle];
+            if (entry->fActive)
+            {
+                UnlinkTimer(handle);
+            }
+            entry->notifyEvent = NULL;
+            entry->fAllocated = false;
+            entry->next = m_freeHead;
+            m_freeHead = handle;
+        }
+        END_REGION;
+
+        TExit();
+    }   //FreeTimer
+
+    /**
+     * This function starts a timer. A timer that is already running is
+     * restarted. The delay is rounded up to whole ticks plus one for the
+     * part of the current tick that has already passed, so a timer never
+     * expires early. The period is rounded to the nearest tick, at least
+     * one tick.
+     *
+     * @param handle Specifies the timer.
+     * @param delay Specifies the time in seconds until the timer expires.
+     * @param period Specifies the period in seconds to restart the timer
+     *        with after it expired, 0.0 for a one-shot timer.
+     * @param notifyEvent Points to the Event object to signal when the timer
+     *        expires, can be NULL.
+     */
+    void
+    StartTimer(
+        __in int    handle,
+        __in double delay,
+        __in double period,
+        __in Event *notifyEvent
+        )
+    {
+        TLevel(API);
+        TEnterMsg(("handle=%d,delay=%f,period=%f,event=%p",
+                   handle, delay, period, notifyEvent));
+
+        //
+        // The small bias keeps an exact multiple of the tick period from
+        // being rounded up a whole tick by floating point error.
+        //
+        UINT32 delayTicks = (delay > 0.0)?
+                            (UINT32)ceil(delay/TIMER_TICK_PERIOD - 1.0e-6) + 1:
+                            1;
+        UINT32 periodTicks = (UINT32)(period/TIMER_TICK_PERIOD + 0.5);
+
+        if ((period > 0.0) && (periodTicks == 0))
+        {
+            periodTicks = 1;
+        }
+
+        CRITICAL_REGION(m_semaphore)
+        {
+            TimerEntry *entry = &m_entries[handle];
+            if (entry->fActive)
+            {
+                UnlinkTimer(handle);
+            }
+            entry->notifyEvent = notifyEvent;
+            entry->expireTick = m_currTick + delayTicks;
+            entry->periodTicks = periodTicks;
+            LinkTimer(handle);
+
+            if (!m_fStarted)
+            {
+                m_fStarted = true;
+                m_notifier->StartPeriodic(TIMER_TICK_PERIOD);
+            }
+        }
+        END_REGION;
+
+        TExit();
+    }   //StartTimer
+
+    /**
+     * This function cancels a timer.
+     *
+     * @param handle Specifies the timer.
+     */
+    void
+    CancelTimer(
+        __in int handle
+        )
+    {
+        TLevel(API);
+        TEnterMsg(("handle=%d", handle));
+
+        CRITICAL_REGION(m_semaphore)
+        {
+            if (m_entries[handle].fActive)
+            {
+                UnlinkTimer(handle);
+            }
+        }
+        END_REGION;
+
         TExit();
-    }   //CallTimerExpired
+    }   //CancelTimer
+
+    /**
+     * This function checks if a timer is running.
+     *
+     * @param handle Specifies the timer.
+     *
+     * @return Returns true if the timer is running, false otherwise.
+     */
+    bool
+    IsTimerActive(
+        __in int handle
+        )
+    {
+        TLevel(API);
+        TEnterMsg(("handle=%d", handle));
+        bool fActive = m_entries[handle].fActive;
+        TExitMsg(("=%d", fActive));
+        return fActive;
+    }   //IsTimerActive
+};  //class TrcTimerService
+
+TrcTimerService *TrcTimerService::m_instance = NULL;
+
+/**
+ * This class defines the timer object. It allows the caller to set a timer
+ * and notifies the caller when the timer expires. A TrcTimer is a handle
+ * to a timer in the TrcTimerService pool, so it does not need a Notifier
+ * of its own.
+ */
+class TrcTimer
+{
+private:
+    TrcTimerService *m_service;
+    int              m_handle;
 
 public:
     /**
@@ -85,13 +483,13 @@ public:
      */
     TrcTimer(
         void
-        ): m_notifyEvent(NULL)
+        )
     {
         TLevel(INIT);
         TEnter();
 
-        m_semaphore = semBCreate(SEM_Q_PRIORITY, SEM_FULL);
-        m_notifier = new Notifier(TrcTimer::CallTimerExpired, this);
+        m_service = TrcTimerService::GetInstance();
+        m_handle = m_service->AllocTimer();
 
         TExit();
     }   //TrcTimer
@@ -106,8 +504,10 @@ public:
         TLevel(INIT);
         TEnter();
 
-        semFlush(m_semaphore);
-        SAFE_DELETE(m_notifier);
+        if (m_handle != TIMER_INVALID)
+        {
+            m_service->FreeTimer(m_handle);
+        }
 
         TExit();
     }   //~TrcTimer
@@ -132,25 +532,66 @@ public:
         TLevel(API);
         TEnterMsg(("delay=%f,event=%p", delay, notifyEvent));
 
-        CRITICAL_REGION(m_semaphore)
+        if (m_handle == TIMER_INVALID)
+        {
+            TErr(("No timer allocated."));
+            rc = false;
+        }
+        else if (m_service->IsTimerActive(m_handle))
         {
-            if (m_notifyEvent != NULL)
+            TErr(("There is already a pending timer."));
+            rc = false;
+        }
+        else
+        {
+            if (notifyEvent != NULL)
             {
-                TErr(("There is already a pending timer."));
-                rc = false;
+                notifyEvent->ClearEvent();
             }
-            else
+            m_service->StartTimer(m_handle, delay, 0.0, notifyEvent);
+        }
+
+        TExitMsg(("=%d", rc));
+        return rc;
+    }   //SetTimer
+
+    /**
+     * This function sets a timer that expires periodically until it is
+     * canceled. The event is signaled every period, the caller clears it.
+     *
+     * @param period Specifies the period in seconds.
+     * @param notifyEvent Points to the Event object to signal when the timer
+     *        expires.
+     *
+     * @return Returns true if success, false otherwise.
+     */
+    bool
+    SetPeriodicTimer(
+        __in double period,
+        __in Event *notifyEvent
+        )
+    {
+        bool rc = true;
+        TLevel(API);
+        TEnterMsg(("period=%f,event=%p", period, notifyEvent));
+
+        if (m_handle == TIMER_INVALID)
+        {
+            TErr(("No timer allocated."));
+            rc = false;
+        }
+        else
+        {
+            if (notifyEvent != NULL)
             {
-                m_notifyEvent = notifyEvent;
-		m_notifyEvent->ClearEvent();
-                m_notifier->StartSingle(delay);
+                notifyEvent->ClearEvent();
             }
+            m_service->StartTimer(m_handle, period, period, notifyEvent);
         }
-        END_REGION;
 
         TExitMsg(("=%d", rc));
         return rc;
-    }   //SetTimer
+    }   //SetPeriodicTimer
 
     /**
      * This function cancels a pending timer.
@@ -163,8 +604,10 @@ public:
         TLevel(API);
         TEnter();
 
-        m_notifier->Stop();
-        m_notifyEvent = NULL;
+        if (m_handle != TIMER_INVALID)
+        {
+            m_service->CancelTimer(m_handle);
+        }
 
         TExit();
     }   //CancelTimer
@@ -46,6 +46,13 @@
 
 #define GetMsecTime()           (GetFPGATime()/1000)
 
+//
+// Compiler barrier to keep the compiler from reordering memory accesses
+// across it. The cRIO has a single core so this is enough to order data
+// shared between tasks without a lock.
+//
+#define MEMORY_BARRIER()        __asm__ __volatile__("" ::: "memory")
+
 //
 // The BOUND macro limits the value (n) within the bounds between the given
 // low (l) and high (h).